@@ -135,6 +135,7 @@ set(include_files_list
     langinfo.h
     libio.h
     linux/falloc.h
+    linux/io_uring.h
     limits.h
     locale.h
     math.h
@@ -159,6 +160,7 @@ set(include_files_list
     string.h
     strings.h
     sys/dir.h
+    sys/epoll.h
     sys/file.h
     sys/ioctl.h
     sys/ipc.h
@@ -219,6 +221,7 @@ set(functions_list
     poll
     posix_fadvise
     pread pwrite
+    preadv pwritev
     pthread_cancel
     pthread_keycreate pthread_key_create
     pthread_mutexattr_setprotocol
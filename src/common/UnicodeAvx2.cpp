@@ -0,0 +1,148 @@
+/*
+ *	PROGRAM:	JRD International support
+ *	MODULE:		UnicodeAvx2.cpp
+ *	DESCRIPTION:	AVX2 fast paths of Unicode functions
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../common/UnicodeSimd.h"
+
+// Can be used only on x86 architectures
+// WARNING: With GCC must be compiled separately with -mavx2 flag.
+// Nothing here may be executed before the CPU is checked for AVX2 support.
+#if (defined(_M_IX86) || defined(_M_X64) || defined(__x86_64__) || defined(__i386__)) && \
+	(defined(__AVX2__) || defined(_MSC_VER))
+
+#include <immintrin.h>
+
+using namespace Jrd;
+
+namespace
+{
+	ULONG utf8AsciiLength(ULONG len, const UCHAR* str)
+	{
+		ULONG i = 0;
+
+		for (; len - i >= 32; i += 32)
+		{
+			const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+
+			if (_mm256_movemask_epi8(chunk))
+				break;
+		}
+
+		while (i < len && str[i] < 0x80)
+			++i;
+
+		return i;
+	}
+
+	ULONG utf8AsciiToUtf16(ULONG len, const UCHAR* src, USHORT* dst)
+	{
+		ULONG i = 0;
+
+		for (; len - i >= 32; i += 32)
+		{
+			const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+			if (_mm256_movemask_epi8(chunk))
+				break;
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+				_mm256_cvtepu8_epi16(_mm256_castsi256_si128(chunk)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 16),
+				_mm256_cvtepu8_epi16(_mm256_extracti128_si256(chunk, 1)));
+		}
+
+		for (; i < len && src[i] < 0x80; ++i)
+			dst[i] = src[i];
+
+		return i;
+	}
+
+	ULONG utf16AsciiToUtf8(ULONG len, const USHORT* src, UCHAR* dst)
+	{
+		const __m256i nonAscii = _mm256_set1_epi16((short) 0xFF80);
+		ULONG i = 0;
+
+		for (; len - i >= 32; i += 32)
+		{
+			const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16));
+
+			if (!_mm256_testz_si256(_mm256_or_si256(lo, hi), nonAscii))
+				break;
+
+			// Packing works inside of 128-bit lanes, restore the order of quadwords
+			const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+		}
+
+		for (; i < len && src[i] < 0x80; ++i)
+			dst[i] = (UCHAR) src[i];
+
+		return i;
+	}
+
+	ULONG utf16BmpLength(ULONG len, const USHORT* str)
+	{
+		const __m256i surrogateMask = _mm256_set1_epi16((short) 0xF800);
+		const __m256i surrogate = _mm256_set1_epi16((short) 0xD800);
+		ULONG i = 0;
+
+		for (; len - i >= 16; i += 16)
+		{
+			const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+			const __m256i found = _mm256_cmpeq_epi16(_mm256_and_si256(chunk, surrogateMask), surrogate);
+
+			if (_mm256_movemask_epi8(found))
+				break;
+		}
+
+		while (i < len && (str[i] & 0xF800) != 0xD800)
+			++i;
+
+		return i;
+	}
+
+	const UnicodeSimd avx2Functions =
+	{
+		utf8AsciiLength,
+		utf8AsciiToUtf16,
+		utf16AsciiToUtf8,
+		utf16BmpLength
+	};
+}
+
+namespace Jrd {
+
+extern const UnicodeSimd* const unicodeAvx2 = &avx2Functions;
+
+}	// namespace Jrd
+
+#else	// AVX2 support
+
+namespace Jrd {
+
+extern const UnicodeSimd* const unicodeAvx2 = NULL;
+
+}	// namespace Jrd
+
+#endif	// AVX2 support
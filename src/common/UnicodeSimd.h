@@ -0,0 +1,51 @@
+/*
+ *	PROGRAM:	JRD International support
+ *	MODULE:		UnicodeSimd.h
+ *	DESCRIPTION:	Vectorized fast paths of Unicode functions
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#ifndef COMMON_UNICODE_SIMD_H
+#define COMMON_UNICODE_SIMD_H
+
+namespace Jrd {
+
+// Fast paths for the runs of ASCII characters which are the most common
+// case of UTF8 data. Every function processes the leading run of the
+// string and returns its length in code units. The rest is left to the
+// generic code of UnicodeUtil.
+
+struct UnicodeSimd
+{
+	// Number of leading ASCII bytes
+	ULONG (*utf8AsciiLength)(ULONG len, const UCHAR* str);
+	// Copy leading ASCII bytes widening them to UTF-16
+	ULONG (*utf8AsciiToUtf16)(ULONG len, const UCHAR* src, USHORT* dst);
+	// Copy leading UTF-16 code units below 0x80 narrowing them to UTF-8
+	ULONG (*utf16AsciiToUtf8)(ULONG len, const USHORT* src, UCHAR* dst);
+	// Number of leading UTF-16 code units that are not surrogates
+	ULONG (*utf16BmpLength)(ULONG len, const USHORT* str);
+};
+
+// Defined in UnicodeAvx2.cpp. It's NULL if the file is built without AVX2 support,
+// otherwise the caller must check that CPU supports AVX2 before use.
+extern const UnicodeSimd* const unicodeAvx2;
+
+}	// namespace Jrd
+
+#endif	// COMMON_UNICODE_SIMD_H
@@ -1721,6 +1721,49 @@ private:
 };
 
 
+// Caches of small blocks for the pools used by many threads at once, such as
+// the default or database permanent pool. Thread takes small blocks from and
+// returns them to the cache picked by its identity, while the pool mutex is
+// taken once per batch of blocks moving between the cache and the pool.
+// Caches are created when the pool notices contention for its mutex.
+
+class SmallCaches
+{
+public:
+	static const unsigned CACHES = 16;				// number of caches per pool
+	static const unsigned BATCH = 8;				// blocks moved between cache and pool at once
+	static const unsigned LIMIT = BATCH * 4;		// max number of cached blocks of each size
+	static const int CONTENTION_LIMIT = 256;		// contended mutex entries before caches are created
+
+	class Cache
+	{
+	public:
+		Cache()
+		{
+			memset(blocks, 0, sizeof(blocks));
+			memset(counts, 0, sizeof(counts));
+		}
+
+		Mutex mutex;
+		MemBlock* blocks[LowLimits::TOTAL_ELEMENTS];
+		unsigned counts[LowLimits::TOTAL_ELEMENTS];
+	};
+
+	Cache& get()
+	{
+#ifdef WIN_NT
+		const FB_UINT64 id = GetCurrentThreadId();
+#else
+		const FB_UINT64 id = (FB_UINT64) pthread_self();
+#endif
+		return caches[((id * FB_CONST64(0x9E3779B97F4A7C15)) >> 32) % CACHES];
+	}
+
+private:
+	Cache caches[CACHES];
+};
+
+
 // Implementation of memory pool
 
 class MemPool
@@ -1745,6 +1788,8 @@ private:
 	MemBigHunk*		bigHunks;
 
 	Mutex			mutex;
+	std::atomic<SmallCaches*> smallCaches;
+	AtomicCounter	contentions;
 	int				blocksAllocated;
 	int				blocksActive;
 	bool			pool_destroying, parent_redirect;
@@ -1802,6 +1847,10 @@ private:
 	MemBlock* alloc(size_t from, size_t& length, bool flagRedirect);
 	void releaseBlock(MemBlock *block, bool flagDecr) noexcept;
 
+	void createCaches() noexcept;
+	MemBlock* allocateCached(SmallCaches* caches, size_t& length);
+	void releaseCached(SmallCaches* caches, MemBlock* block) noexcept;
+
 public:
 	void* allocate(size_t size ALLOC_PARAMS);
 	MemBlock* allocate2(size_t from, size_t& size ALLOC_PARAMS);
@@ -2092,6 +2141,7 @@ void MemPool::initialize()
 
 	bigHunks = NULL;
 	pool_destroying = false;
+	smallCaches = NULL;
 
 #ifdef MEM_DEBUG
 	next = child = NULL;
@@ -2128,6 +2178,14 @@ MemPool::~MemPool(void)
 	}
 #endif
 
+	// drop caches, cached blocks are released with the extents
+	SmallCaches* const caches = smallCaches.load();
+	if (caches)
+	{
+		caches->~SmallCaches();
+		releaseRaw(pool_destroying, caches, sizeof(SmallCaches), false);
+	}
+
 	// release big objects
 	while (bigHunks)
 	{
@@ -2237,8 +2295,24 @@ void MemoryPool::setStatsGroup(MemoryStats& newStats) noexcept
 
 MemBlock* MemPool::alloc(size_t from, size_t& length, bool flagRedirect)
 {
+	if (!from)
+	{
+		SmallCaches* const caches = smallCaches.load(std::memory_order_acquire);
+		if (caches && length + LinkedList::MEM_OVERHEAD <= LowLimits::TOP_LIMIT)
+			return allocateCached(caches, length);
+	}
+
 	MutexEnsureUnlock guard(mutex, "MemPool::alloc");
-	guard.enter();
+	if (!guard.tryEnter())
+	{
+		guard.enter();
+
+		if (!smallCaches.load(std::memory_order_relaxed) &&
+			++contentions == SmallCaches::CONTENTION_LIMIT)
+		{
+			createCaches();
+		}
+	}
 
 	// If this is a small block, look for it there
 
@@ -2419,6 +2493,16 @@ void MemPool::releaseBlock(MemBlock* block, bool decrUsage) noexcept
 	--blocksActive;
 	const size_t length = block->getSize();
 
+	SmallCaches* const caches = smallCaches.load(std::memory_order_acquire);
+	if (caches && length <= LowLimits::TOP_LIMIT)
+	{
+		if (decrUsage)
+			decrement_usage(length);
+
+		releaseCached(caches, block);
+		return;
+	}
+
 	MutexEnsureUnlock guard(mutex, "MemPool::releaseBlock");
 	guard.enter();
 
@@ -2464,6 +2548,69 @@ void MemPool::releaseBlock(MemBlock* block, bool decrUsage) noexcept
 	releaseRaw(pool_destroying, hunk, hunk->length, false);
 }
 
+void MemPool::createCaches() noexcept
+{
+#ifndef USE_VALGRIND
+	try
+	{
+		void* const memory = allocRaw(sizeof(SmallCaches));
+		smallCaches.store(new(memory) SmallCaches, std::memory_order_release);
+	}
+	catch (const Exception&)
+	{
+		// go on without caches
+	}
+#endif
+}
+
+MemBlock* MemPool::allocateCached(SmallCaches* caches, size_t& length)
+{
+	const unsigned slot = LowLimits::getSlot(length + LinkedList::MEM_OVERHEAD, SLOT_ALLOC);
+	const size_t size = LowLimits::getSize(slot) - LinkedList::MEM_OVERHEAD;
+
+	SmallCaches::Cache& cache = caches->get();
+	MutexLockGuard cacheGuard(cache.mutex, "MemPool::allocateCached");
+
+	if (!cache.counts[slot])
+	{
+		MutexLockGuard guard(mutex, "MemPool::allocateCached");
+
+		for (unsigned n = 0; n < SmallCaches::BATCH; n++)
+		{
+			size_t blockSize = size;
+			MemBlock* const block = smallObjects.allocateBlock(this, 0, blockSize);
+			fb_assert(blockSize == size);
+
+			LinkedList::putElement(&cache.blocks[slot], block);
+			cache.counts[slot]++;
+		}
+	}
+
+	cache.counts[slot]--;
+	length = size;
+	return LinkedList::getElement(&cache.blocks[slot]);
+}
+
+void MemPool::releaseCached(SmallCaches* caches, MemBlock* block) noexcept
+{
+	const unsigned slot = LowLimits::getSlot(block->getSize(), SLOT_ALLOC);
+
+	SmallCaches::Cache& cache = caches->get();
+	MutexLockGuard cacheGuard(cache.mutex, "MemPool::releaseCached");
+
+	LinkedList::putElement(&cache.blocks[slot], block);
+
+	if (++cache.counts[slot] > SmallCaches::LIMIT)
+	{
+		MutexLockGuard guard(mutex, "MemPool::releaseCached");
+
+		for (unsigned n = 0; n < SmallCaches::BATCH; n++)
+			smallObjects.deallocateBlock(LinkedList::getElement(&cache.blocks[slot]));
+
+		cache.counts[slot] -= SmallCaches::BATCH;
+	}
+}
+
 void MemPool::memoryIsExhausted(void)
 {
 	Firebird::BadAlloc::raise();
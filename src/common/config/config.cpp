@@ -410,6 +410,27 @@ void Config::checkValues()
 	checkIntForHiBound(KEY_TIP_CACHE_BLOCK_SIZE, MAX_ULONG, true);
 
 	checkIntForLoBound(KEY_INLINE_SORT_THRESHOLD, 0, true);
+
+	checkIntForLoBound(KEY_MAX_SORT_THREADS, 1, true);
+	checkIntForHiBound(KEY_MAX_SORT_THREADS, 64, true);
+
+	checkIntForLoBound(KEY_MAX_PARALLEL_WORKERS, 1, true);
+	checkIntForHiBound(KEY_MAX_PARALLEL_WORKERS, 64, true);
+
+	checkIntForLoBound(KEY_PARALLEL_WORKERS, 1, true);
+	checkIntForHiBound(KEY_PARALLEL_WORKERS, values[KEY_MAX_PARALLEL_WORKERS].intVal, false);
+
+	checkIntForLoBound(KEY_READ_AHEAD_PAGES, 0, true);
+	checkIntForHiBound(KEY_READ_AHEAD_PAGES, 1024, true);
+
+	checkIntForLoBound(KEY_MAX_INLINE_BLOB_SIZE, 0, true);
+	checkIntForHiBound(KEY_MAX_INLINE_BLOB_SIZE, MAX_USHORT, true);
+
+	checkIntForLoBound(KEY_MAX_BLOB_CACHE_SIZE, 0, true);
+	checkIntForHiBound(KEY_MAX_BLOB_CACHE_SIZE, MAX_ULONG, true);
+
+	checkIntForLoBound(KEY_GROUP_COMMIT_DELAY, -1, true);
+	checkIntForHiBound(KEY_GROUP_COMMIT_DELAY, 100, true);
 }
 
 
@@ -189,6 +189,15 @@ enum ConfigKey
 	KEY_USE_FILESYSTEM_CACHE,
 	KEY_INLINE_SORT_THRESHOLD,
 	KEY_TEMP_PAGESPACE_DIR,
+	KEY_MAX_SORT_THREADS,
+	KEY_PARALLEL_WORKERS,
+	KEY_MAX_PARALLEL_WORKERS,
+	KEY_READ_AHEAD_PAGES,
+	KEY_USE_IO_URING,
+	KEY_TRACK_CHANGED_PAGES,
+	KEY_MAX_INLINE_BLOB_SIZE,
+	KEY_MAX_BLOB_CACHE_SIZE,
+	KEY_GROUP_COMMIT_DELAY,
 	MAX_CONFIG_KEY		// keep it last
 };
 
@@ -304,7 +313,16 @@ constexpr ConfigEntry entries[MAX_CONFIG_KEY] =
 	{TYPE_STRING,	"DataTypeCompatibility",	false,	nullptr},
 	{TYPE_BOOLEAN,	"UseFileSystemCache",		false,	true},
 	{TYPE_INTEGER,	"InlineSortThreshold",		false,	1000},		// bytes
-	{TYPE_STRING,	"TempTableDirectory",		false,	""}
+	{TYPE_STRING,	"TempTableDirectory",		false,	""},
+	{TYPE_INTEGER,	"MaxSortThreads",			false,	1},
+	{TYPE_INTEGER,	"ParallelWorkers",			false,	1},
+	{TYPE_INTEGER,	"MaxParallelWorkers",		false,	1},
+	{TYPE_INTEGER,	"ReadAheadPages",			false,	0},
+	{TYPE_BOOLEAN,	"UseIoUring",				false,	false},
+	{TYPE_BOOLEAN,	"TrackChangedPages",		false,	false},
+	{TYPE_INTEGER,	"MaxInlineBlobSize",		false,	65535},		// bytes
+	{TYPE_INTEGER,	"MaxBlobCacheSize",			false,	10485760},	// bytes
+	{TYPE_INTEGER,	"GroupCommitDelay",			false,	-1}			// milliseconds
 };
 
 
@@ -629,6 +647,24 @@ public:
 	CONFIG_GET_PER_DB_KEY(ULONG, getInlineSortThreshold, KEY_INLINE_SORT_THRESHOLD, getInt);
 
 	CONFIG_GET_PER_DB_STR(getTempPageSpaceDirectory, KEY_TEMP_PAGESPACE_DIR);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getMaxSortThreads, KEY_MAX_SORT_THREADS, getInt);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getParallelWorkers, KEY_PARALLEL_WORKERS, getInt);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getMaxParallelWorkers, KEY_MAX_PARALLEL_WORKERS, getInt);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getReadAheadPages, KEY_READ_AHEAD_PAGES, getInt);
+
+	CONFIG_GET_PER_DB_BOOL(getUseIoUring, KEY_USE_IO_URING);
+
+	CONFIG_GET_PER_DB_BOOL(getTrackChangedPages, KEY_TRACK_CHANGED_PAGES);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getMaxInlineBlobSize, KEY_MAX_INLINE_BLOB_SIZE, getInt);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getMaxBlobCacheSize, KEY_MAX_BLOB_CACHE_SIZE, getInt);
+
+	CONFIG_GET_PER_DB_INT(getGroupCommitDelay, KEY_GROUP_COMMIT_DELAY);
 };
 
 // Implementation of interface to access master configuration file
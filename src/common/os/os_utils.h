@@ -51,6 +51,7 @@
 #include <dirent.h>
 #include <sys/mman.h>
 #include <sys/resource.h>
+#include <sys/uio.h>
 
 #define DEFAULT_OPEN_MODE (0666)
 #endif
@@ -235,6 +236,28 @@ namespace os_utils
 #endif
 	}
 
+#if defined(HAVE_PREADV) && defined(HAVE_PWRITEV)
+	inline ssize_t preadv(int fd, const struct iovec* iov, int iovcnt, off_t offset)
+	{
+		// Don't check EINTR because it's done by caller
+#ifdef LSB_BUILD
+		return preadv64(fd, iov, iovcnt, offset);
+#else
+		return ::preadv(fd, iov, iovcnt, offset);
+#endif
+	}
+
+	inline ssize_t pwritev(int fd, const struct iovec* iov, int iovcnt, off_t offset)
+	{
+		// Don't check EINTR because it's done by caller
+#ifdef LSB_BUILD
+		return pwritev64(fd, iov, iovcnt, offset);
+#else
+		return ::pwritev(fd, iov, iovcnt, offset);
+#endif
+	}
+#endif
+
 	inline struct dirent* readdir(DIR* dirp)
 	{
 		struct dirent* rc;
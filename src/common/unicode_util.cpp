@@ -28,6 +28,7 @@
 #include "../common/classes/alloc.h"
 #include "../jrd/constants.h"
 #include "../common/unicode_util.h"
+#include "../common/UnicodeSimd.h"
 #include "../common/isc_proto.h"
 #include "../common/CharSet.h"
 #include "../common/IntlUtil.h"
@@ -52,6 +53,20 @@
 #	include <unicode/utf_old.h>
 #endif
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+#define UNICODE_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UNICODE_SSE2
+#include <emmintrin.h>
+#endif
+
 
 using namespace Firebird;
 
@@ -191,6 +206,216 @@ void BaseICU::initialize(ModuleLoader::Module* module)
 
 }
 
+
+// Fast paths for ASCII runs, see UnicodeSimd.h
+
+namespace {
+
+ULONG genericUtf8AsciiLength(ULONG len, const UCHAR* str)
+{
+	ULONG i = 0;
+
+	while (i < len && str[i] < 0x80)
+		++i;
+
+	return i;
+}
+
+ULONG genericUtf8AsciiToUtf16(ULONG len, const UCHAR* src, USHORT* dst)
+{
+	ULONG i = 0;
+
+	for (; i < len && src[i] < 0x80; ++i)
+		dst[i] = src[i];
+
+	return i;
+}
+
+ULONG genericUtf16AsciiToUtf8(ULONG len, const USHORT* src, UCHAR* dst)
+{
+	ULONG i = 0;
+
+	for (; i < len && src[i] < 0x80; ++i)
+		dst[i] = (UCHAR) src[i];
+
+	return i;
+}
+
+ULONG genericUtf16BmpLength(ULONG len, const USHORT* str)
+{
+	ULONG i = 0;
+
+	while (i < len && (str[i] & 0xF800) != 0xD800)
+		++i;
+
+	return i;
+}
+
+#ifdef UNICODE_SSE2
+
+ULONG sse2Utf8AsciiLength(ULONG len, const UCHAR* str)
+{
+	ULONG i = 0;
+
+	for (; len - i >= 16; i += 16)
+	{
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+
+		if (_mm_movemask_epi8(chunk))
+			break;
+	}
+
+	return i + genericUtf8AsciiLength(len - i, str + i);
+}
+
+ULONG sse2Utf8AsciiToUtf16(ULONG len, const UCHAR* src, USHORT* dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	ULONG i = 0;
+
+	for (; len - i >= 16; i += 16)
+	{
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+		if (_mm_movemask_epi8(chunk))
+			break;
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(chunk, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(chunk, zero));
+	}
+
+	return i + genericUtf8AsciiToUtf16(len - i, src + i, dst + i);
+}
+
+ULONG sse2Utf16AsciiToUtf8(ULONG len, const USHORT* src, UCHAR* dst)
+{
+	const __m128i nonAscii = _mm_set1_epi16((short) 0xFF80);
+	const __m128i zero = _mm_setzero_si128();
+	ULONG i = 0;
+
+	for (; len - i >= 16; i += 16)
+	{
+		const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+		const __m128i high = _mm_and_si128(_mm_or_si128(lo, hi), nonAscii);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF)
+			break;
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+	}
+
+	return i + genericUtf16AsciiToUtf8(len - i, src + i, dst + i);
+}
+
+ULONG sse2Utf16BmpLength(ULONG len, const USHORT* str)
+{
+	const __m128i surrogateMask = _mm_set1_epi16((short) 0xF800);
+	const __m128i surrogate = _mm_set1_epi16((short) 0xD800);
+	ULONG i = 0;
+
+	for (; len - i >= 8; i += 8)
+	{
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+		const __m128i found = _mm_cmpeq_epi16(_mm_and_si128(chunk, surrogateMask), surrogate);
+
+		if (_mm_movemask_epi8(found))
+			break;
+	}
+
+	return i + genericUtf16BmpLength(len - i, str + i);
+}
+
+const Jrd::UnicodeSimd sse2Functions =
+{
+	sse2Utf8AsciiLength,
+	sse2Utf8AsciiToUtf16,
+	sse2Utf16AsciiToUtf8,
+	sse2Utf16BmpLength
+};
+
+#endif	// UNICODE_SSE2
+
+const Jrd::UnicodeSimd genericFunctions =
+{
+	genericUtf8AsciiLength,
+	genericUtf8AsciiToUtf16,
+	genericUtf16AsciiToUtf8,
+	genericUtf16BmpLength
+};
+
+bool avx2Supported()
+{
+#ifdef UNICODE_X86
+	// Both CPU and OS (saving of YMM registers) must support AVX
+
+	const unsigned int cpuidOsxsave = 1 << 27;
+	const unsigned int cpuidAvx = 1 << 28;
+	const unsigned int cpuidAvx2 = 1 << 5;
+
+#ifdef _MSC_VER
+	int flags[4];
+	__cpuid(flags, 0);
+
+	if (flags[0] < 7)
+		return false;
+
+	__cpuid(flags, 1);
+
+	if ((flags[2] & (cpuidOsxsave | cpuidAvx)) != (cpuidOsxsave | cpuidAvx))
+		return false;
+
+	if ((_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(flags, 7, 0);
+	return (flags[1] & cpuidAvx2) != 0;
+#else
+	unsigned int eax, ebx, ecx, edx;
+
+	if (__get_cpuid_max(0, NULL) < 7)
+		return false;
+
+	__cpuid(1, eax, ebx, ecx, edx);
+
+	if ((ecx & (cpuidOsxsave | cpuidAvx)) != (cpuidOsxsave | cpuidAvx))
+		return false;
+
+	unsigned int xcr0, xcr0High;
+	__asm__ ("xgetbv" : "=a" (xcr0), "=d" (xcr0High) : "c" (0));
+
+	if ((xcr0 & 6) != 6)
+		return false;
+
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	return (ebx & cpuidAvx2) != 0;
+#endif
+#else	// UNICODE_X86
+	return false;
+#endif	// UNICODE_X86
+}
+
+const Jrd::UnicodeSimd* selectFunctions()
+{
+	if (Jrd::unicodeAvx2 && avx2Supported())
+		return Jrd::unicodeAvx2;
+
+#ifdef UNICODE_SSE2
+	return &sse2Functions;
+#else
+	return &genericFunctions;
+#endif
+}
+
+// Avoid dependency on the order of static initialization
+const Jrd::UnicodeSimd& simd()
+{
+	static const Jrd::UnicodeSimd* const functions = selectFunctions();
+	return *functions;
+}
+
+}	// namespace
+
 namespace Jrd {
 
 static ModuleLoader::Module* formatAndLoad(const char* templateName,
@@ -695,42 +920,46 @@ ULONG UnicodeUtil::utf16ToUtf8(ULONG srcLen, const USHORT* src, ULONG dstLen, UC
 			break;
 		}
 
-		UChar32 c = src[i++];
-
-		if (c <= 0x7F)
-			*dst++ = c;
-		else
+		if (src[i] <= 0x7F)
 		{
-			*err_position = (i - 1) * sizeof(*src);
+			// Copy the whole run of ASCII characters at once
+			const ULONG n = simd().utf16AsciiToUtf8(MIN(srcLen - i, (ULONG) (dstEnd - dst)), src + i, dst);
+			i += n;
+			dst += n;
+			continue;
+		}
 
-			if (UTF_IS_SURROGATE(c))
-			{
-				UChar32 c2;
+		UChar32 c = src[i++];
 
-				if (UTF_IS_SURROGATE_FIRST(c) && i < srcLen && UTF_IS_TRAIL(c2 = src[i]))
-				{
-					++i;
-					c = UTF16_GET_PAIR_VALUE(c, c2);
-				}
-				else
-				{
-					*err_code = CS_BAD_INPUT;
-					break;
-				}
-			}
+		*err_position = (i - 1) * sizeof(*src);
 
-			if (U8_LENGTH(c) <= dstEnd - dst)
+		if (UTF_IS_SURROGATE(c))
+		{
+			UChar32 c2;
+
+			if (UTF_IS_SURROGATE_FIRST(c) && i < srcLen && UTF_IS_TRAIL(c2 = src[i]))
 			{
-				int j = 0;
-				U8_APPEND_UNSAFE(dst, j, c);
-				dst += j;
+				++i;
+				c = UTF16_GET_PAIR_VALUE(c, c2);
 			}
 			else
 			{
-				*err_code = CS_TRUNCATION_ERROR;
+				*err_code = CS_BAD_INPUT;
 				break;
 			}
 		}
+
+		if (U8_LENGTH(c) <= dstEnd - dst)
+		{
+			int j = 0;
+			U8_APPEND_UNSAFE(dst, j, c);
+			dst += j;
+		}
+		else
+		{
+			*err_code = CS_TRUNCATION_ERROR;
+			break;
+		}
 	}
 
 	return static_cast<ULONG>((dst - dstStart) * sizeof(*dst));
@@ -762,35 +991,39 @@ ULONG UnicodeUtil::utf8ToUtf16(ULONG srcLen, const UCHAR* src, ULONG dstLen, USH
 			break;
 		}
 
+		if (src[i] <= 0x7F)
+		{
+			// Copy the whole run of ASCII characters at once
+			const ULONG n = simd().utf8AsciiToUtf16(MIN(srcLen - i, (ULONG) (dstEnd - dst)), src + i, dst);
+			i += n;
+			dst += n;
+			continue;
+		}
+
 		UChar32 c = src[i++];
 
-		if (c <= 0x7F)
+		*err_position = i - 1;
+
+		c = cIcu.utf8_nextCharSafeBody(src, reinterpret_cast<int32_t*>(&i), srcLen, c, -1);
+
+		if (c < 0)
+		{
+			*err_code = CS_BAD_INPUT;
+			break;
+		}
+		else if (c <= 0xFFFF)
 			*dst++ = c;
 		else
 		{
-			*err_position = i - 1;
-
-			c = cIcu.utf8_nextCharSafeBody(src, reinterpret_cast<int32_t*>(&i), srcLen, c, -1);
-
-			if (c < 0)
+			if (dstEnd - dst > 1)
 			{
-				*err_code = CS_BAD_INPUT;
-				break;
+				*dst++ = UTF16_LEAD(c);
+				*dst++ = UTF16_TRAIL(c);
 			}
-			else if (c <= 0xFFFF)
-				*dst++ = c;
 			else
 			{
-				if (dstEnd - dst > 1)
-				{
-					*dst++ = UTF16_LEAD(c);
-					*dst++ = UTF16_TRAIL(c);
-				}
-				else
-				{
-					*err_code = CS_TRUNCATION_ERROR;
-					break;
-				}
+				*err_code = CS_TRUNCATION_ERROR;
+				break;
 			}
 		}
 	}
@@ -927,8 +1160,32 @@ SSHORT UnicodeUtil::utf16Compare(ULONG len1, const USHORT* str1, ULONG len2, con
 ULONG UnicodeUtil::utf16Length(ULONG len, const USHORT* str)
 {
 	fb_assert(len % sizeof(*str) == 0);
-	// safe cast - alignment not changed
-	return getConversionICU().u_countChar32(reinterpret_cast<const UChar*>(str), len / sizeof(*str));
+
+	len /= sizeof(*str);
+
+	// Count code points the same way as u_countChar32 does:
+	// surrogate pair is one character, unpaired surrogate is counted as is
+
+	ULONG length = 0;
+
+	for (ULONG i = 0; i < len; )
+	{
+		const ULONG n = simd().utf16BmpLength(len - i, str + i);
+		length += n;
+		i += n;
+
+		if (i < len)
+		{
+			if (U16_IS_LEAD(str[i]) && i + 1 < len && U16_IS_TRAIL(str[i + 1]))
+				i += 2;
+			else
+				++i;
+
+			++length;
+		}
+	}
+
+	return length;
 }
 
 
@@ -989,20 +1246,23 @@ INTL_BOOL UnicodeUtil::utf8WellFormed(ULONG len, const UCHAR* str, ULONG* offend
 	ConversionICU& cIcu(getConversionICU());
 	for (ULONG i = 0; i < len; )
 	{
-		UChar32 c = str[i++];
-
-		if (c > 0x7F)
+		if (str[i] <= 0x7F)
 		{
-			const ULONG save_i = i - 1;
+			// Skip the whole run of ASCII characters at once
+			i += simd().utf8AsciiLength(len - i, str + i);
+			continue;
+		}
 
-			c = cIcu.utf8_nextCharSafeBody(str, reinterpret_cast<int32_t*>(&i), len, c, -1);
+		const ULONG save_i = i;
+		UChar32 c = str[i++];
 
-			if (c < 0)
-			{
-				if (offending_position)
-					*offending_position = save_i;
-				return false;	// malformed
-			}
+		c = cIcu.utf8_nextCharSafeBody(str, reinterpret_cast<int32_t*>(&i), len, c, -1);
+
+		if (c < 0)
+		{
+			if (offending_position)
+				*offending_position = save_i;
+			return false;	// malformed
 		}
 	}
 
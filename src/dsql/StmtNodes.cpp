@@ -33,6 +33,7 @@
 #include "../jrd/tra.h"
 #include "../jrd/Coercion.h"
 #include "../jrd/Function.h"
+#include "../jrd/Profiler.h"
 #include "../jrd/Optimizer.h"
 #include "../jrd/RecordSourceNodes.h"
 #include "../jrd/VirtualTable.h"
@@ -975,6 +976,12 @@ const StmtNode* CompoundStmtNode::execute(thread_db* tdbb, jrd_req* request, Exe
 				{
 					request->req_src_line = stmt->line;
 					request->req_src_column = stmt->column;
+
+					if (request->req_attachment->att_flags & ATT_profiling)
+					{
+						request->req_attachment->att_profiler->enterLine(tdbb, request,
+							stmt->line, stmt->column);
+					}
 				}
 
 				EXE_assignment(tdbb, static_cast<const AssignmentNode*>(stmt));
@@ -5086,6 +5093,9 @@ const StmtNode* ForNode::execute(thread_db* tdbb, jrd_req* request, ExeState* /*
 				{
 					request->req_src_line = line;
 					request->req_src_column = column;
+
+					if (request->req_attachment->att_flags & ATT_profiling)
+						request->req_attachment->att_profiler->enterLine(tdbb, request, line, column);
 				}
 
 				const bool fetched = cursor->fetchNext(tdbb);
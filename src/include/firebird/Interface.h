@@ -84,6 +84,20 @@ struct PerformanceInfo
 		WRITES
 	};
 
+	// Wait counters, must correspond to RuntimeStatistics::StatType
+	// between WAIT_FIRST_ITEM and WAIT_LAST_ITEM. Times are in microseconds.
+	enum WaitCounters
+	{
+		LATCH_WAITS = 19,
+		LATCH_WAIT_TIME,
+		LOCK_WAITS,
+		LOCK_WAIT_TIME,
+		READ_WAITS,
+		READ_WAIT_TIME,
+		WRITE_WAITS,
+		WRITE_WAIT_TIME
+	};
+
 	ISC_INT64 pin_time;				// Total operation time in milliseconds
 	ISC_INT64* pin_counters;		// Pointer to allow easy addition of new counters
 
@@ -3777,6 +3777,7 @@ const
 	isc_dpb_set_bind = byte(93);
 	isc_dpb_decfloat_round = byte(94);
 	isc_dpb_decfloat_traps = byte(95);
+	isc_dpb_parallel_workers = byte(96);
 	isc_dpb_address = byte(1);
 	isc_dpb_addr_protocol = byte(1);
 	isc_dpb_addr_endpoint = byte(2);
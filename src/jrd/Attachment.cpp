@@ -48,6 +48,7 @@
 
 #include "../common/classes/fb_string.h"
 #include "../jrd/MetaName.h"
+#include "../jrd/Profiler.h"
 #include "../common/StatusArg.h"
 #include "../common/TimeZoneUtil.h"
 #include "../common/isc_proto.h"
@@ -248,6 +249,7 @@ Jrd::Attachment::Attachment(MemoryPool* pool, Database* dbb, JProvider* provider
 	  att_ext_connection(NULL),
 	  att_ext_parent(NULL),
 	  att_ext_call_depth(0),
+	  att_parallel_workers(0),
 	  att_trace_manager(FB_NEW_POOL(*att_pool) TraceManager(this)),
 	  att_bindings(*pool),
 	  att_dest_bind(&att_bindings),
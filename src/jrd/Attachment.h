@@ -97,6 +97,7 @@ namespace Jrd
 	class JrdStatement;
 	class Validation;
 	class Applier;
+	class Profiler;
 
 
 struct DSqlCacheItem
@@ -166,6 +167,8 @@ const ULONG ATT_monitor_init		= 0x100000L; // Attachment is registered in monito
 const ULONG ATT_repl_reset			= 0x200000L; // Replication set has been reset
 const ULONG ATT_replicating			= 0x400000L; // Replication is active
 const ULONG ATT_resetting			= 0x800000L; // Session reset is in progress
+const ULONG ATT_worker				= 0x1000000L; // Worker attachment of the parallel task
+const ULONG ATT_profiling			= 0x2000000L; // Profiler session is active
 
 const ULONG ATT_NO_CLEANUP			= (ATT_no_cleanup | ATT_notify_gc);
 
@@ -491,6 +494,7 @@ public:
 	EDS::Connection* att_ext_connection;	// external connection executed by this attachment
 	EDS::Connection* att_ext_parent;		// external connection, parent of this attachment
 	ULONG att_ext_call_depth;				// external connection call depth, 0 for user attachment
+	ULONG att_parallel_workers;				// number of parallel workers requested, 0 - use config
 	TraceManager* att_trace_manager;		// Trace API manager
 
 	CoercionArray att_bindings;
@@ -502,6 +506,8 @@ public:
 	Firebird::AutoPtr<Replication::TableMatcher> att_repl_matcher;
 	Firebird::Array<Applier*> att_repl_appliers;
 
+	Firebird::AutoPtr<Profiler> att_profiler;	// PSQL and record source profiler
+
 	enum UtilType { UTIL_NONE, UTIL_GBAK, UTIL_GFIX, UTIL_GSTAT };
 
 	UtilType att_utility;
@@ -1316,6 +1316,145 @@ namespace Jrd {
 		return SUCCESS_ALL;
 	}
 
+	bool CryptoManager::write(thread_db* tdbb, FbStatusVector* sv, Ods::pag** pages, FB_SIZE_T count,
+		BatchIOCallback* io)
+	{
+		// Same as write() of single page, but all pages are passed to the callback at once
+		try
+		{
+			bool mayCrypt = false;
+
+			for (FB_SIZE_T n = 0; n < count; n++)
+			{
+				// Sanity check
+				if (pages[n]->pag_type > pag_max)
+					Arg::Gds(isc_page_type_err).raise();
+
+				if (Ods::pag_crypt_page[pages[n]->pag_type])
+					mayCrypt = true;
+			}
+
+			// Pages are never going to be encrypted. No locks needed.
+			if (!mayCrypt)
+				return internalWrite(tdbb, sv, pages, count, io) == SUCCESS_ALL;
+
+			if (!slowIO)
+			{
+				BarSync::IoGuard ioGuard(tdbb, sync);
+				if (!slowIO)
+					return internalWrite(tdbb, sv, pages, count, io) == SUCCESS_ALL;
+			}
+
+			BarSync::LockGuard lockGuard(tdbb, sync);
+			lockGuard.lock();
+			for (SINT64 previous = slowIO; ; previous = slowIO)
+			{
+				switch (internalWrite(tdbb, sv, pages, count, io))
+				{
+				case SUCCESS_ALL:
+					if (!slowIO)
+						return true;
+
+					lockAndReadHeader(tdbb, CRYPT_HDR_NOWAIT);
+					if (slowIO == previous)
+						return true;
+					break;
+
+				case FAILED_IO:
+					return false;
+
+				case FAILED_CRYPT:
+					if (!slowIO)
+						return false;
+
+					lockAndReadHeader(tdbb, CRYPT_HDR_NOWAIT);
+					if (slowIO == previous)
+						return false;
+					break;
+				}
+			}
+		}
+		catch (const Exception& ex)
+		{
+			ex.stuffException(sv);
+		}
+		return false;
+	}
+
+	CryptoManager::IoResult CryptoManager::internalWrite(thread_db* tdbb, FbStatusVector* sv,
+		Ods::pag** pages, FB_SIZE_T count, BatchIOCallback* io)
+	{
+		// Encrypted images of pages are placed into single buffer,
+		// pages which are not encrypted are written from cache as is
+
+		HalfStaticArray<Ods::pag*, 64> dest;
+		dest.assign(pages, count);
+
+		HalfStaticArray<UCHAR, 64> savedFlags;
+		UCHAR* const flags = savedFlags.getBuffer(count);
+
+		Array<UCHAR> buffer;
+		UCHAR* to = NULL;
+
+		IoResult result = SUCCESS_ALL;
+		FB_SIZE_T n = 0;
+
+		for (; n < count; n++)
+		{
+			Ods::pag* const page = pages[n];
+			flags[n] = page->pag_flags;
+
+			if (crypt && Ods::pag_crypt_page[page->pag_type])
+			{
+				fb_assert(cryptPlugin);
+				if (!cryptPlugin)
+				{
+					Arg::Gds(isc_encrypt_error).copyTo(sv);
+					result = FAILED_CRYPT;
+					break;
+				}
+
+				if (!to)
+				{
+					to = FB_ALIGN(buffer.getBuffer(count * dbb.dbb_page_size + PAGE_ALIGNMENT),
+						PAGE_ALIGNMENT);
+				}
+
+				Ods::pag* const encrypted = reinterpret_cast<Ods::pag*>(to + n * dbb.dbb_page_size);
+
+				FbLocalStatus ls;
+				encrypted[0] = page[0];
+				cryptPlugin->encrypt(&ls, dbb.dbb_page_size - sizeof(Ods::pag),
+					&page[1], &encrypted[1]);
+				if (ls->getState() & IStatus::STATE_ERRORS)
+				{
+					ERR_post_nothrow(&ls, sv);
+					result = FAILED_CRYPT;
+					break;
+				}
+
+				encrypted->pag_flags |= Ods::crypted_page;	// Mark page that is going to be written as encrypted
+				page->pag_flags |= Ods::crypted_page;		// Set the mark for page in cache as well
+				dest[n] = encrypted;						// Choose correct destination
+			}
+			else
+			{
+				page->pag_flags &= ~Ods::crypted_page;
+			}
+		}
+
+		if (result == SUCCESS_ALL && !io->callback(tdbb, sv, dest.begin(), count))
+			result = FAILED_IO;
+
+		if (result != SUCCESS_ALL)
+		{
+			for (FB_SIZE_T i = 0; i < n; i++)
+				pages[i]->pag_flags = flags[i];
+		}
+
+		return result;
+	}
+
 	int CryptoManager::blockingAstChangeCryptState(void* object)
 	{
 		((CryptoManager*) object)->blockingAstChangeCryptState();
@@ -289,8 +289,16 @@ public:
 		virtual bool callback(thread_db* tdbb, FbStatusVector* sv, Ods::pag* page) = 0;
 	};
 
+	class BatchIOCallback
+	{
+	public:
+		virtual bool callback(thread_db* tdbb, FbStatusVector* sv, Ods::pag** pages, FB_SIZE_T count) = 0;
+	};
+
 	bool read(thread_db* tdbb, FbStatusVector* sv, Ods::pag* page, IOCallback* io);
 	bool write(thread_db* tdbb, FbStatusVector* sv, Ods::pag* page, IOCallback* io);
+	bool write(thread_db* tdbb, FbStatusVector* sv, Ods::pag** pages, FB_SIZE_T count,
+		BatchIOCallback* io);
 
 	void cryptThread();
 
@@ -306,6 +314,8 @@ private:
 	enum IoResult {SUCCESS_ALL, FAILED_CRYPT, FAILED_IO};
 	IoResult internalRead(thread_db* tdbb, FbStatusVector* sv, Ods::pag* page, IOCallback* io);
 	IoResult internalWrite(thread_db* tdbb, FbStatusVector* sv, Ods::pag* page, IOCallback* io);
+	IoResult internalWrite(thread_db* tdbb, FbStatusVector* sv, Ods::pag** pages, FB_SIZE_T count,
+		BatchIOCallback* io);
 
 	class Buffer
 	{
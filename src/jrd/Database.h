@@ -70,6 +70,7 @@
 #include "../common/classes/SyncObject.h"
 #include "../common/classes/Synchronize.h"
 #include "../jrd/replication/Manager.h"
+#include "../jrd/GroupCommit.h"
 #include "fb_types.h"
 
 
@@ -522,6 +523,7 @@ public:
 
 	USHORT unflushed_writes;			// unflushed writes
 	time_t last_flushed_write;			// last flushed write time
+	GroupCommit dbb_group_commit;		// shared page writes of committing transactions
 
 	TipCache*		dbb_tip_cache;		// cache of latest known state of all transactions in system
 	BackupManager*	dbb_backup_manager;						// physical backup manager
@@ -603,6 +605,7 @@ private:
 		dbb_gc_fini(*p, garbage_collector, THREAD_medium),
 		dbb_stats(*p),
 		dbb_lock_owner_id(getLockOwnerId()),
+		dbb_group_commit(*p),
 		dbb_tip_cache(NULL),
 		dbb_creation_date(Firebird::TimeZoneUtil::getCurrentGmtTimeStamp()),
 		dbb_external_file_directory_list(NULL),
@@ -0,0 +1,357 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		DeferredIndexKeys.cpp
+ *	DESCRIPTION:	Sorted insertion of index keys of bulk modifications
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+
+#include "firebird.h"
+#include <string.h>
+#include "../jrd/DeferredIndexKeys.h"
+#include "../jrd/jrd.h"
+#include "../jrd/ods.h"
+#include "../jrd/btr.h"
+#include "../jrd/cch.h"
+#include "../jrd/tra.h"
+#include "../jrd/Relation.h"
+#include "../jrd/btr_proto.h"
+#include "../jrd/cch_proto.h"
+
+using namespace Jrd;
+using namespace Ods;
+using namespace Firebird;
+
+
+bool DeferredIndexKeys::Item::operator>(const Item& other) const
+{
+/**************************************
+ *
+ * Order by index, then by key and record number,
+ * i.e. in the order of the leaf level nodes.
+ *
+ **************************************/
+	if (indexId != other.indexId)
+		return indexId > other.indexId;
+
+	const int result = memcmp(data, other.data, MIN(length, other.length));
+	if (result)
+		return result > 0;
+
+	if (length != other.length)
+		return length > other.length;
+
+	return number > other.number;
+}
+
+
+DeferredIndexKeys::~DeferredIndexKeys()
+{
+	for (RelationKeys** iter = m_relations.begin(); iter != m_relations.end(); ++iter)
+		delete *iter;
+}
+
+
+bool DeferredIndexKeys::add(thread_db* tdbb, jrd_tra* transaction, jrd_rel* relation,
+	const index_desc* idx, const temporary_key* key, RecordNumber number)
+{
+/**************************************
+ *
+ * Decide whether the key could be inserted later and remember it.
+ * The temporary and system relations are not worth the trouble.
+ * Only the top level statement defers the keys as it inserts
+ * them before returning the control to the caller.
+ *
+ **************************************/
+	if (idx->idx_flags & (idx_unique | idx_primary | idx_foreign))
+		return false;
+
+	if (relation->isTemporary() || relation->isSystem() ||
+		(transaction->tra_flags & TRA_system) || !(transaction->tra_flags & TRA_defer_keys))
+	{
+		return false;
+	}
+
+	RelationKeys* relKeys = get(relation);
+
+	if (!relKeys)
+	{
+		relKeys = FB_NEW_POOL(m_pool) RelationKeys(m_pool, relation);
+		m_relations.add(relKeys);
+	}
+
+	if (++relKeys->counter <= DEFER_THRESHOLD)
+		return false;
+
+	Item item;
+	item.indexId = idx->idx_id;
+	item.offset = relKeys->keys.getCount();
+	item.length = key->key_length;
+	item.flags = key->key_flags;
+	item.nulls = key->key_nulls;
+	item.number = number.getValue();
+	item.savNumber = transaction->tra_save_point ? transaction->tra_save_point->getNumber() : 0;
+	item.data = NULL;
+
+	relKeys->keys.add(key->key_data, key->key_length);
+	relKeys->items.add(item);
+	RBM_SET(&m_pool, &relKeys->records, item.number);
+
+	const ULONG size = key->key_length + sizeof(Item);
+	relKeys->size += size;
+	m_size += size;
+
+	return true;
+}
+
+
+void DeferredIndexKeys::flush(thread_db* tdbb, jrd_tra* transaction, jrd_rel* relation)
+{
+	if (relation)
+	{
+		RelationKeys* const relKeys = get(relation);
+
+		if (relKeys)
+			flushKeys(tdbb, transaction, relKeys);
+
+		return;
+	}
+
+	for (RelationKeys** iter = m_relations.begin(); iter != m_relations.end(); ++iter)
+		flushKeys(tdbb, transaction, *iter);
+}
+
+
+void DeferredIndexKeys::finish(thread_db* tdbb, jrd_tra* transaction)
+{
+/**************************************
+ *
+ * The next statement starts counting the keys anew,
+ * so the small ones don't defer anything.
+ *
+ **************************************/
+	for (RelationKeys** iter = m_relations.begin(); iter != m_relations.end(); ++iter)
+	{
+		(*iter)->counter = 0;
+		flushKeys(tdbb, transaction, *iter);
+	}
+}
+
+
+void DeferredIndexKeys::flushKeys(thread_db* tdbb, jrd_tra* transaction, RelationKeys* relKeys)
+{
+/**************************************
+ *
+ * Insert the pending keys of the relation in the index order.
+ * If the insertion fails, the keys inserted so far are
+ * forgotten to not be inserted twice.
+ *
+ **************************************/
+	if (relKeys->items.isEmpty())
+		return;
+
+	for (Item* item = relKeys->items.begin(); item < relKeys->items.end(); ++item)
+		item->data = relKeys->keys.begin() + item->offset;
+
+	relKeys->items.sort();
+
+	jrd_rel* const relation = relKeys->relation;
+	RelationPages* const relPages = relation->getPages(tdbb);
+	fb_assert(relPages->rel_index_root);
+
+	index_desc idx;
+	temporary_key key;
+
+	index_insertion insertion;
+	insertion.iib_descriptor = &idx;
+	insertion.iib_relation = relation;
+	insertion.iib_key = &key;
+	insertion.iib_transaction = transaction;
+	insertion.iib_btr_level = 0;
+
+	FB_SIZE_T count = 0;
+
+	try
+	{
+		WIN window(relPages->rel_pg_space_id, relPages->rel_index_root);
+		index_root_page* root = (index_root_page*) CCH_FETCH(tdbb, &window, LCK_read, pag_root);
+
+		for (const Item* item = relKeys->items.begin(); item < relKeys->items.end(); ++item, ++count)
+		{
+			// The index could be dropped since the key was added
+
+			if (!BTR_description(tdbb, relation, root, &idx, item->indexId))
+				continue;
+
+			key.key_length = item->length;
+			key.key_flags = item->flags;
+			key.key_nulls = item->nulls;
+			memcpy(key.key_data, item->data, item->length);
+
+			insertion.iib_number.setValue(item->number);
+			insertion.iib_duplicates = NULL;
+
+			BTR_insert(tdbb, &window, &insertion);
+			root = (index_root_page*) CCH_FETCH(tdbb, &window, LCK_read, pag_root);
+		}
+
+		CCH_RELEASE(tdbb, &window);
+	}
+	catch (const Exception&)
+	{
+		remove(relKeys, count);
+		throw;
+	}
+
+	remove(relKeys, count);
+}
+
+
+void DeferredIndexKeys::remove(RelationKeys* relKeys, FB_SIZE_T count)
+{
+/**************************************
+ *
+ * Forget the first keys of the relation.
+ *
+ **************************************/
+	ULONG size = 0;
+
+	for (const Item* item = relKeys->items.begin(); item < relKeys->items.begin() + count; ++item)
+		size += item->length + sizeof(Item);
+
+	relKeys->items.removeCount(0, count);
+
+	if (relKeys->items.isEmpty())
+	{
+		relKeys->keys.clear();
+
+		if (relKeys->records)
+			relKeys->records->clear();
+
+		size = relKeys->size;
+	}
+
+	fb_assert(size <= relKeys->size && size <= m_size);
+	relKeys->size -= size;
+	m_size -= size;
+}
+
+
+void DeferredIndexKeys::undo(SavNumber number)
+{
+/**************************************
+ *
+ * The savepoint numbers grow, so every key added since the
+ * savepoint was started has the same or greater number.
+ *
+ **************************************/
+	for (RelationKeys** iter = m_relations.begin(); iter != m_relations.end(); ++iter)
+	{
+		RelationKeys* const relKeys = *iter;
+		Item* dst = relKeys->items.begin();
+		ULONG size = 0;
+
+		for (const Item* src = relKeys->items.begin(); src < relKeys->items.end(); ++src)
+		{
+			if (src->savNumber < number)
+				*dst++ = *src;
+			else
+				size += src->length + sizeof(Item);
+		}
+
+		relKeys->items.shrink(dst - relKeys->items.begin());
+
+		if (relKeys->items.isEmpty())
+		{
+			relKeys->keys.clear();
+
+			if (relKeys->records)
+				relKeys->records->clear();
+
+			size = relKeys->size;
+		}
+
+		// The key data stays in the buffer until it's emptied,
+		// only the memory of the remaining keys is accounted
+
+		fb_assert(size <= relKeys->size && size <= m_size);
+		relKeys->size -= size;
+		m_size -= size;
+	}
+}
+
+
+void DeferredIndexKeys::clear()
+{
+	for (RelationKeys** iter = m_relations.begin(); iter != m_relations.end(); ++iter)
+	{
+		(*iter)->items.clear();
+		(*iter)->keys.clear();
+		(*iter)->counter = 0;
+		(*iter)->size = 0;
+
+		if ((*iter)->records)
+			(*iter)->records->clear();
+	}
+
+	m_size = 0;
+}
+
+
+void DeferredIndexKeys::flushRelation(thread_db* tdbb, jrd_rel* relation)
+{
+	jrd_tra* const transaction = tdbb->getTransaction();
+
+	if (transaction && transaction->tra_deferred_keys)
+		transaction->tra_deferred_keys->flush(tdbb, transaction, relation);
+}
+
+
+void DeferredIndexKeys::flushRecord(thread_db* tdbb, jrd_rel* relation, RecordNumber number)
+{
+/**************************************
+ *
+ * The key of the garbage collected version could be still pending,
+ * its removal would be missed and the stale key inserted later.
+ * The keys are inserted for the whole relation to keep them sorted,
+ * it happens only if the record is modified again by the transaction.
+ *
+ **************************************/
+	jrd_tra* const transaction = tdbb->getTransaction();
+	DeferredIndexKeys* const deferred = transaction ? transaction->tra_deferred_keys : NULL;
+
+	if (!deferred)
+		return;
+
+	RelationKeys* const relKeys = deferred->get(relation);
+
+	if (relKeys && RecordBitmap::test(relKeys->records, number.getValue()))
+		deferred->flushKeys(tdbb, transaction, relKeys);
+}
+
+
+DeferredIndexKeys::RelationKeys* DeferredIndexKeys::get(const jrd_rel* relation) const
+{
+	for (RelationKeys* const* iter = m_relations.begin(); iter != m_relations.end(); ++iter)
+	{
+		if ((*iter)->relation == relation)
+			return *iter;
+	}
+
+	return NULL;
+}
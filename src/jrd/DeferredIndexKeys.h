@@ -0,0 +1,149 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		DeferredIndexKeys.h
+ *	DESCRIPTION:	Sorted insertion of index keys of bulk modifications
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#ifndef JRD_DEFERRED_INDEX_KEYS_H
+#define JRD_DEFERRED_INDEX_KEYS_H
+
+#include "firebird.h"
+#include "../common/classes/array.h"
+#include "../common/classes/tree.h"
+#include "../jrd/RecordNumber.h"
+#include "../jrd/sbm.h"
+
+namespace Jrd {
+
+class thread_db;
+class jrd_rel;
+class jrd_tra;
+struct index_desc;
+struct temporary_key;
+
+// Index keys of the records stored or modified by the top level statement
+// which are not inserted into the index yet.
+//
+// Every key inserted by the mass insert or update means a descent from
+// the root to the random leaf page. When the statement has inserted
+// enough keys into the relation, the keys of its plain (not unique and
+// not foreign key) indices are collected instead and inserted later in
+// key order, so the leaf pages are visited sequentially.
+//
+// The keys are deferred only while the top level request is executed,
+// they are inserted before the control returns to the caller, i.e. no
+// key is pending between the API calls. Other transactions can't see the
+// uncommitted records, only the read committed NO RECORD_VERSION reader
+// could find the record being modified and wait for its writer, and it
+// could miss it while the statement is running just like if it started
+// the scan a bit earlier.
+//
+// The pending keys are also inserted before the index of the relation is
+// scanned by the transaction, before the record having them loses
+// a version and when the memory limit is reached. The keys of the records
+// created under the rolled back savepoint are discarded.
+//
+// Unique and foreign key indices are always maintained immediately as
+// the constraints are checked using them.
+
+class DeferredIndexKeys
+{
+	// Number of keys inserted into relation indices by the statement before deferring starts
+	static const FB_UINT64 DEFER_THRESHOLD = 1024;
+	// Memory used for the pending keys before they are inserted
+	static const ULONG MAX_SIZE = 8 * 1024 * 1024;
+
+public:
+	explicit DeferredIndexKeys(MemoryPool& pool)
+		: m_pool(pool), m_relations(pool), m_size(0)
+	{}
+
+	~DeferredIndexKeys();
+
+	// Returns true if the key is deferred, otherwise it should be inserted now
+	bool add(thread_db* tdbb, jrd_tra* transaction, jrd_rel* relation, const index_desc* idx,
+		const temporary_key* key, RecordNumber number);
+
+	bool isFull() const
+	{
+		return m_size >= MAX_SIZE;
+	}
+
+	// Insert the pending keys of the relation, or of all relations
+	void flush(thread_db* tdbb, jrd_tra* transaction, jrd_rel* relation = NULL);
+	// Insert the pending keys at the end of the top level statement
+	void finish(thread_db* tdbb, jrd_tra* transaction);
+	// Forget the keys added under the given savepoint and its nested ones
+	void undo(SavNumber number);
+	// Forget all the keys
+	void clear();
+
+	// Insert the pending keys of the current transaction before the relation indices are used
+	static void flushRelation(thread_db* tdbb, jrd_rel* relation);
+	// The same if the record has pending keys, before its versions are garbage collected
+	static void flushRecord(thread_db* tdbb, jrd_rel* relation, RecordNumber number);
+
+private:
+	struct Item
+	{
+		USHORT indexId;
+		ULONG offset;			// offset of key data in RelationKeys::keys
+		USHORT length;
+		UCHAR flags;
+		USHORT nulls;
+		SINT64 number;
+		SavNumber savNumber;	// savepoint the key is added under
+		const UCHAR* data;		// set before sort
+
+		bool operator>(const Item& other) const;
+	};
+
+	struct RelationKeys
+	{
+		RelationKeys(MemoryPool& pool, jrd_rel* rel)
+			: relation(rel), counter(0), size(0), items(pool), keys(pool), records(NULL)
+		{
+			items.setSortMode(Firebird::FB_ARRAY_SORT_MANUAL);
+		}
+
+		~RelationKeys()
+		{
+			delete records;
+		}
+
+		jrd_rel* const relation;
+		FB_UINT64 counter;		// keys added to plain indices by the statement
+		ULONG size;				// memory used by pending keys
+		Firebird::SortedArray<Item> items;
+		Firebird::Array<UCHAR> keys;
+		RecordBitmap* records;	// records having pending keys
+	};
+
+	void flushKeys(thread_db* tdbb, jrd_tra* transaction, RelationKeys* relKeys);
+	void remove(RelationKeys* relKeys, FB_SIZE_T count);
+	RelationKeys* get(const jrd_rel* relation) const;
+
+	MemoryPool& m_pool;
+	Firebird::HalfStaticArray<RelationKeys*, 4> m_relations;
+	ULONG m_size;
+};
+
+} // namespace Jrd
+
+#endif	// JRD_DEFERRED_INDEX_KEYS_H
@@ -0,0 +1,142 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		GroupCommit.cpp
+ *	DESCRIPTION:	Shared page writes of concurrently committing transactions
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../jrd/GroupCommit.h"
+#include "../jrd/jrd.h"
+#include "../jrd/cch_proto.h"
+#include "../jrd/tra_proto.h"
+#include "../common/ThreadStart.h"
+
+using namespace Jrd;
+using namespace Firebird;
+
+
+bool GroupCommit::isEnabled(thread_db* tdbb)
+{
+/**************************************
+ *
+ * Grouping makes sense only if the pages are written synchronously.
+ *
+ **************************************/
+	const Database* const dbb = tdbb->getDatabase();
+
+	return (dbb->dbb_flags & DBB_force_write) && !(dbb->dbb_flags & DBB_creating) &&
+		dbb->dbb_config->getGroupCommitDelay() >= 0;
+}
+
+
+void GroupCommit::join(thread_db* tdbb, TraNumber number, const StateChange* change)
+{
+/**************************************
+ *
+ * Queue the request and wait until it's done. If there is no
+ * leader writing now, become the leader: wait for more requests
+ * to come unless this one is alone, then write the pages of all
+ * requests queued so far, set the requested transaction states
+ * and write the inventory pages. If the write fails, the requests
+ * of other transactions are put back to be done by the next leader,
+ * while the leader's own request fails.
+ *
+ **************************************/
+	const Database* const dbb = tdbb->getDatabase();
+	const ULONG mask = number ? 1L << (number & (BITS_PER_LONG - 1)) : 0;
+
+	CheckoutLockGuard guard(tdbb, m_mutex, FB_FUNCTION, true);
+
+	m_pending |= mask;
+
+	if (change)
+		m_states.add(*change);
+
+	const FB_UINT64 ticket = ++m_requested;
+
+	while (m_completed < ticket)
+	{
+		if (m_active)
+		{
+			EngineCheckout cout(tdbb, FB_FUNCTION, true);
+			m_written.wait(m_mutex);
+			continue;
+		}
+
+		m_active = true;
+
+		const int delay = dbb->dbb_config->getGroupCommitDelay();
+
+		if (delay > 0 && m_requested - m_completed > 1)
+		{
+			MutexUnlockGuard unlock(m_mutex, FB_FUNCTION);
+			EngineCheckout cout(tdbb, FB_FUNCTION, true);
+			Thread::sleep(delay);
+		}
+
+		const FB_UINT64 target = m_requested;
+		const ULONG batch = m_pending;
+		m_pending = 0;
+
+		HalfStaticArray<StateChange, 16> states;
+		states.assign(m_states);
+		m_states.clear();
+
+		try
+		{
+			MutexUnlockGuard unlock(m_mutex, FB_FUNCTION);
+			CCH_flush_group(tdbb, batch);
+
+			if (states.hasData())
+			{
+				for (const StateChange* iter = states.begin(); iter < states.end(); ++iter)
+					TRA_set_group_state(tdbb, iter->number, iter->state);
+
+				CCH_flush_group(tdbb, 0);
+			}
+		}
+		catch (const Exception&)
+		{
+			// The leader's own commit fails, its state must not be set
+			// by the next leader
+
+			if (change)
+			{
+				for (FB_SIZE_T i = 0; i < states.getCount(); i++)
+				{
+					if (states[i].number == change->number)
+					{
+						states.remove(i);
+						break;
+					}
+				}
+			}
+
+			m_pending |= batch;
+			m_states.join(states);
+			m_active = false;
+			m_written.notifyAll();
+			throw;
+		}
+
+		m_completed = target;
+		m_active = false;
+		m_written.notifyAll();
+	}
+}
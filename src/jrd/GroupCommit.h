@@ -0,0 +1,95 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		GroupCommit.h
+ *	DESCRIPTION:	Shared page writes of concurrently committing transactions
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#ifndef JRD_GROUP_COMMIT_H
+#define JRD_GROUP_COMMIT_H
+
+#include "firebird.h"
+#include "../common/classes/locks.h"
+#include "../common/classes/condition.h"
+#include "../common/classes/array.h"
+
+namespace Jrd {
+
+class thread_db;
+
+// With forced writes every page is written synchronously, so the commits
+// of small transactions are limited by the latency of the storage. Instead
+// of flushing the pages of each transaction separately, the transactions
+// committing at the same time form a group: the first one becomes the
+// leader and writes the dirty pages of all the transactions queued so far
+// in a single precedence-ordered pass, the others wait for it. The pages
+// shared by the transactions (the transaction inventory page first of all)
+// are written once per group and adjacent pages are written by larger
+// runs.
+//
+// The committing transaction joins the group once. The leader writes the
+// pages of all the transactions of the group, then sets their states on
+// the inventory pages and writes these pages, thus the careful write order
+// is preserved.
+
+class GroupCommit
+{
+	struct StateChange
+	{
+		TraNumber number;
+		int state;
+	};
+
+public:
+	explicit GroupCommit(MemoryPool& pool)
+		: m_requested(0), m_completed(0), m_pending(0), m_states(pool), m_active(false)
+	{}
+
+	// Returns true if the commits should be grouped
+	static bool isEnabled(thread_db* tdbb);
+
+	// Returns when the pages modified by the given transaction, or by the
+	// system transaction if the number is zero, are written by this or
+	// another thread
+	void flush(thread_db* tdbb, TraNumber number)
+	{
+		join(tdbb, number, NULL);
+	}
+
+	// The same, then the new state of the transaction is set and written
+	void setState(thread_db* tdbb, TraNumber number, int state)
+	{
+		const StateChange change = {number, state};
+		join(tdbb, number, &change);
+	}
+
+private:
+	void join(thread_db* tdbb, TraNumber number, const StateChange* change);
+
+	Firebird::Mutex m_mutex;
+	Firebird::Condition m_written;
+	FB_UINT64 m_requested;	// number of the last request
+	FB_UINT64 m_completed;	// requests up to this number are done
+	ULONG m_pending;		// transaction mask of the requests not written yet
+	Firebird::HalfStaticArray<StateChange, 16> m_states;	// states not set yet
+	bool m_active;			// the leader is writing
+};
+
+} // namespace Jrd
+
+#endif // JRD_GROUP_COMMIT_H
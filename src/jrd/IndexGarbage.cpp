@@ -0,0 +1,149 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		IndexGarbage.cpp
+ *	DESCRIPTION:	Deferred removal of garbage index keys
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+
+#include "firebird.h"
+#include <string.h>
+#include "../jrd/IndexGarbage.h"
+#include "../jrd/jrd.h"
+#include "../jrd/ods.h"
+#include "../jrd/btr.h"
+#include "../jrd/cch.h"
+#include "../jrd/Relation.h"
+#include "../jrd/btr_proto.h"
+#include "../jrd/cch_proto.h"
+
+using namespace Jrd;
+using namespace Ods;
+using namespace Firebird;
+
+
+bool IndexGarbage::Item::operator>(const Item& other) const
+{
+/**************************************
+ *
+ * Order by index, then by key and record number,
+ * i.e. in the order of the leaf level nodes.
+ *
+ **************************************/
+	if (indexId != other.indexId)
+		return indexId > other.indexId;
+
+	const int result = memcmp(data, other.data, MIN(length, other.length));
+	if (result)
+		return result > 0;
+
+	if (length != other.length)
+		return length > other.length;
+
+	return number > other.number;
+}
+
+
+void IndexGarbage::add(const index_desc* idx, const temporary_key* key, RecordNumber number)
+{
+/**************************************
+ *
+ * Remember the key to be removed from the index.
+ *
+ **************************************/
+	Item item;
+	item.indexId = idx->idx_id;
+	item.offset = m_keys.getCount();
+	item.length = key->key_length;
+	item.flags = key->key_flags;
+	item.nulls = key->key_nulls;
+	item.number = number.getValue();
+	item.data = NULL;
+
+	m_keys.add(key->key_data, key->key_length);
+	m_items.add(item);
+}
+
+
+void IndexGarbage::flush(thread_db* tdbb)
+{
+/**************************************
+ *
+ * Remove the collected keys in the index order. The same key
+ * could be collected twice if the record was purged again,
+ * removal of the missing node is harmless but useless, so the
+ * duplicates are skipped.
+ *
+ **************************************/
+	if (m_items.isEmpty())
+		return;
+
+	for (Item* item = m_items.begin(); item < m_items.end(); ++item)
+		item->data = m_keys.begin() + item->offset;
+
+	m_items.sort();
+
+	RelationPages* const relPages = m_relation->getPages(tdbb);
+	fb_assert(relPages->rel_index_root);
+
+	index_desc idx;
+	temporary_key key;
+
+	index_insertion insertion;
+	insertion.iib_descriptor = &idx;
+	insertion.iib_relation = m_relation;
+	insertion.iib_key = &key;
+	insertion.iib_btr_level = 0;
+
+	WIN window(relPages->rel_pg_space_id, relPages->rel_index_root);
+	index_root_page* root = (index_root_page*) CCH_FETCH(tdbb, &window, LCK_read, pag_root);
+
+	const Item* prior = NULL;
+
+	for (const Item* item = m_items.begin(); item < m_items.end(); prior = item++)
+	{
+		if (prior && !(*item > *prior))
+			continue;
+
+		// The index could be dropped since the key was collected
+
+		if (!BTR_description(tdbb, m_relation, root, &idx, item->indexId))
+			continue;
+
+		key.key_length = item->length;
+		key.key_flags = item->flags;
+		key.key_nulls = item->nulls;
+		memcpy(key.key_data, item->data, item->length);
+
+		insertion.iib_number.setValue(item->number);
+
+		BTR_remove(tdbb, &window, &insertion);
+		root = (index_root_page*) CCH_FETCH(tdbb, &window, LCK_read, pag_root);
+	}
+
+	CCH_RELEASE(tdbb, &window);
+
+	clear();
+}
+
+
+void IndexGarbage::clear()
+{
+	m_items.clear();
+	m_keys.clear();
+}
@@ -0,0 +1,97 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		IndexGarbage.h
+ *	DESCRIPTION:	Deferred removal of garbage index keys
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#ifndef JRD_INDEX_GARBAGE_H
+#define JRD_INDEX_GARBAGE_H
+
+#include "firebird.h"
+#include "../common/classes/array.h"
+#include "../jrd/RecordNumber.h"
+
+namespace Jrd {
+
+class thread_db;
+class jrd_rel;
+struct index_desc;
+struct temporary_key;
+
+// Index keys of the record versions purged by the background garbage
+// collector. The collector processes the records of a data page one by
+// one and the keys of different records are spread over the whole index,
+// thus removing them in that order makes every descent from the root go
+// to the random leaf page. Instead the keys are collected while the data
+// page is processed and removed at once, index by index in key order.
+// Every key still has its own descent, but consecutive descents follow
+// the same path and reach the same or the next leaf page, so the pages
+// are found in the cache and the leaf level is visited left to right.
+//
+// The batch must be flushed before the data page is left: removal of a
+// key is safe only while the record is known to not have it, and this
+// knowledge becomes stale as the record can be updated again. The keys of
+// the expunged records are never deferred as the record number could be
+// reused by the new record with the same key.
+
+class IndexGarbage
+{
+public:
+	IndexGarbage(MemoryPool& pool, jrd_rel* relation)
+		: m_relation(relation), m_items(pool), m_keys(pool)
+	{
+		m_items.setSortMode(Firebird::FB_ARRAY_SORT_MANUAL);
+	}
+
+	jrd_rel* getRelation() const
+	{
+		return m_relation;
+	}
+
+	bool isEmpty() const
+	{
+		return m_items.isEmpty();
+	}
+
+	void add(const index_desc* idx, const temporary_key* key, RecordNumber number);
+	void flush(thread_db* tdbb);
+	void clear();
+
+private:
+	struct Item
+	{
+		USHORT indexId;
+		ULONG offset;			// offset of key data in m_keys
+		USHORT length;
+		UCHAR flags;
+		USHORT nulls;
+		SINT64 number;
+		const UCHAR* data;		// set before sort
+
+		bool operator>(const Item& other) const;
+	};
+
+	jrd_rel* const m_relation;
+	Firebird::SortedArray<Item> m_items;
+	Firebird::HalfStaticArray<UCHAR, 4096> m_keys;
+};
+
+} // namespace Jrd
+
+#endif	// JRD_INDEX_GARBAGE_H
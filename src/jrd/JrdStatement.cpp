@@ -36,6 +36,7 @@
 #include "../jrd/met_proto.h"
 #include "../jrd/scl_proto.h"
 #include "../jrd/Collation.h"
+#include "../jrd/Profiler.h"
 
 using namespace Firebird;
 using namespace Jrd;
@@ -587,6 +588,12 @@ void JrdStatement::release(thread_db* tdbb)
 {
 	SET_TDBB(tdbb);
 
+	Jrd::Attachment* const attachment = tdbb->getAttachment();
+
+	// The profiler keeps the pointer to identify the statement, forget it.
+	if (attachment && attachment->att_profiler)
+		attachment->att_profiler->releaseStatement(this);
+
 	// Release sub statements.
 	for (JrdStatement** subStatement = subStatements.begin();
 		 subStatement != subStatements.end();
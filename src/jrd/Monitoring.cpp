@@ -453,6 +453,9 @@ MonitoringSnapshot::MonitoringSnapshot(thread_db* tdbb, MemoryPool& pool)
 	RecordBuffer* const ctx_var_buffer = allocBuffer(tdbb, pool, rel_mon_ctx_vars);
 	RecordBuffer* const mem_usage_buffer = allocBuffer(tdbb, pool, rel_mon_mem_usage);
 	RecordBuffer* const tab_stat_buffer = allocBuffer(tdbb, pool, rel_mon_tab_stats);
+	RecordBuffer* const wait_stat_buffer =
+		(ENCODE_ODS(dbb->dbb_ods_version, dbb->dbb_minor_version) >= ODS_13_2) ?
+			allocBuffer(tdbb, pool, rel_mon_wait_stats) : NULL;
 
 	// Dump our own data and downgrade the lock, if required
 
@@ -582,6 +585,9 @@ MonitoringSnapshot::MonitoringSnapshot(thread_db* tdbb, MemoryPool& pool)
 		case rel_mon_tab_stats:
 			buffer = tab_stat_buffer;
 			break;
+		case rel_mon_wait_stats:
+			buffer = wait_stat_buffer;
+			break;
 		default:
 			fb_assert(false);
 		}
@@ -1268,6 +1274,20 @@ void Monitoring::putStatistics(SnapshotData::DumpRecord& record, const RuntimeSt
 	record.storeInteger(f_mon_io_page_marks, statistics.getValue(RuntimeStatistics::PAGE_MARKS));
 	record.write();
 
+	// wait statistics, times are in microseconds
+	record.reset(rel_mon_wait_stats);
+	record.storeGlobalId(f_mon_wait_stat_id, id);
+	record.storeInteger(f_mon_wait_stat_group, stat_group);
+	record.storeInteger(f_mon_wait_latch_waits, statistics.getValue(RuntimeStatistics::LATCH_WAITS));
+	record.storeInteger(f_mon_wait_latch_time, statistics.getValue(RuntimeStatistics::LATCH_WAIT_TIME));
+	record.storeInteger(f_mon_wait_lock_waits, statistics.getValue(RuntimeStatistics::LOCK_WAITS));
+	record.storeInteger(f_mon_wait_lock_time, statistics.getValue(RuntimeStatistics::LOCK_WAIT_TIME));
+	record.storeInteger(f_mon_wait_read_waits, statistics.getValue(RuntimeStatistics::READ_WAITS));
+	record.storeInteger(f_mon_wait_read_time, statistics.getValue(RuntimeStatistics::READ_WAIT_TIME));
+	record.storeInteger(f_mon_wait_write_waits, statistics.getValue(RuntimeStatistics::WRITE_WAITS));
+	record.storeInteger(f_mon_wait_write_time, statistics.getValue(RuntimeStatistics::WRITE_WAIT_TIME));
+	record.write();
+
 	// logical I/O statistics (global)
 	record.reset(rel_mon_rec_stats);
 	record.storeGlobalId(f_mon_rec_stat_id, id);
@@ -0,0 +1,244 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		ParallelTask.cpp
+ *	DESCRIPTION:	Execution of engine tasks by a number of worker attachments
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../jrd/ParallelTask.h"
+#include "../jrd/jrd.h"
+#include "../jrd/tra.h"
+#include "../jrd/Monitoring.h"
+#include "../jrd/ini_proto.h"
+#include "../jrd/lck_proto.h"
+#include "../jrd/pag_proto.h"
+#include "../jrd/tra_proto.h"
+#include "../common/classes/array.h"
+
+using namespace Jrd;
+using namespace Firebird;
+
+namespace
+{
+	// Read-only read committed transaction, just like the one used by
+	// the garbage collector. It does not inhibit garbage collection.
+
+	const UCHAR worker_tpb[] =
+	{
+		isc_tpb_version1, isc_tpb_read,
+		isc_tpb_read_committed, isc_tpb_rec_version,
+		isc_tpb_ignore_limbo
+	};
+}
+
+
+struct ParallelTask::Worker
+{
+	ParallelTask* task;
+	Database* dbb;
+	Jrd::Attachment* parent;
+	Thread::Handle handle;
+	FbLocalStatus status;
+};
+
+
+unsigned ParallelTask::getWorkers(thread_db* tdbb)
+{
+/**************************************
+ *
+ * Number of workers the current attachment could use. It is
+ * requested using DPB or the per-database default is used.
+ *
+ **************************************/
+	const Database* const dbb = tdbb->getDatabase();
+	const Jrd::Attachment* const attachment = tdbb->getAttachment();
+
+	const unsigned maxWorkers = dbb->dbb_config->getMaxParallelWorkers();
+	unsigned workers = attachment ? attachment->att_parallel_workers : 0;
+
+	if (!workers)
+		workers = dbb->dbb_config->getParallelWorkers();
+
+	return MAX(MIN(workers, maxWorkers), 1);
+}
+
+
+void ParallelTask::run(thread_db* tdbb, unsigned workers)
+{
+/**************************************
+ *
+ * Start additional workers, work in the current thread too and
+ * wait for all of the workers to finish. Report the first error.
+ *
+ **************************************/
+	Jrd::Attachment* const attachment = tdbb->getAttachment();
+	MemoryPool& pool = *tdbb->getDefaultPool();
+
+	HalfStaticArray<Worker*, 16> threads(pool);
+
+	for (unsigned n = 1; n < workers; n++)
+	{
+		Worker* const worker = FB_NEW_POOL(pool) Worker;
+		worker->task = this;
+		worker->dbb = tdbb->getDatabase();
+		worker->parent = attachment;
+
+		try
+		{
+			Thread::start(workerThread, worker, THREAD_medium, &worker->handle);
+		}
+		catch (const Exception&)
+		{
+			// Failed to start more threads, work with those we already have
+			delete worker;
+			break;
+		}
+
+		threads.add(worker);
+	}
+
+	try
+	{
+		work(tdbb);
+	}
+	catch (const Exception&)
+	{
+		m_cancelled.setValue(1);
+
+		{	// scope
+			EngineCheckout cout(tdbb, FB_FUNCTION);
+
+			for (FB_SIZE_T n = 0; n < threads.getCount(); n++)
+			{
+				Thread::waitForCompletion(threads[n]->handle);
+				delete threads[n];
+			}
+		}
+
+		throw;
+	}
+
+	{	// scope
+		EngineCheckout cout(tdbb, FB_FUNCTION);
+
+		for (FB_SIZE_T n = 0; n < threads.getCount(); n++)
+			Thread::waitForCompletion(threads[n]->handle);
+	}
+
+	FbLocalStatus status;
+
+	for (FB_SIZE_T n = 0; n < threads.getCount(); n++)
+	{
+		if (status.isSuccess() && !threads[n]->status.isSuccess())
+			threads[n]->status.copyTo(&status);
+
+		delete threads[n];
+	}
+
+	status.check();
+}
+
+
+THREAD_ENTRY_DECLARE ParallelTask::workerThread(THREAD_ENTRY_PARAM arg)
+{
+	Worker* const worker = static_cast<Worker*>(arg);
+	worker->task->runWorker(worker);
+	return 0;
+}
+
+
+void ParallelTask::runWorker(Worker* worker)
+{
+/**************************************
+ *
+ * Create the system attachment and the transaction of the
+ * additional worker and run the task using them.
+ *
+ **************************************/
+	Database* const dbb = worker->dbb;
+	FbLocalStatus status_vector;
+
+	try
+	{
+		UserId user;
+		user.setUserName("Parallel Worker");
+
+		Jrd::Attachment* const attachment = Jrd::Attachment::create(dbb, nullptr);
+		RefPtr<SysStableAttachment> sAtt(FB_NEW SysStableAttachment(attachment));
+		attachment->setStable(sAtt);
+		attachment->att_filename = dbb->dbb_filename;
+		attachment->att_flags |= ATT_worker | (worker->parent->att_flags & ATT_NO_CLEANUP);
+		attachment->att_user = &user;
+
+		BackgroundContextHolder tdbb(dbb, attachment, &status_vector, FB_FUNCTION);
+
+		jrd_tra* transaction = NULL;
+
+		try
+		{
+			LCK_init(tdbb, LCK_OWNER_attachment);
+			INI_init(tdbb);
+			INI_init2(tdbb);
+			PAG_header(tdbb, true);
+			PAG_attachment_id(tdbb);
+			TRA_init(attachment);
+
+			Monitoring::publishAttachment(tdbb);
+
+			sAtt->initDone();
+
+			if (!isCancelled())
+			{
+				transaction = TRA_start(tdbb, sizeof(worker_tpb), worker_tpb);
+				tdbb->setTransaction(transaction);
+
+				work(tdbb);
+			}
+		}
+		catch (const Exception& ex)
+		{
+			ex.stuffException(&worker->status);
+			m_cancelled.setValue(1);
+			// continue execution to clean up
+		}
+
+		try
+		{
+			if (transaction)
+				TRA_commit(tdbb, transaction, false);
+		}
+		catch (const Exception&)
+		{
+			// the transaction is read-only, nothing is lost
+		}
+
+		Monitoring::cleanupAttachment(tdbb);
+		attachment->releaseLocks(tdbb);
+		LCK_fini(tdbb, LCK_OWNER_attachment);
+
+		attachment->releaseRelations(tdbb);
+	}
+	catch (const Exception& ex)
+	{
+		if (worker->status.isSuccess())
+			ex.stuffException(&worker->status);
+
+		m_cancelled.setValue(1);
+	}
+}
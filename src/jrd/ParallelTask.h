@@ -0,0 +1,81 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		ParallelTask.h
+ *	DESCRIPTION:	Execution of engine tasks by a number of worker attachments
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#ifndef JRD_PARALLEL_TASK_H
+#define JRD_PARALLEL_TASK_H
+
+#include "firebird.h"
+#include "../common/ThreadStart.h"
+#include "../common/classes/fb_atomic.h"
+
+namespace Jrd {
+
+class thread_db;
+
+// Base class for the tasks which could be executed by a number of threads.
+//
+// The thread which calls run() is the first worker, it uses the caller's
+// attachment and transaction. Every additional worker runs in its own thread
+// using its own system attachment to the same database and its own read-only
+// read committed transaction, much like the garbage collector thread does.
+//
+// The task must split its work into independent units and work() must take
+// units until there are no more, so any unit left by a failed or lagging
+// worker is done by the others. The first error stops the task and is
+// re-raised in the calling thread.
+
+class ParallelTask
+{
+public:
+	ParallelTask()
+		: m_cancelled(0)
+	{}
+
+	virtual ~ParallelTask()
+	{}
+
+	// Returns the number of workers to be used by the current attachment
+	static unsigned getWorkers(thread_db* tdbb);
+
+	// Executes work() by the given number of workers, returns when all of them are done
+	void run(thread_db* tdbb, unsigned workers);
+
+	bool isCancelled() const
+	{
+		return m_cancelled.value() != 0;
+	}
+
+protected:
+	virtual void work(thread_db* tdbb) = 0;
+
+private:
+	struct Worker;
+
+	static THREAD_ENTRY_DECLARE workerThread(THREAD_ENTRY_PARAM arg);
+	void runWorker(Worker* worker);
+
+	Firebird::AtomicCounter m_cancelled;
+};
+
+} // namespace Jrd
+
+#endif // JRD_PARALLEL_TASK_H
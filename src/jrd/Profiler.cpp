@@ -0,0 +1,539 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		Profiler.cpp
+ *	DESCRIPTION:	PSQL and record source profiler
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../jrd/Profiler.h"
+#include "../jrd/jrd.h"
+#include "../jrd/req.h"
+#include "../jrd/ini.h"
+#include "../jrd/ids.h"
+#include "../jrd/obj.h"
+#include "../jrd/Function.h"
+#include "../jrd/JrdStatement.h"
+#include "../common/utils_proto.h"
+
+using namespace Jrd;
+using namespace Firebird;
+
+
+Profiler::Profiler(MemoryPool& pool)
+	: m_active(false),
+	  m_sessionId(0),
+	  m_frequency(fb_utils::query_performance_frequency()),
+	  m_statements(pool),
+	  m_statementMap(pool),
+	  m_lines(pool),
+	  m_recordSources(pool),
+	  m_recordSourceMap(pool)
+{
+}
+
+
+SINT64 Profiler::startSession(thread_db* tdbb)
+{
+/**************************************
+ *
+ * Start the new session, the data collected
+ * by the previous one is discarded.
+ *
+ **************************************/
+	m_statements.clear();
+	m_statementMap.clear();
+	m_lines.clear();
+	m_recordSources.clear();
+	m_recordSourceMap.clear();
+
+	m_sessionId = fb_utils::genUniqueId();
+	m_active = true;
+
+	tdbb->getAttachment()->att_flags |= ATT_profiling;
+
+	return m_sessionId;
+}
+
+
+void Profiler::finishSession(thread_db* tdbb)
+{
+	m_active = false;
+
+	tdbb->getAttachment()->att_flags &= ~ATT_profiling;
+}
+
+
+void Profiler::enterLine(thread_db* tdbb, jrd_req* request, ULONG line, ULONG column)
+{
+/**************************************
+ *
+ * Count the execution of PSQL statement and start its timing.
+ * Timing of the previous statement of the request is finished.
+ *
+ **************************************/
+	const SINT64 now = fb_utils::query_performance_counter();
+
+	if (request->req_prof_line)
+		charge(request, now);
+
+	const FB_SIZE_T index = getStatement(tdbb, request);
+
+	if (index == NO_STATEMENT)
+		return;
+
+	const LineKey key = {m_statements[index].id, line, column};
+
+	FB_SIZE_T pos;
+	if (!m_lines.find(key, pos))
+	{
+		const LineStats stats = {key, 0, MAX_SINT64, 0, 0};
+		m_lines.insert(pos, stats);
+	}
+
+	m_lines[pos].counter++;
+
+	request->req_prof_line = line;
+	request->req_prof_column = column;
+	request->req_prof_start = now;
+}
+
+
+void Profiler::leaveLine(jrd_req* request)
+{
+	charge(request, fb_utils::query_performance_counter());
+}
+
+
+void Profiler::charge(jrd_req* request, SINT64 now)
+{
+	if (m_active && request->req_prof_session == m_sessionId &&
+		request->req_prof_statement != NO_STATEMENT)
+	{
+		const LineKey key = {m_statements[request->req_prof_statement].id,
+			request->req_prof_line, request->req_prof_column};
+
+		FB_SIZE_T pos;
+		if (m_lines.find(key, pos))
+		{
+			LineStats& stats = m_lines[pos];
+			const SINT64 elapsed = now - request->req_prof_start;
+
+			stats.minTime = MIN(stats.minTime, elapsed);
+			stats.maxTime = MAX(stats.maxTime, elapsed);
+			stats.totalTime += elapsed;
+		}
+	}
+
+	request->req_prof_line = 0;
+}
+
+
+void Profiler::recordSourceOpen(thread_db* tdbb, const RecordSource* rsb, SINT64 elapsed)
+{
+	RecordSourceStats* const stats = getRecordSource(tdbb, rsb);
+
+	if (stats)
+	{
+		stats->openCounter++;
+		stats->openTime += elapsed;
+	}
+}
+
+
+void Profiler::recordSourceFetch(thread_db* tdbb, const RecordSource* rsb, SINT64 elapsed)
+{
+	RecordSourceStats* const stats = getRecordSource(tdbb, rsb);
+
+	if (stats)
+	{
+		stats->fetchCounter++;
+		stats->fetchTime += elapsed;
+	}
+}
+
+
+void Profiler::releaseStatement(const JrdStatement* statement)
+{
+/**************************************
+ *
+ * The statement is released, its address and addresses of its
+ * record sources may be reused. Forget them but keep the stats.
+ *
+ **************************************/
+	FB_SIZE_T index;
+	if (!m_statementMap.get(statement, index))
+		return;
+
+	m_statementMap.remove(statement);
+	m_statements[index].statement = NULL;
+
+	const SINT64 statementId = m_statements[index].id;
+
+	HalfStaticArray<const RecordSource*, 16> released;
+	RecordSourceMap::Accessor accessor(&m_recordSourceMap);
+
+	for (bool found = accessor.getFirst(); found; found = accessor.getNext())
+	{
+		if (m_recordSources[accessor.current()->second].statementId == statementId)
+			released.add(accessor.current()->first);
+	}
+
+	for (FB_SIZE_T i = 0; i < released.getCount(); i++)
+		m_recordSourceMap.remove(released[i]);
+}
+
+
+FB_SIZE_T Profiler::getStatement(thread_db* tdbb, jrd_req* request)
+{
+	// Statement index is cached in the request for the current session
+
+	if (request->req_prof_session != m_sessionId)
+	{
+		request->req_prof_session = m_sessionId;
+		request->req_prof_statement = getStatement(request->getStatement());
+	}
+
+	return request->req_prof_statement;
+}
+
+
+FB_SIZE_T Profiler::getStatement(const JrdStatement* statement)
+{
+	// Internal requests of the engine are not profiled
+
+	if (statement->flags & (JrdStatement::FLAG_INTERNAL | JrdStatement::FLAG_SYS_TRIGGER))
+		return NO_STATEMENT;
+
+	FB_SIZE_T index;
+	if (m_statementMap.get(statement, index))
+		return index;
+
+	const FB_SIZE_T parent = statement->parentStatement ?
+		getStatement(statement->parentStatement) : NO_STATEMENT;
+
+	Statement& entry = m_statements.add();
+	entry.id = m_statements.getCount();
+	entry.parentId = (parent != NO_STATEMENT) ? m_statements[parent].id : 0;
+	entry.statement = statement;
+	entry.objectType = 0;
+	entry.recordSources = 0;
+
+	if (statement->procedure)
+	{
+		entry.objectType = obj_procedure;
+		entry.packageName = statement->procedure->getName().package;
+		entry.routineName = statement->procedure->getName().identifier;
+	}
+	else if (statement->function)
+	{
+		entry.objectType = obj_udf;
+		entry.packageName = statement->function->getName().package;
+		entry.routineName = statement->function->getName().identifier;
+	}
+	else if (statement->triggerName.hasData())
+	{
+		entry.objectType = obj_trigger;
+		entry.routineName = statement->triggerName;
+	}
+	else if (statement->sqlText)
+		entry.sqlText = *statement->sqlText;
+
+	index = m_statements.getCount() - 1;
+	m_statementMap.put(statement, index);
+
+	return index;
+}
+
+
+Profiler::RecordSourceStats* Profiler::getRecordSource(thread_db* tdbb, const RecordSource* rsb)
+{
+	FB_SIZE_T index;
+	if (m_recordSourceMap.get(rsb, index))
+		return &m_recordSources[index];
+
+	jrd_req* const request = tdbb->getRequest();
+
+	if (!request)
+		return NULL;
+
+	const FB_SIZE_T statement = getStatement(tdbb, request);
+
+	if (statement == NO_STATEMENT)
+		return NULL;
+
+	Statement& owner = m_statements[statement];
+
+	RecordSourceStats& stats = m_recordSources.add();
+	stats.statementId = owner.id;
+	stats.recordSourceId = ++owner.recordSources;
+	stats.openCounter = stats.openTime = 0;
+	stats.fetchCounter = stats.fetchTime = 0;
+
+	// Detailed plan of the record source and its inputs, without the leading line feed
+	rsb->print(tdbb, stats.accessPath, true, 0);
+
+	if (stats.accessPath.hasData() && stats.accessPath[0] == '\n')
+		stats.accessPath.erase(0, 1);
+
+	m_recordSourceMap.put(rsb, m_recordSources.getCount() - 1);
+
+	return &stats;
+}
+
+
+SINT64 Profiler::toMicroseconds(SINT64 ticks) const
+{
+	return (ticks / m_frequency) * 1000000 + (ticks % m_frequency) * 1000000 / m_frequency;
+}
+
+
+void Profiler::putRecords(thread_db* tdbb, SnapshotData& snapshot, RecordBuffer* buffer,
+	int relationId) const
+{
+	Record* const record = buffer->getTempRecord();
+
+	const auto putInteger = [&](int fieldId, SINT64 value)
+	{
+		snapshot.putField(tdbb, record,
+			SnapshotData::DumpField(fieldId, SnapshotData::VALUE_INTEGER, sizeof(value), &value));
+	};
+
+	const auto putString = [&](int fieldId, const char* value, ULONG length)
+	{
+		snapshot.putField(tdbb, record,
+			SnapshotData::DumpField(fieldId, SnapshotData::VALUE_STRING, length, value));
+	};
+
+	switch (relationId)
+	{
+	case rel_prof_statements:
+		for (FB_SIZE_T i = 0; i < m_statements.getCount(); i++)
+		{
+			const Statement& statement = m_statements[i];
+
+			record->nullify();
+			putInteger(f_prof_stmt_session_id, m_sessionId);
+			putInteger(f_prof_stmt_id, statement.id);
+
+			if (statement.parentId)
+				putInteger(f_prof_stmt_parent_id, statement.parentId);
+
+			if (statement.objectType)
+				putInteger(f_prof_stmt_obj_type, statement.objectType);
+
+			if (statement.packageName.hasData())
+			{
+				putString(f_prof_stmt_pkg_name, statement.packageName.c_str(),
+					statement.packageName.length());
+			}
+
+			if (statement.routineName.hasData())
+			{
+				putString(f_prof_stmt_routine_name, statement.routineName.c_str(),
+					statement.routineName.length());
+			}
+
+			if (statement.sqlText.hasData())
+			{
+				putString(f_prof_stmt_sql_text, statement.sqlText.c_str(),
+					statement.sqlText.length());
+			}
+
+			buffer->store(record);
+		}
+		break;
+
+	case rel_prof_psql_stats:
+		for (FB_SIZE_T i = 0; i < m_lines.getCount(); i++)
+		{
+			const LineStats& stats = m_lines[i];
+
+			record->nullify();
+			putInteger(f_prof_psql_stmt_id, stats.key.statementId);
+			putInteger(f_prof_psql_line, stats.key.line);
+			putInteger(f_prof_psql_column, stats.key.column);
+			putInteger(f_prof_psql_counter, stats.counter);
+
+			// Statement is still running if its time was never charged
+			if (stats.minTime != MAX_SINT64)
+			{
+				putInteger(f_prof_psql_min_time, toMicroseconds(stats.minTime));
+				putInteger(f_prof_psql_max_time, toMicroseconds(stats.maxTime));
+			}
+
+			putInteger(f_prof_psql_total_time, toMicroseconds(stats.totalTime));
+
+			buffer->store(record);
+		}
+		break;
+
+	case rel_prof_recsrc_stats:
+		for (FB_SIZE_T i = 0; i < m_recordSources.getCount(); i++)
+		{
+			const RecordSourceStats& stats = m_recordSources[i];
+
+			record->nullify();
+			putInteger(f_prof_recsrc_stmt_id, stats.statementId);
+			putInteger(f_prof_recsrc_id, stats.recordSourceId);
+			putString(f_prof_recsrc_access_path, stats.accessPath.c_str(), stats.accessPath.length());
+			putInteger(f_prof_recsrc_open_counter, stats.openCounter);
+			putInteger(f_prof_recsrc_open_time, toMicroseconds(stats.openTime));
+			putInteger(f_prof_recsrc_fetch_counter, stats.fetchCounter);
+			putInteger(f_prof_recsrc_fetch_time, toMicroseconds(stats.fetchTime));
+
+			buffer->store(record);
+		}
+		break;
+
+	default:
+		fb_assert(false);
+	}
+}
+
+
+//--------------------------------------
+
+
+RecordBuffer* ProfilerTable::getRecords(thread_db* tdbb, jrd_rel* relation)
+{
+	fb_assert(relation);
+
+	RecordBuffer* recordBuffer = getData(relation);
+	if (recordBuffer)
+		return recordBuffer;
+
+	recordBuffer = allocBuffer(tdbb, *tdbb->getDefaultPool(), relation->rel_id);
+
+	const Profiler* const profiler = tdbb->getAttachment()->att_profiler;
+
+	if (profiler)
+		profiler->putRecords(tdbb, *this, recordBuffer, relation->rel_id);
+
+	return recordBuffer;
+}
+
+
+//--------------------------------------
+
+
+void ProfilerTableScan::close(thread_db* tdbb) const
+{
+	const auto request = tdbb->getRequest();
+	const auto impure = request->getImpure<Impure>(impureOffset);
+
+	delete impure->table;
+	impure->table = nullptr;
+
+	VirtualTableScan::close(tdbb);
+}
+
+const Format* ProfilerTableScan::getFormat(thread_db* tdbb, jrd_rel* relation) const
+{
+	const auto records = getRecords(tdbb, relation);
+	return records->getFormat();
+}
+
+bool ProfilerTableScan::retrieveRecord(thread_db* tdbb, jrd_rel* relation,
+	FB_UINT64 position, Record* record) const
+{
+	const auto records = getRecords(tdbb, relation);
+	return records->fetch(position, record);
+}
+
+RecordBuffer* ProfilerTableScan::getRecords(thread_db* tdbb, jrd_rel* relation) const
+{
+	const auto request = tdbb->getRequest();
+	const auto impure = request->getImpure<Impure>(impureOffset);
+
+	if (!impure->table)
+		impure->table = FB_NEW_POOL(*tdbb->getDefaultPool()) ProfilerTable(*tdbb->getDefaultPool());
+
+	return impure->table->getRecords(tdbb, relation);
+}
+
+
+//--------------------------------------
+
+
+void ProfilerPackage::startSessionFunction(ThrowStatusExceptionWrapper* /*status*/,
+	IExternalContext* /*context*/, const void* /*in*/, StartSessionOutput::Type* out)
+{
+	thread_db* const tdbb = JRD_get_thread_data();
+	Jrd::Attachment* const attachment = tdbb->getAttachment();
+
+	Jrd::Attachment::SyncGuard guard(attachment, FB_FUNCTION);
+
+	if (!attachment->att_profiler)
+		attachment->att_profiler = FB_NEW_POOL(*attachment->att_pool) Profiler(*attachment->att_pool);
+
+	out->sessionIdNull = FB_FALSE;
+	out->sessionId = attachment->att_profiler->startSession(tdbb);
+}
+
+
+IExternalResultSet* ProfilerPackage::finishSessionProcedure(ThrowStatusExceptionWrapper* /*status*/,
+	IExternalContext* /*context*/, const void* /*in*/, void* /*out*/)
+{
+	thread_db* const tdbb = JRD_get_thread_data();
+	Jrd::Attachment* const attachment = tdbb->getAttachment();
+
+	Jrd::Attachment::SyncGuard guard(attachment, FB_FUNCTION);
+
+	if (attachment->att_profiler)
+		attachment->att_profiler->finishSession(tdbb);
+
+	return NULL;
+}
+
+
+//--------------------------------------
+
+
+ProfilerPackage::ProfilerPackage(MemoryPool& pool)
+	: SystemPackage(
+		pool,
+		"RDB$PROFILER",
+		ODS_13_2,
+		// procedures
+		{
+			SystemProcedure(
+				pool,
+				"FINISH_SESSION",
+				SystemProcedureFactory<VoidMessage, VoidMessage, finishSessionProcedure>(),
+				prc_executable,
+				// input parameters
+				{},
+				// output parameters
+				{}
+			)
+		},
+		// functions
+		{
+			SystemFunction(
+				pool,
+				"START_SESSION",
+				SystemFunctionFactory<VoidMessage, StartSessionOutput, startSessionFunction>(),
+				// parameters
+				{},
+				{fld_gen_val, false}
+			)
+		}
+	)
+{
+}
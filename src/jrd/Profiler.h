@@ -0,0 +1,235 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		Profiler.h
+ *	DESCRIPTION:	PSQL and record source profiler
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#ifndef JRD_PROFILER_H
+#define JRD_PROFILER_H
+
+#include "firebird.h"
+#include "firebird/Message.h"
+#include "../common/classes/array.h"
+#include "../common/classes/fb_string.h"
+#include "../common/classes/GenericMap.h"
+#include "../common/classes/objects_array.h"
+#include "../jrd/MetaName.h"
+#include "../jrd/Monitoring.h"
+#include "../jrd/SystemPackages.h"
+#include "../jrd/recsrc/RecordSource.h"
+
+namespace Jrd {
+
+class thread_db;
+class jrd_req;
+class JrdStatement;
+
+
+// Profiler of the attachment. While the session is active it counts
+// executions and elapsed time of PSQL statements, identified by their
+// source line and column, and of every record source of the plan tree.
+//
+// The time of a PSQL statement lasts until the next statement of the
+// same request starts or the request stalls, thus it includes the time
+// of the nested calls. The time of a record source includes the time
+// of its inputs.
+//
+// The session is controlled using RDB$PROFILER package and the collected
+// data is kept until the next session starts. It's visible through the
+// RDB$PROFILE_* virtual tables.
+
+class Profiler
+{
+	struct Statement
+	{
+		explicit Statement(MemoryPool& pool)
+			: sqlText(pool)
+		{}
+
+		SINT64 id;
+		SINT64 parentId;
+		const JrdStatement* statement;	// NULL if the statement is released
+		SSHORT objectType;				// 0 for SQL statements and blocks
+		MetaName packageName;
+		MetaName routineName;
+		Firebird::string sqlText;
+		ULONG recordSources;			// number of record sources seen so far
+	};
+
+	struct LineKey
+	{
+		SINT64 statementId;
+		ULONG line;
+		ULONG column;
+
+		bool operator>(const LineKey& other) const
+		{
+			if (statementId != other.statementId)
+				return statementId > other.statementId;
+
+			if (line != other.line)
+				return line > other.line;
+
+			return column > other.column;
+		}
+	};
+
+	struct LineStats
+	{
+		LineKey key;
+		SINT64 counter;
+		SINT64 minTime;
+		SINT64 maxTime;
+		SINT64 totalTime;
+
+		static const LineKey& generate(const LineStats& item)
+		{
+			return item.key;
+		}
+	};
+
+	struct RecordSourceStats
+	{
+		explicit RecordSourceStats(MemoryPool& pool)
+			: accessPath(pool)
+		{}
+
+		SINT64 statementId;
+		ULONG recordSourceId;
+		Firebird::string accessPath;
+		SINT64 openCounter;
+		SINT64 openTime;
+		SINT64 fetchCounter;
+		SINT64 fetchTime;
+	};
+
+	typedef Firebird::SortedArray<LineStats, Firebird::EmptyStorage<LineStats>,
+		LineKey, LineStats> LineStatsArray;
+
+	typedef Firebird::GenericMap<Firebird::Pair<Firebird::NonPooled<
+		const JrdStatement*, FB_SIZE_T> > > StatementMap;
+
+	typedef Firebird::GenericMap<Firebird::Pair<Firebird::NonPooled<
+		const RecordSource*, FB_SIZE_T> > > RecordSourceMap;
+
+	static const FB_SIZE_T NO_STATEMENT = ~FB_SIZE_T(0);
+
+public:
+	explicit Profiler(MemoryPool& pool);
+
+	SINT64 startSession(thread_db* tdbb);
+	void finishSession(thread_db* tdbb);
+
+	bool isActive() const
+	{
+		return m_active;
+	}
+
+	// Execution of the PSQL statement at the given position is started
+	void enterLine(thread_db* tdbb, jrd_req* request, ULONG line, ULONG column);
+	// The request stalls or finishes, stop timing of its current statement
+	void leaveLine(jrd_req* request);
+
+	void recordSourceOpen(thread_db* tdbb, const RecordSource* rsb, SINT64 elapsed);
+	void recordSourceFetch(thread_db* tdbb, const RecordSource* rsb, SINT64 elapsed);
+
+	void releaseStatement(const JrdStatement* statement);
+
+	void putRecords(thread_db* tdbb, SnapshotData& snapshot, RecordBuffer* buffer, int relationId) const;
+
+private:
+	FB_SIZE_T getStatement(thread_db* tdbb, jrd_req* request);
+	FB_SIZE_T getStatement(const JrdStatement* statement);
+	RecordSourceStats* getRecordSource(thread_db* tdbb, const RecordSource* rsb);
+	void charge(jrd_req* request, SINT64 now);
+	SINT64 toMicroseconds(SINT64 ticks) const;
+
+	bool m_active;
+	SINT64 m_sessionId;
+	SINT64 m_frequency;
+	Firebird::ObjectsArray<Statement> m_statements;
+	StatementMap m_statementMap;
+	LineStatsArray m_lines;
+	Firebird::ObjectsArray<RecordSourceStats> m_recordSources;
+	RecordSourceMap m_recordSourceMap;
+};
+
+
+class ProfilerTable : public SnapshotData
+{
+public:
+	explicit ProfilerTable(MemoryPool& pool)
+		: SnapshotData(pool)
+	{
+	}
+
+	RecordBuffer* getRecords(thread_db* tdbb, jrd_rel* relation);
+};
+
+
+class ProfilerTableScan : public VirtualTableScan
+{
+public:
+	ProfilerTableScan(CompilerScratch* csb, const Firebird::string& alias,
+					  StreamType stream, jrd_rel* relation)
+		: VirtualTableScan(csb, alias, stream, relation)
+	{
+		impureOffset = csb->allocImpure<Impure>();
+	}
+
+	void close(thread_db* tdbb) const override;
+
+protected:
+	const Format* getFormat(thread_db* tdbb, jrd_rel* relation) const override;
+
+	bool retrieveRecord(thread_db* tdbb, jrd_rel* relation, FB_UINT64 position,
+		Record* record) const override;
+
+private:
+	struct Impure
+	{
+		ProfilerTable* table;
+	};
+
+	RecordBuffer* getRecords(thread_db* tdbb, jrd_rel* relation) const;
+
+	ULONG impureOffset;
+};
+
+
+class ProfilerPackage : public SystemPackage
+{
+public:
+	ProfilerPackage(Firebird::MemoryPool& pool);
+
+private:
+	FB_MESSAGE(StartSessionOutput, Firebird::ThrowStatusExceptionWrapper,
+		(FB_BIGINT, sessionId)
+	);
+
+	static void startSessionFunction(Firebird::ThrowStatusExceptionWrapper* status,
+		Firebird::IExternalContext* context, const void* in, StartSessionOutput::Type* out);
+
+	static Firebird::IExternalResultSet* finishSessionProcedure(Firebird::ThrowStatusExceptionWrapper* status,
+		Firebird::IExternalContext* context, const void* in, void* out);
+};
+
+}	// namespace Jrd
+
+#endif	// JRD_PROFILER_H
@@ -23,6 +23,7 @@
 #include "firebird.h"
 #include "../common/gdsassert.h"
 #include "../jrd/req.h"
+#include "../common/utils_proto.h"
 
 #include "../jrd/RuntimeStatistics.h"
 #include "../jrd/ntrace.h"
@@ -33,6 +34,10 @@ namespace Jrd {
 
 GlobalPtr<RuntimeStatistics> RuntimeStatistics::dummy;
 
+static_assert(int(PerformanceInfo::LATCH_WAITS) == int(RuntimeStatistics::WAIT_FIRST_ITEM) &&
+	int(PerformanceInfo::WRITE_WAIT_TIME) == int(RuntimeStatistics::WAIT_LAST_ITEM),
+	"Trace wait counters do not match the runtime statistics");
+
 void RuntimeStatistics::findAndBumpRelValue(const StatType index, SLONG relation_id, SINT64 delta)
 {
 	if (rel_counts.find(relation_id, rel_last_pos))
@@ -153,4 +158,24 @@ RuntimeStatistics::Accumulator::~Accumulator()
 		m_tdbb->bumpRelStats(m_type, m_id, m_counter);
 }
 
+RuntimeStatistics::WaitTimer::WaitTimer(thread_db* tdbb, StatType type, SINT64 count)
+	: m_tdbb(tdbb), m_type(type), m_count(count),
+	  m_start(fb_utils::query_performance_counter())
+{
+	fb_assert(type >= WAIT_FIRST_ITEM && type < WAIT_LAST_ITEM);
+	fb_assert((type - WAIT_FIRST_ITEM) % 2 == 0);
+}
+
+RuntimeStatistics::WaitTimer::~WaitTimer()
+{
+	const SINT64 elapsed = fb_utils::query_performance_counter() - m_start;
+	const SINT64 frequency = fb_utils::query_performance_frequency();
+
+	// Microseconds, avoid overflow for long waits
+	const SINT64 time = (elapsed / frequency) * 1000000 + (elapsed % frequency) * 1000000 / frequency;
+
+	m_tdbb->bumpStats(m_type, m_count);
+	m_tdbb->bumpStats(StatType(m_type + 1), time);
+}
+
 } // namespace
@@ -74,6 +74,17 @@ public:
 		RECORD_RPT_READS,
 		RECORD_IMGC,
 		RECORD_LAST_ITEM = RECORD_IMGC,
+		// Every wait counter is followed by the cumulative wait time in microseconds
+		WAIT_FIRST_ITEM,
+		LATCH_WAITS = WAIT_FIRST_ITEM,
+		LATCH_WAIT_TIME,
+		LOCK_WAITS,
+		LOCK_WAIT_TIME,
+		READ_WAITS,
+		READ_WAIT_TIME,
+		WRITE_WAITS,
+		WRITE_WAIT_TIME,
+		WAIT_LAST_ITEM = WRITE_WAIT_TIME,
 		TOTAL_ITEMS		// last
 	};
 
@@ -350,6 +361,22 @@ public:
 		SINT64 m_counter;
 	};
 
+	// Measures the time spent waiting for a latch, lock or I/O
+	// and accounts it together with the number of waits
+
+	class WaitTimer
+	{
+	public:
+		WaitTimer(thread_db* tdbb, StatType type, SINT64 count = 1);
+		~WaitTimer();
+
+	private:
+		thread_db* m_tdbb;
+		StatType m_type;
+		SINT64 m_count;
+		SINT64 m_start;
+	};
+
 private:
 	void addRelCounts(const RelCounters& other, bool add);
 
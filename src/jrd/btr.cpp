@@ -60,6 +60,7 @@
 #include "../jrd/mov_proto.h"
 #include "../jrd/pag_proto.h"
 #include "../jrd/tra_proto.h"
+#include "../jrd/DeferredIndexKeys.h"
 
 using namespace Jrd;
 using namespace Ods;
@@ -696,6 +697,9 @@ void BTR_evaluate(thread_db* tdbb, const IndexRetrieval* retrieval, RecordBitmap
 	// Remove ignore_nulls flag for older ODS
 	//const Database* dbb = tdbb->getDatabase();
 
+	// Let the transaction see the keys of its bulk modifications
+	DeferredIndexKeys::flushRelation(tdbb, retrieval->irb_relation);
+
 	index_desc idx;
 	RelationPages* relPages = retrieval->irb_relation->getPages(tdbb);
 	WIN window(relPages->rel_pg_space_id, -1);
@@ -77,10 +77,6 @@ using namespace Firebird;
 IMPLEMENT_TRACE_ROUTINE(cch_trace, "CCH")
 #endif
 
-#ifdef SUPERSERVER_V2
-#define CACHE_READER
-#endif
-
 
 static inline void PAGE_LOCK_RELEASE(thread_db* tdbb, BufferControl* bcb, Lock* lock)
 {
@@ -119,18 +115,15 @@ static void adjust_scan_count(WIN* window, bool mustRead);
 static BufferDesc* alloc_bdb(thread_db*, BufferControl*, UCHAR **);
 static Lock* alloc_page_lock(Jrd::thread_db*, BufferDesc*);
 static int blocking_ast_bdb(void*);
-#ifdef CACHE_READER
-static void prefetch_epilogue(Prefetch*, FbStatusVector *);
-static void prefetch_init(Prefetch*, thread_db*);
-static void prefetch_io(Prefetch*, FbStatusVector *);
-static void prefetch_prologue(Prefetch*, SLONG *);
-#endif
 static void check_precedence(thread_db*, WIN*, PageNumber);
 static void clear_precedence(thread_db*, BufferDesc*);
 static BufferDesc* dealloc_bdb(BufferDesc*);
 static void down_grade(thread_db*, BufferDesc*, int high = 0);
 static bool expand_buffers(thread_db*, ULONG);
 static BufferDesc* find_buffer(BufferControl* bcb, const PageNumber page, bool findPending);
+static BufferDesc* find_hashed(BufferControl* bcb, const PageNumber page);
+static void hash_insert(BufferControl* bcb, BufferDesc* bdb, const PageNumber page);
+static void hash_remove(BufferControl* bcb, BufferDesc* bdb);
 static BufferDesc* get_buffer(thread_db*, const PageNumber, SyncType, int);
 static int get_related(BufferDesc*, PagesArray&, int, const ULONG);
 static ULONG get_prec_walk_mark(BufferControl*);
@@ -139,12 +132,15 @@ static LockState lock_buffer(thread_db*, BufferDesc*, const SSHORT, const SCHAR)
 static ULONG memory_init(thread_db*, BufferControl*, SLONG);
 static void page_validation_error(thread_db*, win*, SSHORT);
 static void purgePrecedence(BufferControl*, BufferDesc*);
+static bool read_batch(thread_db*, WIN*, FB_SIZE_T);
 static SSHORT related(BufferDesc*, const BufferDesc*, SSHORT, const ULONG);
 static bool writeable(BufferDesc*);
 static bool is_writeable(BufferDesc*, const ULONG);
 static int write_buffer(thread_db*, BufferDesc*, const PageNumber, const bool, FbStatusVector* const,
 	const bool);
 static bool write_page(thread_db*, BufferDesc*, FbStatusVector* const, const bool);
+static void page_written(thread_db*, BufferDesc*);
+static bool write_run(thread_db*, BufferDesc**, FB_SIZE_T, const bool, FbStatusVector* const);
 static bool set_diff_page(thread_db*, BufferDesc*);
 static void clear_dirty_flag_and_nbak_state(thread_db*, BufferDesc*);
 
@@ -187,6 +183,13 @@ static void flushDirty(thread_db* tdbb, SLONG transaction_mask, const bool sys_o
 static void flushAll(thread_db* tdbb, USHORT flush_flag);
 static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, FB_SIZE_T count);
 
+// Maximum number of adjacent dirty pages written by single I/O request
+const FB_SIZE_T MAX_WRITE_RUN = 64;
+typedef HalfStaticArray<BufferDesc*, MAX_WRITE_RUN> BufferDescArray;
+
+static void flushRun(thread_db* tdbb, BufferDescArray& run, const bool release_flag,
+	const bool write_thru, FbStatusVector* const status);
+
 static void recentlyUsed(BufferDesc* bdb);
 static void requeueRecentlyUsed(BufferControl* bcb);
 
@@ -1026,7 +1029,7 @@ void CCH_forget_page(thread_db* tdbb, WIN* window)
 	// remove from hash table and put into empty list
 	{
 		SyncLockGuard bcbSync(&bcb->bcb_syncObject, SYNC_EXCLUSIVE, FB_FUNCTION);
-		QUE_DELETE(bdb->bdb_que);
+		hash_remove(bcb, bdb);
 		QUE_INSERT(bcb->bcb_empty, bdb->bdb_que);
 	}
 
@@ -1236,6 +1239,27 @@ void CCH_flush_ast(thread_db* tdbb)
 	}
 }
 
+void CCH_flush_group(thread_db* tdbb, ULONG transaction_mask)
+{
+/**************************************
+ *
+ *	C C H _ f l u s h _ g r o u p
+ *
+ **************************************
+ *
+ * Functional description
+ *	Flush buffers modified by a group of committing
+ *	transactions, see GroupCommit. Zero mask means
+ *	pages modified by system transaction only.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+
+	flushDirty(tdbb, transaction_mask, !transaction_mask);
+
+	SDW_check(tdbb);
+}
+
 bool CCH_free_page(thread_db* tdbb)
 {
 /**************************************
@@ -1308,11 +1332,7 @@ void CCH_get_related(thread_db* tdbb, PageNumber page, PagesArray &lowPages)
 	Database* dbb = tdbb->getDatabase();
 	BufferControl* bcb = dbb->dbb_bcb;
 
-	Sync bcbSync(&bcb->bcb_syncObject, "CCH_get_related");
-	bcbSync.lock(SYNC_SHARED);
-
-	BufferDesc* bdb = find_buffer(bcb, page, false);
-	bcbSync.unlock();
+	BufferDesc* bdb = find_hashed(bcb, page);
 
 	if (bdb)
 	{
@@ -1528,20 +1548,31 @@ void CCH_init2(thread_db* tdbb)
 	Database* dbb = tdbb->getDatabase();
 	BufferControl* bcb = dbb->dbb_bcb;
 
-	if (!(bcb->bcb_flags & BCB_exclusive) || (bcb->bcb_flags & (BCB_cache_writer | BCB_writer_start)))
+	if (!(bcb->bcb_flags & BCB_exclusive))
 		return;
 
-#ifdef CACHE_READER
-	if (gds__thread_start(cache_reader, dbb, THREAD_high, 0, 0))
+	if (!(bcb->bcb_flags & (BCB_cache_reader | BCB_reader_start)) &&
+		dbb->dbb_config->getReadAheadPages())
 	{
-		ERR_bugcheck_msg("cannot start thread");
-	}
+		// reader startup in progress
+		bcb->bcb_flags |= BCB_reader_start;
+		bcb->bcb_prefetch_pages = dbb->dbb_config->getReadAheadPages();
 
-	{ // scope
-		Database::Checkout dcoHolder(dbb, FB_FUNCTION);
-		dbb->dbb_reader_init.enter();
+		try
+		{
+			bcb->bcb_reader_fini.run(bcb);
+			bcb->bcb_reader_init.enter();
+		}
+		catch (const Exception& ex)
+		{
+			// Read-ahead is an optimization only, continue without it
+			bcb->bcb_flags &= ~BCB_reader_start;
+			bcb->exceptionHandler(ex, BufferControl::cache_reader);
+		}
 	}
-#endif
+
+	if (bcb->bcb_flags & (BCB_cache_writer | BCB_writer_start))
+		return;
 
 	const Attachment* att = tdbb->getAttachment();
 	if (!(dbb->dbb_flags & DBB_read_only) && !(att->att_flags & ATT_security_db))
@@ -1733,8 +1764,7 @@ void CCH_precedence(thread_db* tdbb, WIN* window, PageNumber page)
 }
 
 
-#ifdef CACHE_READER
-void CCH_prefetch(thread_db* tdbb, SLONG* pages, SSHORT count)
+void CCH_prefetch(thread_db* tdbb, USHORT pageSpaceId, const ULONG* pages, FB_SIZE_T count)
 {
 /**************************************
  *
@@ -1743,15 +1773,14 @@ void CCH_prefetch(thread_db* tdbb, SLONG* pages, SSHORT count)
  **************************************
  *
  * Functional description
- *	Given a vector of pages, set corresponding bits
- *	in global prefetch bitmap. Initiate an asynchronous
- *	I/O and get the cache reader reading in our behalf
- *	as well.
+ *	Given a vector of pages, queue them to be read into
+ *	the cache by the cache reader thread asynchronously,
+ *	ahead of their use by a sequential scan.
  *
  **************************************/
 	SET_TDBB(tdbb);
-	Database* dbb = tdbb->getDatabase();
-	BufferControl* bcb = dbb->dbb_bcb;
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
 
 	if (!count || !(bcb->bcb_flags & BCB_cache_reader))
 	{
@@ -1759,60 +1788,227 @@ void CCH_prefetch(thread_db* tdbb, SLONG* pages, SSHORT count)
 		return;
 	}
 
-	// Switch default pool to permanent pool for setting bits in prefetch bitmap.
-	Jrd::ContextPoolHolder context(tdbb, bcb->bcb_bufferpool);
+	// Don't let the prefetched pages flush out the whole cache
+
+	const FB_SIZE_T maxQueue = bcb->bcb_count / 4;
+	bool queued = false;
+
+	{ // scope
+		MutexLockGuard guard(bcb->bcb_prefetch_mutex, FB_FUNCTION);
+
+		for (const ULONG* const end = pages + count; pages < end; pages++)
+		{
+			if (bcb->bcb_prefetch.getCount() >= maxQueue)
+				break;
+
+			if (*pages)
+			{
+				bcb->bcb_prefetch.add(PageNumber(pageSpaceId, *pages));
+				queued = true;
+			}
+		}
+	}
+
+	if (queued && !(bcb->bcb_flags & BCB_reader_active))
+		bcb->bcb_reader_sem.release();
+}
+
+
+bool CCH_prefetch_pages(thread_db* tdbb)
+{
+/**************************************
+ *
+ *	C C H _ p r e f e t c h _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Check the prefetch queue for a set of pages
+ *	and read them into the cache. Return false if
+ *	the queue is empty. Pages which are in the cache
+ *	already or latched by someone else are skipped.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
+
+	HalfStaticArray<PageNumber, 64> pages;
+
+	{ // scope
+		MutexLockGuard guard(bcb->bcb_prefetch_mutex, FB_FUNCTION);
 
-	// The global prefetch bitmap is the key to the I/O coalescense mechanism which dovetails
-	// all thread prefetch requests to minimize sequential I/O requests.
-	// It also enables multipage I/O by implicitly sorting page vector requests.
+		if (bcb->bcb_prefetch.isEmpty())
+			return false;
+
+		pages.assign(bcb->bcb_prefetch.begin(), bcb->bcb_prefetch.getCount());
+		bcb->bcb_prefetch.clear();
+	}
+
+	// Latch the buffers of pages not in the cache yet
 
-	SLONG first_page = 0;
-	for (const SLONG* const end = pages + count; pages < end;)
+	HalfStaticArray<win_for_array, 64> windows;
+
+	for (const PageNumber* page = pages.begin(); page < pages.end(); page++)
 	{
-		const SLONG page = *pages++;
-		if (page)
+		if (!(bcb->bcb_flags & BCB_cache_reader) || (dbb->dbb_flags & DBB_suspend_bgio))
+			break;
+
+		win_for_array window;
+		window.win_page = *page;
+
+		try
+		{
+			const LockState lockState = CCH_fetch_lock(tdbb, &window, LCK_read, LCK_NO_WAIT, pag_undefined);
+
+			if (lockState == lsLocked)
+				windows.add(window);
+			else if (lockState == lsLockedHavePage)
+				CCH_RELEASE(tdbb, &window);
+		}
+		catch (const Exception&)
 		{
-			SBM_set(tdbb, &bcb->bcb_prefetch, page);
-			if (!first_page)
-				first_page = page;
+			tdbb->tdbb_status_vector->init();
 		}
 	}
 
-	// Not likely that the caller's page vector was empty but check anyway.
+	if (windows.isEmpty())
+		return true;
+
+	// Read them at once if possible, else one by one
 
-	if (first_page)
+	try
 	{
-		prf prefetch;
+		if (!read_batch(tdbb, windows.begin(), windows.getCount()))
+		{
+			for (WIN* window = windows.begin(); window < windows.end(); window++)
+			{
+				CCH_fetch_page(tdbb, window, true);
+				window->win_bdb->bdb_flags |= BDB_prefetch;
+			}
+		}
 
-		prefetch_init(&prefetch, tdbb);
-		prefetch_prologue(&prefetch, &first_page);
-		prefetch_io(&prefetch, tdbb->tdbb_status_vector);
-		prefetch_epilogue(&prefetch, tdbb->tdbb_status_vector);
+		// Unused prefetched pages are the first candidates for replacement
+
+		for (WIN* window = windows.begin(); window < windows.end(); window++)
+			CCH_RELEASE_TAIL(tdbb, window);
+	}
+	catch (const Exception&)
+	{
+		// Buffers are released by CCH_unwind already. If the page is
+		// really unreadable its requester will get the error itself.
+		tdbb->tdbb_status_vector->init();
 	}
+
+	return true;
 }
 
 
-bool CCH_prefetch_pages(thread_db* tdbb)
+static bool read_batch(thread_db* tdbb, WIN* windows, FB_SIZE_T count)
 {
 /**************************************
  *
- *	C C H _ p r e f e t c h _ p a g e s
+ *	r e a d _ b a t c h
  *
  **************************************
  *
  * Functional description
- *	Check the prefetch bitmap for a set
- *	of pages and read them into the cache.
+ *	Read pages of the buffers latched by the cache reader using
+ *	single batched I/O request. Return false if it's not possible,
+ *	the pages should be read one by one then. A page which can't
+ *	be decrypted is left unread, its requester will read it again.
  *
  **************************************/
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
 
-	// Placeholder to be implemented when predictive prefetch is
-	// enabled. This is called by VIO/garbage_collector() when it
-	// is idle to help satisfy the prefetch demand.
+	if (count < 2)
+		return false;
 
-	return false;
+	const USHORT pageSpaceId = windows[0].win_page.getPageSpaceID();
+	PageSpace* const pageSpace = dbb->dbb_page_manager.findPageSpace(pageSpaceId);
+	fb_assert(pageSpace);
+
+	if (pageSpace->isTemporary())
+		return false;
+
+	for (FB_SIZE_T n = 1; n < count; n++)
+	{
+		if (windows[n].win_page.getPageSpaceID() != pageSpaceId)
+			return false;
+	}
+
+	// Pages could be in the difference file, don't bother with it
+
+	BackupManager::StateReadGuard stateGuard(tdbb);
+
+	if (dbb->dbb_backup_manager->getState() != Ods::hdr_nbak_normal)
+		return false;
+
+	HalfStaticArray<PageIo, 64> pages;
+	PageIo* const io = pages.getBuffer(count);
+
+	for (FB_SIZE_T n = 0; n < count; n++)
+	{
+		io[n].pio_bdb = windows[n].win_bdb;
+		io[n].pio_page = windows[n].win_bdb->bdb_buffer;
+	}
+
+	FbStatusVector* const status = tdbb->tdbb_status_vector;
+
+	if (!PIO_read_pages(tdbb, pageSpace->file, io, count, status))
+	{
+		// Let the regular read path handle errors and shadows
+		status->init();
+		return false;
+	}
+
+	// Pages are in memory already, let crypto manager decrypt them.
+	// Read the page again if it asks for it due to change of crypt state.
+
+	class Pio : public CryptoManager::IOCallback
+	{
+	public:
+		Pio(jrd_file* f, BufferDesc* b)
+			: file(f), bdb(b), loaded(true)
+		{ }
+
+		bool callback(thread_db* tdbb, FbStatusVector* status, Ods::pag* page)
+		{
+			if (loaded)
+			{
+				loaded = false;
+				return true;
+			}
+
+			return PIO_read(tdbb, file, bdb, page, status);
+		}
+
+	private:
+		jrd_file* file;
+		BufferDesc* bdb;
+		bool loaded;
+	};
+
+	for (FB_SIZE_T n = 0; n < count; n++)
+	{
+		BufferDesc* const bdb = windows[n].win_bdb;
+		Pio pio(pageSpace->file, bdb);
+
+		if (!dbb->dbb_crypto_manager->read(tdbb, status, bdb->bdb_buffer, &pio))
+		{
+			status->init();
+			continue;
+		}
+
+		tdbb->bumpStats(RuntimeStatistics::PAGE_READS);
+		bdb->bdb_incarnation = ++bcb->bcb_page_incarnation;
+		bdb->bdb_flags &= ~(BDB_not_valid | BDB_read_pending);
+		bdb->bdb_flags |= BDB_prefetch;
+	}
+
+	return true;
 }
-#endif // CACHE_READER
 
 
 bool set_diff_page(thread_db* tdbb, BufferDesc* bdb)
@@ -1995,7 +2191,8 @@ void CCH_release(thread_db* tdbb, WIN* window, const bool release_tail)
 
 		if (release_tail)
 		{
-			if ((window->win_flags & WIN_large_scan && bdb->bdb_scan_count > 0 &&
+			if ((bdb->bdb_flags & BDB_prefetch) ||
+				(window->win_flags & WIN_large_scan && bdb->bdb_scan_count > 0 &&
 					!(--bdb->bdb_scan_count) && !(bdb->bdb_flags & BDB_garbage_collect)) ||
 				(window->win_flags & WIN_garbage_collector && bdb->bdb_flags & BDB_garbage_collect &&
 					!bdb->bdb_scan_count))
@@ -2112,16 +2309,19 @@ void CCH_shutdown(thread_db* tdbb)
 	if (!bcb)
 		return;
 
-#ifdef CACHE_READER
+	// Wait for cache reader startup to complete
+
+	while (bcb->bcb_flags & BCB_reader_start)
+		Thread::yield();
+
 	// Shutdown the dedicated cache reader for this database
 
 	if (bcb->bcb_flags & BCB_cache_reader)
 	{
 		bcb->bcb_flags &= ~BCB_cache_reader;
-		dbb->dbb_reader_sem.release();
-		dbb->dbb_reader_fini.enter();
+		bcb->bcb_reader_sem.release(); // Wake up running thread
+		bcb->bcb_reader_fini.waitForCompletion();
 	}
-#endif
 
 	// Wait for cache writer startup to complete
 
@@ -2440,6 +2640,15 @@ static void adjust_scan_count(WIN* window, bool mustRead)
  **************************************/
 	BufferDesc* bdb = window->win_bdb;
 
+	// A page prefetched by the cache reader is handled as if it was
+	// read on behalf of its first requester.
+
+	if (bdb->bdb_flags & BDB_prefetch)
+	{
+		bdb->bdb_flags &= ~BDB_prefetch;
+		mustRead = true;
+	}
+
 	// If a page was read or prefetched on behalf of a large scan
 	// then load the window scan count into the buffer descriptor.
 	// This buffer scan count is decremented by releasing a buffer
@@ -2450,7 +2659,7 @@ static void adjust_scan_count(WIN* window, bool mustRead)
 
 	if (window->win_flags & WIN_large_scan)
 	{
-		if (mustRead || (bdb->bdb_flags & BDB_prefetch) || bdb->bdb_scan_count < 0)
+		if (mustRead || bdb->bdb_scan_count < 0)
 			bdb->bdb_scan_count = window->win_scans;
 	}
 	else if (window->win_flags & WIN_garbage_collector)
@@ -2737,6 +2946,10 @@ static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, F
 
 	MarkIterator<BufferDesc*> iter(begin, count);
 
+	// Adjacent pages ready to be written are collected into the run
+	// and written together. Buffers of the run are kept latched.
+	BufferDescArray run;
+
 	FB_SIZE_T written = 0;
 	bool writeAll = false;
 
@@ -2750,12 +2963,31 @@ static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, F
 			if (!bdb)
 				continue;
 
-			bdb->addRef(tdbb, release_flag ? SYNC_EXCLUSIVE : SYNC_SHARED);
+			const SyncType syncType = release_flag ? SYNC_EXCLUSIVE : SYNC_SHARED;
+
+			// Don't wait for the buffer while holding the buffers of the run,
+			// its owner could wait for one of them. Write the run out first.
+
+			if (run.hasData() && !bdb->addRefConditional(tdbb, syncType))
+				flushRun(tdbb, run, release_flag, write_thru, status);
+
+			if (run.isEmpty())
+				bdb->addRef(tdbb, syncType);
 
 			BufferControl* bcb = bdb->bdb_bcb;
 			if (!writeAll)
+			{
 				purgePrecedence(bcb, bdb);
 
+				// The page could wait for the pages of the run
+
+				if (QUE_NOT_EMPTY(bdb->bdb_higher) && run.hasData())
+				{
+					flushRun(tdbb, run, release_flag, write_thru, status);
+					purgePrecedence(bcb, bdb);
+				}
+			}
+
 			if (writeAll || QUE_EMPTY(bdb->bdb_higher))
 			{
 				if (release_flag)
@@ -2766,6 +2998,28 @@ static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, F
 
 				if (!all_flag || bdb->bdb_flags & (BDB_db_dirty | BDB_dirty))
 				{
+					if (!writeAll)
+					{
+						if (run.hasData())
+						{
+							const PageNumber& last = run.back()->bdb_page;
+
+							if (run.getCount() == MAX_WRITE_RUN ||
+								last.getPageSpaceID() != bdb->bdb_page.getPageSpaceID() ||
+								last.getPageNum() + 1 != bdb->bdb_page.getPageNum())
+							{
+								flushRun(tdbb, run, release_flag, write_thru, status);
+							}
+						}
+
+						run.add(bdb);
+
+						iter.mark();
+						found = true;
+						written++;
+						continue;
+					}
+
 					if (!write_buffer(tdbb, bdb, bdb->bdb_page, write_thru, status, true))
 						CCH_unwind(tdbb, true);
 				}
@@ -2787,6 +3041,9 @@ static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, F
 			}
 		}
 
+		if (run.hasData())
+			flushRun(tdbb, run, release_flag, write_thru, status);
+
 		if (!found)
 			writeAll = true;
 
@@ -2797,7 +3054,29 @@ static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, F
 }
 
 
-#ifdef CACHE_READER
+// Write pages of the run collected by flushPages and release their buffers
+static void flushRun(thread_db* tdbb, BufferDescArray& run, const bool release_flag,
+	const bool write_thru, FbStatusVector* const status)
+{
+	if (!write_run(tdbb, run.begin(), run.getCount(), write_thru, status))
+		CCH_unwind(tdbb, true);
+
+	for (BufferDesc** ptr = run.begin(); ptr < run.end(); ptr++)
+	{
+		BufferDesc* const bdb = *ptr;
+
+		// release lock before losing control over bdb, it prevents
+		// concurrent operations on released lock
+		if (release_flag)
+			PAGE_LOCK_RELEASE(tdbb, bdb->bdb_bcb, bdb->bdb_lock);
+
+		bdb->release(tdbb, !release_flag && !(bdb->bdb_flags & BDB_dirty));
+	}
+
+	run.clear();
+}
+
+
 void BufferControl::cache_reader(BufferControl* bcb)
 {
 /**************************************
@@ -2808,148 +3087,91 @@ void BufferControl::cache_reader(BufferControl* bcb)
  *
  * Functional description
  *	Prefetch pages into cache for sequential scans.
- *	Use asynchronous I/O to keep two prefetch requests
- *	busy at a time.
  *
  **************************************/
-	Database* dbb = bcb->bcb_database;
-	Database::SyncGuard dsGuard(dbb);
-
 	FbLocalStatus status_vector;
+	Database* const dbb = bcb->bcb_database;
 
-	// Establish a thread context.
-	ThreadContextHolder tdbb(status_vector);
-
-	// Dummy attachment needed for lock owner identification.
-	tdbb->setDatabase(dbb);
-	Jrd::Attachment* const attachment = Attachment::create(dbb, nullptr);
-	tdbb->setAttachment(attachment);
-	attachment->att_filename = dbb->dbb_filename;
-	Jrd::ContextPoolHolder context(tdbb, bcb->bcb_bufferpool);
+	try
+	{
+		UserId user;
+		user.setUserName("Cache Reader");
 
-	// This try block is specifically to protect the LCK_init call: if
-	// LCK_init fails we won't be able to accomplish anything anyway, so
-	// return, unlike the other try blocks further down the page.
+		Jrd::Attachment* const attachment = Jrd::Attachment::create(dbb, nullptr);
+		RefPtr<SysStableAttachment> sAtt(FB_NEW SysStableAttachment(attachment));
+		attachment->setStable(sAtt);
+		attachment->att_filename = dbb->dbb_filename;
+		attachment->att_user = &user;
 
-	BufferControl* bcb = NULL;
+		BackgroundContextHolder tdbb(dbb, attachment, &status_vector, FB_FUNCTION);
 
-	try {
+		try
+		{
+			LCK_init(tdbb, LCK_OWNER_attachment);
+			PAG_header(tdbb, true);
+			PAG_attachment_id(tdbb);
+			TRA_init(attachment);
 
-		LCK_init(tdbb, LCK_OWNER_attachment);
-		TRA_init(attachment);
-		bcb = dbb->dbb_bcb;
-		bcb->bcb_flags |= BCB_cache_reader;
-		dbb->dbb_reader_init.post();	// Notify our creator that we have started
-	}
-	catch (const Firebird::Exception& ex)
-	{
-		ex.stuffException(status_vector);
-		iscDbLogStatus(dbb->dbb_filename.c_str(), status_vector);
-		return 0;
-	}
+			Monitoring::publishAttachment(tdbb);
 
-	try {
+			sAtt->initDone();
 
-	// Set up dual prefetch control blocks to keep multiple prefetch
-	// requests active at a time. Also helps to prevent the cache reader
-	// from becoming dedicated or locked into a single request's prefetch demands.
+			bcb->bcb_flags |= BCB_cache_reader;
+			bcb->bcb_flags &= ~BCB_reader_start;
 
-	prf prefetch1, prefetch2;
-	prefetch_init(&prefetch1, tdbb);
-	prefetch_init(&prefetch2, tdbb);
+			// Notify our creator that we have started
+			bcb->bcb_reader_init.release();
 
-	while (bcb->bcb_flags & BCB_cache_reader)
-	{
-		bcb->bcb_flags |= BCB_reader_active;
-		bool found = false;
-		SLONG starting_page = -1;
-		prf* next_prefetch = &prefetch1;
+			while (bcb->bcb_flags & BCB_cache_reader)
+			{
+				bcb->bcb_flags |= BCB_reader_active;
 
-		if (dbb->dbb_flags & DBB_suspend_bgio)
+				if (!(dbb->dbb_flags & DBB_suspend_bgio) && CCH_prefetch_pages(tdbb))
+				{
+					// If there's more work to do voluntarily ask to be rescheduled.
+					JRD_reschedule(tdbb, true);
+				}
+				else
+				{
+					bcb->bcb_flags &= ~BCB_reader_active;
+					EngineCheckout cout(tdbb, FB_FUNCTION);
+					bcb->bcb_reader_sem.tryEnter(10);
+				}
+			}
+		}
+		catch (const Firebird::Exception& ex)
 		{
-			Database::Checkout dcoHolder(dbb, FB_FUNCTION);
-			dbb->dbb_reader_sem.tryEnter(10);
-			continue;
+			ex.stuffException(&status_vector);
+			iscDbLogStatus(dbb->dbb_filename.c_str(), &status_vector);
+			// continue execution to clean up
 		}
 
-		// Make a pass thru the global prefetch bitmap looking for something
-		// to read. When the entire bitmap has been scanned and found to be
-		// empty then wait for new requests.
+		Monitoring::cleanupAttachment(tdbb);
+		attachment->releaseLocks(tdbb);
+		LCK_fini(tdbb, LCK_OWNER_attachment);
 
-		do {
-			if (!(prefetch1.prf_flags & PRF_active) &&
-				SBM_next(bcb->bcb_prefetch, &starting_page, RSE_get_forward))
-			{
-				found = true;
-				prefetch_prologue(&prefetch1, &starting_page);
-				prefetch_io(&prefetch1, status_vector);
-			}
+		attachment->releaseRelations(tdbb);
+	}	// try
+	catch (const Firebird::Exception& ex)
+	{
+		bcb->exceptionHandler(ex, cache_reader);
+	}
 
-			if (!(prefetch2.prf_flags & PRF_active) &&
-				SBM_next(bcb->bcb_prefetch, &starting_page, RSE_get_forward))
-			{
-				found = true;
-				prefetch_prologue(&prefetch2, &starting_page);
-				prefetch_io(&prefetch2, status_vector);
-			}
+	bcb->bcb_flags &= ~(BCB_cache_reader | BCB_reader_active);
 
-			prf* post_prefetch = next_prefetch;
-			next_prefetch = (post_prefetch == &prefetch1) ? &prefetch2 : &prefetch1;
-
-			if (post_prefetch->prf_flags & PRF_active)
-				prefetch_epilogue(post_prefetch, status_vector);
-
-			if (found)
-			{
-				// If the cache writer or garbage collector is idle, put
-				// them to work prefetching pages.
-#ifdef CACHE_WRITER
-				if ((bcb->bcb_flags & BCB_cache_writer) && !(bcb->bcb_flags & BCB_writer_active))
-					dbb_writer_sem.release();
-#endif
-#ifdef GARBAGE_THREAD
-				if ((dbb->dbb_flags & DBB_garbage_collector) && !(dbb->dbb_flags & DBB_gc_active))
-					dbb->dbb_gc_sem.release();
-#endif
-			}
-		} while (prefetch1.prf_flags & PRF_active || prefetch2.prf_flags & PRF_active);
-
-		// If there's more work to do voluntarily ask to be rescheduled.
-		// Otherwise, wait for event notification.
-		BufferDesc* bdb;
-		if (found)
-			JRD_reschedule(tdbb, true);
-		else if (bcb->bcb_flags & BCB_free_pending &&
-			(bdb = get_buffer(tdbb, FREE_PAGE, LATCH_none, 1)))
-		{
-			// In our spare time, help writer clean the cache.
-
-			write_buffer(tdbb, bdb, bdb->bdb_page, true, status_vector, true);
-		}
-		else
+	try
+	{
+		if (bcb->bcb_flags & BCB_reader_start)
 		{
-			bcb->bcb_flags &= ~BCB_reader_active;
-			Database::Checkout dcoHolder(dbb, FB_FUNCTION);
-			dbb->dbb_reader_sem.tryEnter(10);
+			bcb->bcb_flags &= ~BCB_reader_start;
+			bcb->bcb_reader_init.release();
 		}
-		bcb = dbb->dbb_bcb;
 	}
-
-	LCK_fini(tdbb, LCK_OWNER_attachment);
-	Jrd::Attachment::destroy(attachment);	// no need saving warning error strings here
-	tdbb->setAttachment(NULL);
-	bcb->bcb_flags &= ~BCB_cache_reader;
-	dbb->dbb_reader_fini.post();
-
-	}	// try
 	catch (const Firebird::Exception& ex)
 	{
-		ex.stuffException(status_vector);
-		iscDbLogStatus(dbb->dbb_filename.c_str(), status_vector);
+		bcb->exceptionHandler(ex, cache_reader);
 	}
-	return 0;
 }
-#endif
 
 
 void BufferControl::cache_writer(BufferControl* bcb)
@@ -3000,9 +3222,6 @@ void BufferControl::cache_writer(BufferControl* bcb)
 			while (bcb->bcb_flags & BCB_cache_writer)
 			{
 				bcb->bcb_flags |= BCB_writer_active;
-#ifdef CACHE_READER
-				SLONG starting_page = -1;
-#endif
 
 				if (dbb->dbb_flags & DBB_suspend_bgio)
 				{
@@ -3033,19 +3252,6 @@ void BufferControl::cache_writer(BufferControl* bcb)
 
 				if ((bcb->bcb_flags & BCB_free_pending) || dbb->dbb_flush_cycle)
 					JRD_reschedule(tdbb, true);
-#ifdef CACHE_READER
-				else if (SBM_next(bcb->bcb_prefetch, &starting_page, RSE_get_forward))
-				{
-					// Prefetch some pages in our spare time and in the process
-					// garbage collect the prefetch bitmap.
-					prf prefetch;
-
-					prefetch_init(&prefetch, tdbb);
-					prefetch_prologue(&prefetch, &starting_page);
-					prefetch_io(&prefetch, status_vector);
-					prefetch_epilogue(&prefetch, status_vector);
-				}
-#endif
 				else
 				{
 					bcb->bcb_flags &= ~BCB_writer_active;
@@ -3150,11 +3356,7 @@ static void check_precedence(thread_db* tdbb, WIN* window, PageNumber page)
 
 	// Start by finding the buffer containing the high priority page
 
-	Sync bcbSync(&bcb->bcb_syncObject, "check_precedence");
-	bcbSync.lock(SYNC_SHARED);
-
-	BufferDesc* high = find_buffer(bcb, page, false);
-	bcbSync.unlock();
+	BufferDesc* high = find_hashed(bcb, page);
 
 	if (!high)
 		return;
@@ -3555,6 +3757,11 @@ static bool expand_buffers(thread_db* tdbb, ULONG number)
 	bcb_repeat* const new_rpt = FB_NEW_POOL(*bcb->bcb_bufferpool) bcb_repeat[number];
 	bcb_repeat* const old_rpt = bcb->bcb_rpt;
 
+	// Every hash chain is going to be rebuilt, lock all of them
+
+	for (ULONG i = 0; i < BufferControl::HASH_STRIPES; i++)
+		bcb->bcb_syncHash[i].lock(NULL, SYNC_EXCLUSIVE, FB_FUNCTION);
+
 	bcb->bcb_rpt = new_rpt;
 	bcb->bcb_count = number;
 	bcb->bcb_free_minimum = (SSHORT) MIN(number / 4, 128);	/* 25% clean page reserve */
@@ -3586,6 +3793,9 @@ static bool expand_buffers(thread_db* tdbb, ULONG number)
 		}
 	}
 
+	for (ULONG i = 0; i < BufferControl::HASH_STRIPES; i++)
+		bcb->bcb_syncHash[i].unlock(NULL, SYNC_EXCLUSIVE);
+
 	// Allocate new buffer descriptor blocks
 
 	ULONG num_in_seg = 0;
@@ -3643,6 +3853,56 @@ static BufferDesc* find_buffer(BufferControl* bcb, const PageNumber page, bool f
 }
 
 
+static inline SyncObject* hash_stripe(BufferControl* bcb, const PageNumber page, ULONG count)
+{
+	return &bcb->bcb_syncHash[(page.getPageNum() % count) % BufferControl::HASH_STRIPES];
+}
+
+
+static BufferDesc* find_hashed(BufferControl* bcb, const PageNumber page)
+{
+/**************************************
+ *
+ *	f i n d _ h a s h e d
+ *
+ **************************************
+ *
+ * Functional description
+ *	Look for the buffer of the page in the hash table
+ *	locking the stripe of its hash chain only.
+ *
+ **************************************/
+	while (true)
+	{
+		const ULONG count = bcb->bcb_count;
+		SyncLockGuard hashSync(hash_stripe(bcb, page, count), SYNC_SHARED, FB_FUNCTION);
+
+		// Hash chains are rebuilt when the cache is expanded
+		if (count == bcb->bcb_count)
+			return find_buffer(bcb, page, false);
+	}
+}
+
+
+static void hash_insert(BufferControl* bcb, BufferDesc* bdb, const PageNumber page)
+{
+	fb_assert(bcb->bcb_syncObject.ourExclusiveLock());
+
+	SyncLockGuard hashSync(hash_stripe(bcb, page, bcb->bcb_count), SYNC_EXCLUSIVE, FB_FUNCTION);
+	QUE mod_que = &bcb->bcb_rpt[page.getPageNum() % bcb->bcb_count].bcb_page_mod;
+	QUE_INSERT(*mod_que, bdb->bdb_que);
+}
+
+
+static void hash_remove(BufferControl* bcb, BufferDesc* bdb)
+{
+	fb_assert(bcb->bcb_syncObject.ourExclusiveLock());
+
+	SyncLockGuard hashSync(hash_stripe(bcb, bdb->bdb_page, bcb->bcb_count), SYNC_EXCLUSIVE, FB_FUNCTION);
+	QUE_DELETE(bdb->bdb_que);
+}
+
+
 static LatchState latch_buffer(thread_db* tdbb, Sync &bcbSync, BufferDesc *bdb,
 							   const PageNumber page, SyncType syncType, int wait)
 {
@@ -3730,14 +3990,27 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 	Database* dbb = tdbb->getDatabase();
 	BufferControl* bcb = dbb->dbb_bcb;
 
-	Sync bcbSync(&bcb->bcb_syncObject, "get_buffer");
 	if (page != FREE_PAGE)
 	{
-		bcbSync.lock(SYNC_SHARED);
-		BufferDesc* bdb = find_buffer(bcb, page, true);
-		while (bdb)
+		// Look for the page in its hash chain locking the stripe of the chain
+		// only. Pages which are not there, including ones being read into the
+		// replaced buffers, are looked up again below under bcb_syncObject.
+
+		while (true)
 		{
-			const LatchState ret = latch_buffer(tdbb, bcbSync, bdb, page, syncType, wait);
+			const ULONG count = bcb->bcb_count;
+			Sync hashSync(hash_stripe(bcb, page, count), "get_buffer");
+			hashSync.lock(SYNC_SHARED);
+
+			// Hash chains are rebuilt when the cache is expanded
+			if (count != bcb->bcb_count)
+				continue;
+
+			BufferDesc* const bdb = find_buffer(bcb, page, false);
+			if (!bdb)
+				break;
+
+			const LatchState ret = latch_buffer(tdbb, hashSync, bdb, page, syncType, wait);
 			if (ret == lsOk)
 			{
 				tdbb->bumpStats(RuntimeStatistics::PAGE_FETCHES);
@@ -3746,13 +4019,10 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 
 			if (ret == lsTimeout)
 				return NULL;
-
-			bcbSync.lock(SYNC_SHARED);
-			bdb = find_buffer(bcb, page, true);
 		}
-		bcbSync.unlock();
 	}
 
+	Sync bcbSync(&bcb->bcb_syncObject, "get_buffer");
 	bcbSync.lock(SYNC_EXCLUSIVE);
 
 	QUE que_inst;
@@ -3828,8 +4098,7 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 
 			if (page != FREE_PAGE)
 			{
-				QUE mod_que = &bcb->bcb_rpt[page.getPageNum() % bcb->bcb_count].bcb_page_mod;
-				QUE_INSERT(*mod_que, *que_inst);
+				hash_insert(bcb, bdb, page);
 #ifdef SUPERSERVER_V2
 				// Reserve a buffer for header page with deferred header
 				// page write mechanism. Otherwise, a deadlock will occur
@@ -3901,20 +4170,6 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 				continue;
 			}
 
-#ifdef SUPERSERVER_V2
-			// If page has been prefetched but not yet fetched, let
-			// it cycle once more thru LRU queue before re-using it.
-
-			if (oldest->bdb_flags & BDB_prefetch)
-			{
-				oldest->bdb_flags &= ~BDB_prefetch;
-				que_inst = que_inst->que_forward;
-				QUE_MOST_RECENTLY_USED(oldest->bdb_in_use);
-				//LATCH_MUTEX_RELEASE;
-				continue;
-			}
-#endif
-
 			if ((bcb->bcb_flags & BCB_cache_writer) &&
 				(oldest->bdb_flags & (BDB_dirty | BDB_db_dirty)) )
 			{
@@ -3946,7 +4201,7 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 			bdb->bdb_flags |= BDB_free_pending;
 			bdb->bdb_pending_page = page;
 
-			QUE_DELETE(bdb->bdb_que);
+			hash_remove(bcb, bdb);
 			QUE_INSERT(bcb->bcb_pending, bdb->bdb_que);
 
 			const bool needCleanup = (bdb->bdb_flags & (BDB_dirty | BDB_db_dirty)) ||
@@ -4006,8 +4261,7 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 
 			QUE_DELETE(bdb->bdb_que);	// bcb_pending
 
-			QUE mod_que = &bcb->bcb_rpt[page.getPageNum() % bcb->bcb_count].bcb_page_mod;
-			QUE_INSERT((*mod_que), bdb->bdb_que);
+			hash_insert(bcb, bdb, page);
 			bdb->bdb_flags &= ~BDB_free_pending;
 
 			// This correction for bdb_use_count below is needed to
@@ -4410,200 +4664,6 @@ static void page_validation_error(thread_db* tdbb, WIN* window, SSHORT type)
 }
 
 
-#ifdef CACHE_READER
-static void prefetch_epilogue(Prefetch* prefetch, FbStatusVector* status_vector)
-{
-/**************************************
- *
- *	p r e f e t c h _ e p i l o g u e
- *
- **************************************
- *
- * Functional description
- *	Stall on asynchronous I/O completion.
- *	Move data from prefetch buffer to database
- *	buffers, compute the checksum, and release
- *	the latch.
- *
- **************************************/
-	if (!(prefetch->prf_flags & PRF_active))
-		return;
-
-	thread_db* tdbb = prefetch->prf_tdbb;
-	Database* dbb = tdbb->getDatabase();
-
-	prefetch->prf_piob.piob_wait = TRUE;
-	const bool async_status = PIO_status(dbb, &prefetch->prf_piob, status_vector);
-
-	// If there was an I/O error release all buffer latches acquired for the prefetch request.
-
-	if (!async_status)
-	{
-		BufferDesc** next_bdb = prefetch->prf_bdbs;
-		for (USHORT i = 0; i < prefetch->prf_max_prefetch; i++)
-		{
-			if (*next_bdb)
-				release_bdb(tdbb, *next_bdb, true, false, false);
-
-			next_bdb++;
-		}
-		prefetch->prf_flags &= ~PRF_active;
-		return;
-	}
-
-	const SCHAR* next_buffer = prefetch->prf_io_buffer;
-	BufferDesc** next_bdb = prefetch->prf_bdbs;
-
-	for (USHORT i = 0; i < prefetch->prf_max_prefetch; i++)
-	{
-		if (*next_bdb)
-		{
-			pag* page = (*next_bdb)->bdb_buffer;
-			if (next_buffer != reinterpret_cast<char*>(page))
-				memcpy(page, next_buffer, (ULONG) dbb->dbb_page_size);
-
-			if (page->pag_pageno == (*next_bdb)->bdb_page.getPageNum())
-			{
-				(*next_bdb)->bdb_flags &= ~(BDB_read_pending | BDB_not_valid);
-				(*next_bdb)->bdb_flags |= BDB_prefetch;
-			}
-
-			release_bdb(tdbb, *next_bdb, true, false, false);
-		}
-
-		next_buffer += dbb->dbb_page_size;
-		next_bdb++;
-	}
-
-	prefetch->prf_flags &= ~PRF_active;
-}
-
-
-static void prefetch_init(Prefetch* prefetch, thread_db* tdbb)
-{
-/**************************************
- *
- *	p r e f e t c h _ i n i t
- *
- **************************************
- *
- * Functional description
- *	Initialize prefetch data structure.
- *	Most systems that allow access to "raw" I/O
- *	interfaces want the buffer address aligned.
- *
- **************************************/
-	Database* dbb = tdbb->getDatabase();
-
-	prefetch->prf_tdbb = tdbb;
-	prefetch->prf_flags = 0;
-	prefetch->prf_max_prefetch = PREFETCH_MAX_TRANSFER / dbb->dbb_page_size;
-	prefetch->prf_aligned_buffer =
-		(SCHAR*) (((U_IPTR) &prefetch->prf_unaligned_buffer + MIN_PAGE_SIZE - 1) &
-		~((U_IPTR) MIN_PAGE_SIZE - 1));
-}
-
-
-static void prefetch_io(Prefetch* prefetch, FbStatusVector* status_vector)
-{
-/**************************************
- *
- *	p r e f e t c h _ i o
- *
- **************************************
- *
- * Functional description
- *	Queue an asynchronous I/O to read
- *	multiple pages into prefetch buffer.
- *
- **************************************/
-	thread_db* tdbb = prefetch->prf_tdbb;
-	Database* dbb = tdbb->getDatabase();
-
-	if (!prefetch->prf_page_count)
-		prefetch->prf_flags &= ~PRF_active;
-	else
-	{
-		// Get the cache reader working on our behalf too
-
-		if (!(dbb->dbb_bcb->bcb_flags & BCB_reader_active))
-			dbb->dbb_reader_sem.post();
-
-		const bool async_status =
-			PIO_read_ahead(dbb, prefetch->prf_start_page, prefetch->prf_io_buffer,
-						   prefetch->prf_page_count, &prefetch->prf_piob, status_vector);
-		if (!async_status)
-		{
-			BufferDesc** next_bdb = prefetch->prf_bdbs;
-			for (USHORT i = 0; i < prefetch->prf_max_prefetch; i++)
-			{
-				if (*next_bdb)
-					release_bdb(tdbb, *next_bdb, true, false, false);
-
-				next_bdb++;
-			}
-			prefetch->prf_flags &= ~PRF_active;
-		}
-	}
-}
-
-
-static void prefetch_prologue(Prefetch* prefetch, SLONG* start_page)
-{
-/**************************************
- *
- *	p r e f e t c h _ p r o l o g u e
- *
- **************************************
- *
- * Functional description
- *	Search for consecutive pages to be prefetched
- *	and latch them for I/O.
- *
- **************************************/
-	thread_db* tdbb = prefetch->prf_tdbb;
-	Database* dbb = tdbb->getDatabase();
-	BufferControl* bcb = dbb->dbb_bcb;
-
-	prefetch->prf_start_page = *start_page;
-	prefetch->prf_page_count = 0;
-	prefetch->prf_flags |= PRF_active;
-
-	BufferDesc** next_bdb = prefetch->prf_bdbs;
-	for (USHORT i = 0; i < prefetch->prf_max_prefetch; i++)
-	{
-		*next_bdb = 0;
-		if (SBM_clear(bcb->bcb_prefetch, *start_page) &&
-			(*next_bdb = get_buffer(tdbb, *start_page, LATCH_shared, 0)))
-		{
-			if ((*next_bdb)->bdb_flags & BDB_read_pending)
-				prefetch->prf_page_count = i + 1;
-			else
-			{
-				release_bdb(tdbb, *next_bdb, true, false, false);
-				*next_bdb = 0;
-			}
-		}
-
-		next_bdb++;
-		(*start_page)++;
-	}
-
-	// Optimize non-sequential list prefetching to transfer directly to database buffers.
-
-	BufferDesc* bdb;
-	if (prefetch->prf_page_count == 1 && (bdb = prefetch->prf_bdbs[0]))
-		prefetch->prf_io_buffer = reinterpret_cast<char*>(bdb->bdb_buffer);
-	else
-		prefetch->prf_io_buffer = prefetch->prf_aligned_buffer;
-
-	// Reset starting page for next bitmap walk
-
-	--(*start_page);
-}
-#endif // CACHE_READER
-
-
 static SSHORT related(BufferDesc* low, const BufferDesc* high, SSHORT limit, const ULONG mark)
 {
 /**************************************
@@ -5068,34 +5128,192 @@ static bool write_page(thread_db* tdbb, BufferDesc* bdb, FbStatusVector* const s
 		dbb->dbb_flags |= DBB_suspend_bgio;
 	}
 	else
+		page_written(tdbb, bdb);
+
+	return result;
+}
+
+
+static void page_written(thread_db* tdbb, BufferDesc* bdb)
+{
+/**************************************
+ *
+ *	p a g e _ w r i t t e n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Clean the buffer after its page was successfully written.
+ *
+ **************************************/
+	Database* const dbb = tdbb->getDatabase();
+
+	// clear the dirty bit vector, since the buffer is now
+	// clean regardless of which transactions have modified it
+
+	// Destination difference page number is only valid between MARK and
+	// write_page so clean it now to avoid confusion
+	bdb->bdb_difference_page = 0;
+	bdb->bdb_transactions = 0;
+	bdb->bdb_mark_transaction = 0;
+
+	if (!(bdb->bdb_bcb->bcb_flags & BCB_keep_pages))
+		removeDirty(bdb->bdb_bcb, bdb);
+
+	bdb->bdb_flags &= ~(BDB_must_write | BDB_system_dirty);
+	clear_dirty_flag_and_nbak_state(tdbb, bdb);
+
+	if (bdb->bdb_flags & BDB_io_error)
 	{
-		// clear the dirty bit vector, since the buffer is now
-		// clean regardless of which transactions have modified it
+		// If a write error has cleared, signal background threads
+		// to resume their regular duties. If someone has freed up
+		// disk space these errors will spontaneously go away.
 
-		// Destination difference page number is only valid between MARK and
-		// write_page so clean it now to avoid confusion
-		bdb->bdb_difference_page = 0;
-		bdb->bdb_transactions = 0;
-		bdb->bdb_mark_transaction = 0;
+		bdb->bdb_flags &= ~BDB_io_error;
+		dbb->dbb_flags &= ~DBB_suspend_bgio;
+	}
+}
 
-		if (!(bdb->bdb_bcb->bcb_flags & BCB_keep_pages))
-			removeDirty(bdb->bdb_bcb, bdb);
 
-		bdb->bdb_flags &= ~(BDB_must_write | BDB_system_dirty);
-		clear_dirty_flag_and_nbak_state(tdbb, bdb);
+static bool write_run(thread_db* tdbb, BufferDesc** bdbs, FB_SIZE_T count, const bool write_thru,
+	FbStatusVector* const status)
+{
+/**************************************
+ *
+ *	w r i t e _ r u n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write dirty buffers of adjacent pages, latched by the caller,
+ *	using single vectored I/O request. Pages which need special
+ *	handling (header page, shadows, difference file, buffers with
+ *	precedence) are written one by one using write_buffer.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	Database* const dbb = tdbb->getDatabase();
+
+	PageSpace* const pageSpace =
+		dbb->dbb_page_manager.findPageSpace(bdbs[0]->bdb_page.getPageSpaceID());
+	fb_assert(pageSpace);
+	const bool isTempPage = pageSpace->isTemporary();
+
+	HalfStaticArray<BufferDesc*, MAX_WRITE_RUN> batch;
 
-		if (bdb->bdb_flags & BDB_io_error)
+	if (count > 1 && (isTempPage ||
+		(dbb->dbb_backup_manager->getState() == Ods::hdr_nbak_normal && !dbb->dbb_shadow)))
+	{
+		for (FB_SIZE_T n = 0; n < count; n++)
 		{
-			// If a write error has cleared, signal background threads
-			// to resume their regular duties. If someone has freed up
-			// disk space these errors will spontaneously go away.
+			BufferDesc* const bdb = bdbs[n];
+			bdb->lockIO(tdbb);
 
-			bdb->bdb_flags &= ~BDB_io_error;
-			dbb->dbb_flags &= ~DBB_suspend_bgio;
+			if ((bdb->bdb_flags & BDB_dirty || (write_thru && bdb->bdb_flags & BDB_db_dirty)) &&
+				!(bdb->bdb_flags & (BDB_marked | BDB_not_valid)) &&
+				QUE_EMPTY(bdb->bdb_higher) && bdb->bdb_page != HEADER_PAGE_NUMBER)
+			{
+				batch.add(bdb);
+			}
+			else
+				bdb->unLockIO(tdbb);
 		}
 	}
 
-	return result;
+	if (batch.getCount() == 1)
+	{
+		batch[0]->unLockIO(tdbb);
+		batch.clear();
+	}
+
+	if (batch.hasData())
+	{
+		HalfStaticArray<pag*, MAX_WRITE_RUN> pages;
+
+		for (BufferDesc** ptr = batch.begin(); ptr < batch.end(); ptr++)
+		{
+			BufferDesc* const bdb = *ptr;
+			pag* const page = bdb->bdb_buffer;
+
+			CCH_TRACE(("WRITE   %d:%06d", bdb->bdb_page.getPageSpaceID(), bdb->bdb_page.getPageNum()));
+
+			page->pag_generation++;
+			page->pag_pageno = bdb->bdb_page.getPageNum();
+			pages.add(page);
+
+			tdbb->bumpStats(RuntimeStatistics::PAGE_WRITES);
+		}
+
+		class Pio : public CryptoManager::BatchIOCallback
+		{
+		public:
+			Pio(jrd_file* f, BufferDesc** b)
+				: file(f), bdbs(b)
+			{ }
+
+			bool callback(thread_db* tdbb, FbStatusVector* status, Ods::pag** pages, FB_SIZE_T count)
+			{
+				HalfStaticArray<PageIo, MAX_WRITE_RUN> io;
+				PageIo* const ptr = io.getBuffer(count);
+
+				for (FB_SIZE_T n = 0; n < count; n++)
+				{
+					ptr[n].pio_bdb = bdbs[n];
+					ptr[n].pio_page = pages[n];
+				}
+
+				return PIO_write_pages(tdbb, file, ptr, count, status);
+			}
+
+		private:
+			jrd_file* file;
+			BufferDesc** bdbs;
+		};
+
+		Pio io(pageSpace->file, batch.begin());
+		const bool result = dbb->dbb_crypto_manager->write(tdbb, status,
+			pages.begin(), pages.getCount(), &io);
+
+		for (BufferDesc** ptr = batch.begin(); ptr < batch.end(); ptr++)
+		{
+			BufferDesc* const bdb = *ptr;
+
+			if (result)
+			{
+				bdb->bdb_flags &= ~BDB_db_dirty;
+				page_written(tdbb, bdb);
+			}
+			else
+			{
+				// See write_page
+				bdb->bdb_flags |= BDB_io_error;
+				dbb->dbb_flags |= DBB_suspend_bgio;
+			}
+
+			bdb->unLockIO(tdbb);
+
+			if (result)
+				clear_precedence(tdbb, bdb);
+		}
+
+		if (!result)
+			return false;
+	}
+
+	// Write the rest of pages, if any
+
+	for (FB_SIZE_T n = 0; n < count; n++)
+	{
+		BufferDesc* const bdb = bdbs[n];
+
+		if (batch.exist(bdb))
+			continue;
+
+		if (!write_buffer(tdbb, bdb, bdb->bdb_page, write_thru, status, true))
+			return false;
+	}
+
+	return true;
 }
 
 static void clear_dirty_flag_and_nbak_state(thread_db* tdbb, BufferDesc* bdb)
@@ -5203,10 +5421,20 @@ void BufferControl::destroy(BufferControl* bcb)
 
 bool BufferDesc::addRef(thread_db* tdbb, SyncType syncType, int wait)
 {
-	if (wait == 1)
-		bdb_syncPage.lock(NULL, syncType, FB_FUNCTION);
-	else if (!bdb_syncPage.lock(NULL, syncType, FB_FUNCTION, -wait * 1000))
-		return false;
+	// Try the latch without waiting first, thus only the real waits are timed
+
+	if (!bdb_syncPage.lockConditional(syncType, FB_FUNCTION))
+	{
+		if (!wait)
+			return false;
+
+		RuntimeStatistics::WaitTimer timer(tdbb, RuntimeStatistics::LATCH_WAITS);
+
+		if (wait == 1)
+			bdb_syncPage.lock(NULL, syncType, FB_FUNCTION);
+		else if (!bdb_syncPage.lock(NULL, syncType, FB_FUNCTION, -wait * 1000))
+			return false;
+	}
 
 	++bdb_use_count;
 
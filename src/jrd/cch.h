@@ -28,6 +28,8 @@
 #include "../common/classes/alloc.h"
 #include "../common/classes/RefCounted.h"
 #include "../common/classes/semaphore.h"
+#include "../common/classes/locks.h"
+#include "../common/classes/array.h"
 #include "../common/classes/SyncObject.h"
 #include "../common/ThreadStart.h"
 #ifdef SUPERSERVER_V2
@@ -87,7 +89,9 @@ class BufferControl : public pool_alloc<type_bcb>
 		: bcb_bufferpool(&p),
 		  bcb_memory_stats(&parentStats),
 		  bcb_memory(p),
-		  bcb_writer_fini(p, cache_writer, THREAD_medium)
+		  bcb_writer_fini(p, cache_writer, THREAD_medium),
+		  bcb_reader_fini(p, cache_reader, THREAD_medium),
+		  bcb_prefetch(p)
 	{
 		bcb_database = NULL;
 		QUE_INIT(bcb_in_use);
@@ -103,9 +107,7 @@ class BufferControl : public pool_alloc<type_bcb>
 		bcb_prec_walk_mark = 0;
 		bcb_page_size = 0;
 		bcb_page_incarnation = 0;
-#ifdef SUPERSERVER_V2
-		bcb_prefetch = NULL;
-#endif
+		bcb_prefetch_pages = 0;
 	}
 
 public:
@@ -141,6 +143,13 @@ public:
 	ULONG		bcb_page_incarnation;	// Cache page incarnation counter
 
 	Firebird::SyncObject	bcb_syncObject;
+
+	// Hash chains of bcb_rpt are split between the stripes below. A chain is
+	// changed holding both bcb_syncObject and the stripe of the chain in
+	// exclusive mode, thus the page could be looked up holding any of them.
+	static const ULONG HASH_STRIPES = 64;
+	Firebird::SyncObject	bcb_syncHash[HASH_STRIPES];
+
 	Firebird::SyncObject	bcb_syncDirtyBdbs;
 	Firebird::SyncObject	bcb_syncPrecedence;
 	Firebird::SyncObject	bcb_syncLRU;
@@ -152,15 +161,15 @@ public:
 	Firebird::Semaphore bcb_writer_sem;		// Wake up cache writer
 	Firebird::Semaphore bcb_writer_init;	// Cache writer initialization
 	BcbThreadSync bcb_writer_fini;			// Cache writer finalization
-#ifdef SUPERSERVER_V2
+
 	static void cache_reader(BufferControl* bcb);
-	// the code in cch.cpp is not tested for semaphore instead event !!!
 	Firebird::Semaphore bcb_reader_sem;		// Wake up cache reader
 	Firebird::Semaphore bcb_reader_init;	// Cache reader initialization
 	BcbThreadSync bcb_reader_fini;			// Cache reader finalization
 
-	PageBitmap*	bcb_prefetch;		// Bitmap of pages to prefetch
-#endif
+	Firebird::Mutex bcb_prefetch_mutex;			// Protects bcb_prefetch
+	Firebird::Array<PageNumber> bcb_prefetch;	// Pages to be read by cache reader
+	ULONG		bcb_prefetch_pages;		// Number of data pages read ahead by sequential scans
 
 	void exceptionHandler(const Firebird::Exception& ex, BcbThreadSync::ThreadRoutine* routine);
 
@@ -171,12 +180,11 @@ const int BCB_keep_pages	= 1;	// set during btc_flush(), pages not removed from
 const int BCB_cache_writer	= 2;	// cache writer thread has been started
 const int BCB_writer_start  = 4;    // cache writer thread is starting now
 const int BCB_writer_active	= 8;	// no need to post writer event count
-#ifdef SUPERSERVER_V2
 const int BCB_cache_reader	= 16;	// cache reader thread has been started
 const int BCB_reader_active	= 32;	// cache reader not blocked on event
-#endif
 const int BCB_free_pending	= 64;	// request cache writer to free pages
 const int BCB_exclusive		= 128;	// there is only BCB in whole system
+const int BCB_reader_start	= 256;	// cache reader thread is starting now
 
 
 // BufferDesc -- Buffer descriptor block
@@ -63,10 +63,8 @@ void		CCH_must_write(Jrd::thread_db*, Jrd::win*);
 void		CCH_precedence(Jrd::thread_db*, Jrd::win*, ULONG);
 void		CCH_precedence(Jrd::thread_db*, Jrd::win*, Jrd::PageNumber);
 void		CCH_tra_precedence(Jrd::thread_db*, Jrd::win*, TraNumber traNum);
-#ifdef SUPERSERVER_V2
-void		CCH_prefetch(Jrd::thread_db*, SLONG*, SSHORT);
+void		CCH_prefetch(Jrd::thread_db*, USHORT, const ULONG*, FB_SIZE_T);
 bool		CCH_prefetch_pages(Jrd::thread_db*);
-#endif
 void		CCH_release(Jrd::thread_db*, Jrd::win*, const bool);
 void		CCH_release_exclusive(Jrd::thread_db*);
 bool		CCH_rollover_to_shadow(Jrd::thread_db* tdbb, Jrd::Database* dbb, Jrd::jrd_file*, const bool);
@@ -74,6 +72,7 @@ void		CCH_shutdown(Jrd::thread_db*);
 void		CCH_unwind(Jrd::thread_db*, const bool);
 bool		CCH_validate(Jrd::win*);
 void		CCH_flush_ast(Jrd::thread_db*);
+void		CCH_flush_group(Jrd::thread_db*, ULONG);
 bool		CCH_write_all_shadows(Jrd::thread_db*, Jrd::Shadow*, Jrd::BufferDesc*, Ods::pag*,
 					 Jrd::FbStatusVector*, const bool);
 
@@ -137,7 +136,7 @@ inline void CCH_MARK_MUST_WRITE(Jrd::thread_db* tdbb, Jrd::win* window)
 #ifdef SUPERSERVER_V2
 inline void CCH_PREFETCH(Jrd::thread_db* tdbb, SLONG* pages, SSHORT count)
 {
-	CCH_prefetch (tdbb, pages, count);
+	CCH_prefetch (tdbb, DB_PAGE_SPACE, reinterpret_cast<ULONG*>(pages), count);
 }
 #endif
 
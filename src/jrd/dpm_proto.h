@@ -45,6 +45,14 @@ namespace Jrd
 		DPM_secondary,		// Chained version of primary record
 		DPM_other			// Independent (or don't care) record
 	};
+
+	// How far DPM_next() looks for the next record
+	enum FindNextRecordScope
+	{
+		DPM_next_all,			// all pages of the relation
+		DPM_next_data_page,		// the current data page only
+		DPM_next_pointer_page	// data pages of the current pointer page only
+	};
 }
 
 namespace Ods
@@ -68,7 +76,7 @@ void	DPM_fetch_fragment(Jrd::thread_db*, Jrd::record_param*, USHORT);
 SINT64	DPM_gen_id(Jrd::thread_db*, SLONG, bool, SINT64);
 bool	DPM_get(Jrd::thread_db*, Jrd::record_param*, SSHORT);
 ULONG	DPM_get_blob(Jrd::thread_db*, Jrd::blb*, RecordNumber, bool, ULONG);
-bool	DPM_next(Jrd::thread_db*, Jrd::record_param*, USHORT, bool);
+bool	DPM_next(Jrd::thread_db*, Jrd::record_param*, USHORT, Jrd::FindNextRecordScope);
 void	DPM_pages(Jrd::thread_db*, SSHORT, int, ULONG, ULONG);
 #ifdef SUPERSERVER_V2
 SLONG	DPM_prefetch_bitmap(Jrd::thread_db*, Jrd::jrd_rel*, Jrd::PageBitmap*, SLONG);
@@ -98,6 +98,7 @@
 
 #include "../jrd/tra_proto.h"
 #include "../jrd/vio_proto.h"
+#include "../jrd/Profiler.h"
 #include "../common/isc_s_proto.h"
 
 #include "../dsql/dsql_proto.h"
@@ -919,6 +920,7 @@ void EXE_start(thread_db* tdbb, jrd_req* request, jrd_tra* transaction)
 
 	request->req_src_line = 0;
 	request->req_src_column = 0;
+	request->req_prof_line = 0;
 
 	TRA_setup_request_snapshot(tdbb, request);
 
@@ -1054,16 +1056,36 @@ static void execute_looper(thread_db* tdbb,
 		}
 	}
 
+	// Let the top level statement defer index keys of bulk modifications
+
+	const bool deferKeys = savNumber && !tdbb->getRequest() &&
+		!(transaction->tra_flags & TRA_defer_keys);
+
+	if (deferKeys)
+		transaction->tra_flags |= TRA_defer_keys;
+
 	request->req_flags &= ~req_stall;
 	request->req_operation = next_state;
 
 	try
 	{
 		looper_seh(tdbb, request, node);
+
+		if (deferKeys)
+		{
+			transaction->tra_flags &= ~TRA_defer_keys;
+
+			if (transaction->tra_deferred_keys)
+				transaction->tra_deferred_keys->finish(tdbb, transaction);
+		}
 	}
 	catch (const Exception&)
 	{
+		if (deferKeys)
+			transaction->tra_flags &= ~TRA_defer_keys;
+
 		// In the case of error, undo changes performed under our savepoint
+		// including the index keys still pending
 
 		if (savNumber)
 			transaction->rollbackToSavepoint(tdbb, savNumber);
@@ -1321,6 +1343,7 @@ const StmtNode* EXE_looper(thread_db* tdbb, jrd_req* request, const StmtNode* no
 
 	SET_TDBB(tdbb);
 	Database* dbb = tdbb->getDatabase();
+	Jrd::Attachment* const attachment = tdbb->getAttachment();
 
 	// ASF: It's already a StmtNode, so do not do a virtual call in execution.
 	if (!node)	/// if (!node || node->getKind() != DmlNode::KIND_STATEMENT
@@ -1351,13 +1374,21 @@ const StmtNode* EXE_looper(thread_db* tdbb, jrd_req* request, const StmtNode* no
 				{
 					request->req_src_line = node->line;
 					request->req_src_column = node->column;
+
+					if (attachment->att_flags & ATT_profiling)
+						attachment->att_profiler->enterLine(tdbb, request, node->line, node->column);
 				}
 			}
 
 			node = node->execute(tdbb, request, &exeState);
 
 			if (exeState.exit)
+			{
+				if (request->req_prof_line)
+					attachment->att_profiler->leaveLine(request);
+
 				return node;
+			}
 		}	// try
 		catch (const Firebird::Exception& ex)
 		{
@@ -1396,6 +1427,10 @@ const StmtNode* EXE_looper(thread_db* tdbb, jrd_req* request, const StmtNode* no
 		}
 	} // while()
 
+	// Stop timing of the current PSQL statement while the request is stalled or finished
+	if (request->req_prof_line)
+		attachment->att_profiler->leaveLine(request);
+
 	request->adjustCallerStats();
 
 	fb_assert(request->req_auto_trans.getCount() == 0);
@@ -64,6 +64,9 @@
 #include "../jrd/vio_proto.h"
 #include "../jrd/tra_proto.h"
 #include "../jrd/Collation.h"
+#include "../jrd/ParallelTask.h"
+#include "../jrd/IndexGarbage.h"
+#include "../jrd/DeferredIndexKeys.h"
 
 using namespace Jrd;
 using namespace Ods;
@@ -104,6 +107,286 @@ namespace
 		const USHORT l = key1->key_length;
 		return (l == key2->key_length && !memcmp(key1->key_data, key2->key_data, l));
 	}
+
+	// Number of data pages scanned by a parallel worker at a time
+	const ULONG IDX_PARALLEL_UNIT_PAGES = 64;
+
+	// Scan the relation, compute index keys and put them into the sort.
+	// Every unit of work is a range of data pages, there is the only unit
+	// covering the whole relation unless the scan is done in parallel.
+
+	class IndexCreateTask : public ParallelTask
+	{
+	public:
+		IndexCreateTask(thread_db* tdbb, IndexCreation& creation, const TEXT* indexName,
+						jrd_rel* partnerRelation, USHORT partnerIndexId, bool largeScan, ULONG units)
+			: m_attachment(tdbb->getAttachment()),
+			  m_creation(creation),
+			  m_indexName(indexName),
+			  m_partnerRelation(partnerRelation),
+			  m_partnerIndexId(partnerIndexId),
+			  m_largeScan(largeScan),
+			  m_units(units),
+			  m_nextUnit(0)
+		{}
+
+	protected:
+		void work(thread_db* tdbb);
+
+	private:
+		bool scan(thread_db* tdbb, jrd_rel* relation, jrd_tra* transaction, ULONG unit);
+		bool hasDuplicates();
+
+		Jrd::Attachment* const m_attachment;
+		IndexCreation& m_creation;
+		const TEXT* const m_indexName;
+		jrd_rel* const m_partnerRelation;
+		const USHORT m_partnerIndexId;
+		const bool m_largeScan;
+		const ULONG m_units;
+		AtomicCounter m_nextUnit;
+		Mutex m_sortMutex;		// protects the sort and duplicates info in m_creation
+	};
+
+	void IndexCreateTask::work(thread_db* tdbb)
+	{
+		jrd_rel* relation = m_creation.relation;
+		jrd_tra* transaction = m_creation.transaction;
+
+		// Additional workers use their own attachments
+
+		if (tdbb->getAttachment() != m_attachment)
+		{
+			relation = MET_lookup_relation_id(tdbb, relation->rel_id, false);
+			if (!relation)
+				return;	// let others do the job
+
+			MET_scan_relation(tdbb, relation);
+			transaction = tdbb->getTransaction();
+		}
+
+		while (!isCancelled())
+		{
+			const ULONG unit = (ULONG) m_nextUnit.exchangeAdd(1);
+
+			if (unit >= m_units || hasDuplicates() || !scan(tdbb, relation, transaction, unit))
+				break;
+		}
+	}
+
+	bool IndexCreateTask::hasDuplicates()
+	{
+		MutexLockGuard guard(m_sortMutex, FB_FUNCTION);
+		return m_creation.duplicates > 0;
+	}
+
+	bool IndexCreateTask::scan(thread_db* tdbb, jrd_rel* relation, jrd_tra* transaction, ULONG unit)
+	{
+		// Returns false if the duplicates were found and thus the job is done
+
+		Database* const dbb = tdbb->getDatabase();
+		index_desc* const idx = m_creation.index;
+		const USHORT key_length = m_creation.key_length;
+		Sort* const scb = m_creation.sort;
+
+		const bool isDescending = (idx->idx_flags & idx_descending);
+		const bool isPrimary = (idx->idx_flags & idx_primary);
+		const bool isForeign = (idx->idx_flags & idx_foreign);
+		const int nullIndLen = !isDescending && (idx->idx_count == 1) ? 1 : 0;
+		const UCHAR pad = isDescending ? -1 : 0;
+
+		// Range of record numbers to scan, the last unit is not limited as
+		// the relation could grow while we are here
+
+		const SINT64 unitRecords = (SINT64) IDX_PARALLEL_UNIT_PAGES * dbb->dbb_max_records;
+		const SINT64 lower = (m_units == 1) ? 0 : unit * unitRecords;
+		const RecordNumber upper((unit == m_units - 1) ? MAX_SINT64 : lower + unitRecords);
+
+		record_param primary, secondary;
+		secondary.rpb_relation = relation;
+		primary.rpb_relation = relation;
+		primary.rpb_number.setValue(lower - 1);
+		//primary.getWindow(tdbb).win_flags = secondary.getWindow(tdbb).win_flags = 0; redundant
+
+		// Checkout a garbage collect record block for fetching data.
+
+		AutoGCRecord gc_record(VIO_gc_record(tdbb, relation));
+
+		if (m_largeScan)
+		{
+			primary.getWindow(tdbb).win_flags = secondary.getWindow(tdbb).win_flags = WIN_large_scan;
+			primary.rpb_org_scans = secondary.rpb_org_scans = relation->rel_scan_count++;
+		}
+
+		IndexErrorContext context(relation, idx, m_indexName);
+
+		// Loop thru the relation computing index keys.  If there are old versions, find them, too.
+		RecordStack stack;
+		temporary_key key;
+		bool duplicates = false;
+
+		while (DPM_next(tdbb, &primary, LCK_read, DPM_next_all))
+		{
+			if (primary.rpb_number >= upper)
+			{
+				CCH_RELEASE(tdbb, &primary.getWindow(tdbb));
+				break;
+			}
+
+			if (!VIO_garbage_collect(tdbb, &primary, transaction))
+				continue;
+
+			// If there are any back-versions left make an attempt at intermediate GC.
+			if (primary.rpb_b_page)
+			{
+				VIO_intermediate_gc(tdbb, &primary, transaction);
+
+				if (!DPM_get(tdbb, &primary, LCK_read))
+					continue;
+			}
+
+			const bool deleted = primary.rpb_flags & rpb_deleted;
+			if (deleted)
+				CCH_RELEASE(tdbb, &primary.getWindow(tdbb));
+			else
+			{
+				primary.rpb_record = gc_record;
+				VIO_data(tdbb, &primary, relation->rel_pool);
+				stack.push(primary.rpb_record);
+			}
+
+			secondary.rpb_page = primary.rpb_b_page;
+			secondary.rpb_line = primary.rpb_b_line;
+			secondary.rpb_prior = primary.rpb_prior;
+
+			while (secondary.rpb_page)
+			{
+				if (!DPM_fetch(tdbb, &secondary, LCK_read))
+					break;			// must be garbage collected
+
+				secondary.rpb_record = NULL;
+				VIO_data(tdbb, &secondary, relation->rel_pool);
+				stack.push(secondary.rpb_record);
+				secondary.rpb_page = secondary.rpb_b_page;
+				secondary.rpb_line = secondary.rpb_b_line;
+			}
+
+			while (stack.hasData())
+			{
+				Record* record = stack.pop();
+
+				idx_e result = BTR_key(tdbb, relation, record, idx, &key, false);
+
+				if (result == idx_e_ok)
+				{
+					if (isPrimary && key.key_nulls != 0)
+					{
+						const USHORT key_null_segment = getNullSegment(key);
+						fb_assert(key_null_segment < idx->idx_count);
+						const USHORT bad_id = idx->idx_rpt[key_null_segment].idx_field;
+						const jrd_fld *bad_fld = MET_get_field(relation, bad_id);
+
+						ERR_post(Arg::Gds(isc_not_valid) << Arg::Str(bad_fld->fld_name) <<
+															Arg::Str(NULL_STRING_MARK));
+					}
+
+					// If foreign key index is being defined, make sure foreign
+					// key definition will not be violated
+
+					if (isForeign && key.key_nulls == 0)
+					{
+						result = check_partner_index(tdbb, relation, record, transaction, idx,
+													 m_partnerRelation, m_partnerIndexId);
+					}
+				}
+
+				if (result != idx_e_ok)
+				{
+					do {
+						if (record != gc_record)
+							delete record;
+					} while (stack.hasData() && (record = stack.pop()));
+
+					if (primary.getWindow(tdbb).win_flags & WIN_large_scan)
+						--relation->rel_scan_count;
+
+					context.raise(tdbb, result, record);
+				}
+
+				if (key.key_length > key_length)
+				{
+					do {
+						if (record != gc_record)
+							delete record;
+					} while (stack.hasData() && (record = stack.pop()));
+
+					if (primary.getWindow(tdbb).win_flags & WIN_large_scan)
+						--relation->rel_scan_count;
+
+					context.raise(tdbb, idx_e_keytoobig, record);
+				}
+
+				// The sort is shared by all workers, the record must be
+				// filled before the next one is put
+
+				MutexLockGuard guard(m_sortMutex, FB_FUNCTION);
+
+				UCHAR* p;
+				scb->put(tdbb, reinterpret_cast<ULONG**>(&p));
+
+				// try to catch duplicates early
+
+				if (m_creation.duplicates > 0)
+				{
+					do {
+						if (record != gc_record)
+							delete record;
+					} while (stack.hasData() && (record = stack.pop()));
+
+					duplicates = true;
+					break;
+				}
+
+				if (nullIndLen)
+					*p++ = (key.key_length == 0) ? 0 : 1;
+
+				if (key.key_length > 0)
+				{
+					memcpy(p, key.key_data, key.key_length);
+					p += key.key_length;
+				}
+
+				int l = int(key_length) - nullIndLen - key.key_length;	// must be signed
+
+				if (l > 0)
+				{
+					memset(p, pad, l);
+					p += l;
+				}
+
+				const bool key_is_null = (key.key_nulls == (1 << idx->idx_count) - 1);
+
+				index_sort_record* isr = (index_sort_record*) p;
+				isr->isr_record_number = primary.rpb_number.getValue();
+				isr->isr_key_length = key.key_length;
+				isr->isr_flags = ((stack.hasData() || deleted) ? ISR_secondary : 0) | (key_is_null ? ISR_null : 0);
+				if (record != gc_record)
+					delete record;
+			}
+
+			if (duplicates || isCancelled())
+				break;
+
+			JRD_reschedule(tdbb);
+		}
+
+		gc_record.release();
+
+		if (primary.getWindow(tdbb).win_flags & WIN_large_scan)
+			--relation->rel_scan_count;
+
+		return !duplicates;
+	}
 }
 
 
@@ -268,14 +551,7 @@ void IDX_create_index(thread_db* tdbb,
 
 	fb_assert(transaction);
 
-	record_param primary, secondary;
-	secondary.rpb_relation = relation;
-	primary.rpb_relation = relation;
-	primary.rpb_number.setValue(BOF_NUMBER);
-	//primary.getWindow(tdbb).win_flags = secondary.getWindow(tdbb).win_flags = 0; redundant
-
 	const bool isDescending = (idx->idx_flags & idx_descending);
-	const bool isPrimary = (idx->idx_flags & idx_primary);
 	const bool isForeign = (idx->idx_flags & idx_foreign);
 
 	// hvlad: in ODS11 empty string and NULL values can have the same binary
@@ -309,9 +585,6 @@ void IDX_create_index(thread_db* tdbb,
 	if (index_id)
 		*index_id = idx->idx_id;
 
-	RecordStack stack;
-	const UCHAR pad = isDescending ? -1 : 0;
-
 	sort_key_def key_desc[2];
 	// Key sort description
 	key_desc[0].setSkdLength(SKD_bytes, key_length);
@@ -343,172 +616,44 @@ void IDX_create_index(thread_db* tdbb,
 		partner_index_id = idx->idx_primary_index;
 	}
 
-	// Checkout a garbage collect record block for fetching data.
-
-	AutoGCRecord gc_record(VIO_gc_record(tdbb, relation));
-
 	// Unless this is the only attachment or a database restore, worry about
 	// preserving the page working sets of other attachments.
+	bool largeScan = false;
 	if (attachment && (attachment != dbb->dbb_attachments || attachment->att_next))
-	{
-		if (attachment->isGbak() || DPM_data_pages(tdbb, relation) > dbb->dbb_bcb->bcb_count)
-		{
-			primary.getWindow(tdbb).win_flags = secondary.getWindow(tdbb).win_flags = WIN_large_scan;
-			primary.rpb_org_scans = secondary.rpb_org_scans = relation->rel_scan_count++;
-		}
-	}
+		largeScan = attachment->isGbak() || DPM_data_pages(tdbb, relation) > dbb->dbb_bcb->bcb_count;
 
-	IndexErrorContext context(relation, idx, index_name);
+	// Expression indices are evaluated using requests of the current attachment,
+	// foreign keys are checked against the partner index using the current
+	// transaction, pages of temporary tables are private to the attachment.
+	// Otherwise scan the relation by parallel workers, every worker taking
+	// a range of data pages at a time.
 
-	// Loop thru the relation computing index keys.  If there are old versions, find them, too.
-	temporary_key key;
-	while (DPM_next(tdbb, &primary, LCK_read, false))
-	{
-		if (!VIO_garbage_collect(tdbb, &primary, transaction))
-			continue;
-
-		// If there are any back-versions left make an attempt at intermediate GC.
-		if (primary.rpb_b_page)
-		{
-			VIO_intermediate_gc(tdbb, &primary, transaction);
-
-			if (!DPM_get(tdbb, &primary, LCK_read))
-				continue;
-		}
-
-		const bool deleted = primary.rpb_flags & rpb_deleted;
-		if (deleted)
-			CCH_RELEASE(tdbb, &primary.getWindow(tdbb));
-		else
-		{
-			primary.rpb_record = gc_record;
-			VIO_data(tdbb, &primary, relation->rel_pool);
-			stack.push(primary.rpb_record);
-		}
+	unsigned workers = 1;
+	ULONG units = 1;
 
-		secondary.rpb_page = primary.rpb_b_page;
-		secondary.rpb_line = primary.rpb_b_line;
-		secondary.rpb_prior = primary.rpb_prior;
-
-		while (secondary.rpb_page)
-		{
-			if (!DPM_fetch(tdbb, &secondary, LCK_read))
-				break;			// must be garbage collected
-
-			secondary.rpb_record = NULL;
-			VIO_data(tdbb, &secondary, relation->rel_pool);
-			stack.push(secondary.rpb_record);
-			secondary.rpb_page = secondary.rpb_b_page;
-			secondary.rpb_line = secondary.rpb_b_line;
-		}
+	if (!idx->idx_expression && !isForeign && !relation->isTemporary())
+	{
+		workers = ParallelTask::getWorkers(tdbb);
 
-		while (stack.hasData())
+		if (workers > 1)
 		{
-			Record* record = stack.pop();
-
-			result = BTR_key(tdbb, relation, record, idx, &key, false);
-
-			if (result == idx_e_ok)
-			{
-				if (isPrimary && key.key_nulls != 0)
-				{
-					const USHORT key_null_segment = getNullSegment(key);
-					fb_assert(key_null_segment < idx->idx_count);
-					const USHORT bad_id = idx->idx_rpt[key_null_segment].idx_field;
-					const jrd_fld *bad_fld = MET_get_field(relation, bad_id);
-
-					ERR_post(Arg::Gds(isc_not_valid) << Arg::Str(bad_fld->fld_name) <<
-														Arg::Str(NULL_STRING_MARK));
-				}
-
-				// If foreign key index is being defined, make sure foreign
-				// key definition will not be violated
-
-				if (isForeign && key.key_nulls == 0)
-				{
-					result = check_partner_index(tdbb, relation, record, transaction, idx,
-												 partner_relation, partner_index_id);
-				}
-			}
-
-			if (result != idx_e_ok)
-			{
-				do {
-					if (record != gc_record)
-						delete record;
-				} while (stack.hasData() && (record = stack.pop()));
-
-				if (primary.getWindow(tdbb).win_flags & WIN_large_scan)
-					--relation->rel_scan_count;
-
-				context.raise(tdbb, result, record);
-			}
-
-			if (key.key_length > key_length)
-			{
-				do {
-					if (record != gc_record)
-						delete record;
-				} while (stack.hasData() && (record = stack.pop()));
-
-				if (primary.getWindow(tdbb).win_flags & WIN_large_scan)
-					--relation->rel_scan_count;
-
-				context.raise(tdbb, idx_e_keytoobig, record);
-			}
-
-			UCHAR* p;
-			scb->put(tdbb, reinterpret_cast<ULONG**>(&p));
-
-			// try to catch duplicates early
-
-			if (creation.duplicates > 0)
-			{
-				do {
-					if (record != gc_record)
-						delete record;
-				} while (stack.hasData() && (record = stack.pop()));
-
-				break;
-			}
-
-			if (nullIndLen)
-				*p++ = (key.key_length == 0) ? 0 : 1;
-
-			if (key.key_length > 0)
-			{
-				memcpy(p, key.key_data, key.key_length);
-				p += key.key_length;
-			}
+			const ULONG dataPages = DPM_data_pages(tdbb, relation);
+			const vcl* const pointerPages = relation->getPages(tdbb)->rel_pages;
 
-			int l = int(key_length) - nullIndLen - key.key_length;	// must be signed
-
-			if (l > 0)
+			if (dataPages > IDX_PARALLEL_UNIT_PAGES && pointerPages)
 			{
-				memset(p, pad, l);
-				p += l;
+				const ULONG slots = pointerPages->count() * dbb->dbb_dp_per_pp;
+				units = (slots + IDX_PARALLEL_UNIT_PAGES - 1) / IDX_PARALLEL_UNIT_PAGES;
 			}
 
-			const bool key_is_null = (key.key_nulls == (1 << idx->idx_count) - 1);
-
-			index_sort_record* isr = (index_sort_record*) p;
-			isr->isr_record_number = primary.rpb_number.getValue();
-			isr->isr_key_length = key.key_length;
-			isr->isr_flags = ((stack.hasData() || deleted) ? ISR_secondary : 0) | (key_is_null ? ISR_null : 0);
-			if (record != gc_record)
-				delete record;
+			if (units == 1)
+				workers = 1;
 		}
-
-		if (creation.duplicates > 0)
-			break;
-
-		JRD_reschedule(tdbb);
 	}
 
-	gc_record.release();
-
-	if (primary.getWindow(tdbb).win_flags & WIN_large_scan)
-		--relation->rel_scan_count;
+	IndexCreateTask task(tdbb, creation, index_name, partner_relation, partner_index_id,
+		largeScan, units);
+	task.run(tdbb, workers);
 
 	if (!creation.duplicates)
 		scb->sort(tdbb);
@@ -521,6 +666,8 @@ void IDX_create_index(thread_db* tdbb,
 	if (creation.duplicates > 0)
 	{
 		AutoPtr<Record> error_record;
+		record_param primary;
+		primary.rpb_relation = relation;
 		primary.rpb_record = NULL;
 		fb_assert(creation.dup_recno >= 0);
 		primary.rpb_number.setValue(creation.dup_recno);
@@ -537,6 +684,7 @@ void IDX_create_index(thread_db* tdbb,
 
 		}
 
+		IndexErrorContext context(relation, idx, index_name);
 		context.raise(tdbb, idx_e_duplicate, error_record);
 	}
 
@@ -709,7 +857,8 @@ void IDX_erase(thread_db* tdbb, record_param* rpb, jrd_tra* transaction)
 }
 
 
-void IDX_garbage_collect(thread_db* tdbb, record_param* rpb, RecordStack& going, RecordStack& staying)
+void IDX_garbage_collect(thread_db* tdbb, record_param* rpb, RecordStack& going, RecordStack& staying,
+						 IndexGarbage* garbage)
 {
 /**************************************
  *
@@ -720,11 +869,18 @@ void IDX_garbage_collect(thread_db* tdbb, record_param* rpb, RecordStack& going,
  * Functional description
  *	Perform garbage collection for a bunch of records.  Scan
  *	through the indices defined for a relation.  Garbage collect
- *	each.
+ *	each.  If the batch is passed, the keys are only collected to
+ *	be removed later in the index order.
  *
  **************************************/
 	SET_TDBB(tdbb);
 
+	fb_assert(!garbage || garbage->getRelation() == rpb->rpb_relation);
+
+	// Don't let the pending keys of the record be inserted after their removal
+
+	DeferredIndexKeys::flushRecord(tdbb, rpb->rpb_relation, rpb->rpb_number);
+
 	index_desc idx;
 	temporary_key key1, key2;
 
@@ -807,6 +963,12 @@ void IDX_garbage_collect(thread_db* tdbb, record_param* rpb, RecordStack& going,
 
 				// Get rid of index node
 
+				if (garbage)
+				{
+					garbage->add(&idx, &key1, rpb->rpb_number);
+					continue;
+				}
+
 				BTR_remove(tdbb, &window, &insertion);
 				root = (index_root_page*) CCH_FETCH(tdbb, &window, LCK_read, pag_root);
 
@@ -876,6 +1038,12 @@ void IDX_modify(thread_db* tdbb,
 
 		if (!keysEqual(&key1, &key2))
 		{
+			if (transaction->getDeferredKeys()->add(tdbb, transaction, new_rpb->rpb_relation,
+					&idx, &key1, new_rpb->rpb_number))
+			{
+				continue;
+			}
+
 			if ((error_code = insert_key(tdbb, new_rpb->rpb_relation, new_rpb->rpb_record,
 										 transaction, &window, &insertion, context)))
 			{
@@ -883,6 +1051,10 @@ void IDX_modify(thread_db* tdbb,
 			}
 		}
 	}
+
+	DeferredIndexKeys* const deferred = transaction->tra_deferred_keys;
+	if (deferred && deferred->isFull())
+		deferred->flush(tdbb, transaction);
 }
 
 
@@ -1087,12 +1259,24 @@ void IDX_store(thread_db* tdbb, record_param* rpb, jrd_tra* transaction)
 			context.raise(tdbb, error_code, rpb->rpb_record);
 		}
 
+		// The key could be inserted later, in bulk with others
+
+		if (transaction->getDeferredKeys()->add(tdbb, transaction, rpb->rpb_relation,
+				&idx, &key, rpb->rpb_number))
+		{
+			continue;
+		}
+
 		if ( (error_code = insert_key(tdbb, rpb->rpb_relation, rpb->rpb_record, transaction,
 									  &window, &insertion, context)) )
 		{
 			context.raise(tdbb, error_code, rpb->rpb_record);
 		}
 	}
+
+	DeferredIndexKeys* const deferred = transaction->tra_deferred_keys;
+	if (deferred && deferred->isFull())
+		deferred->flush(tdbb, transaction);
 }
 
 static bool cmpRecordKeys(thread_db* tdbb,
@@ -1078,6 +1078,7 @@ namespace Jrd
 		bool	dpb_gbak_attach;
 		bool	dpb_utf8_filename;
 		ULONG	dpb_ext_call_depth;
+		ULONG	dpb_parallel_workers;
 		ULONG	dpb_flags;			// to OR'd with dbb_flags
 		bool	dpb_nolinger;
 		bool	dpb_reset_icu;
@@ -6995,6 +6996,10 @@ void DatabaseOptions::get(const UCHAR* dpb, USHORT dpb_length, bool& invalid_cli
 			rdr.getString(dpb_decfloat_traps);
 			break;
 
+		case isc_dpb_parallel_workers:
+			dpb_parallel_workers = (ULONG) rdr.getInt();
+			break;
+
 		default:
 			break;
 		}
@@ -7239,6 +7244,7 @@ static JAttachment* create_attachment(const PathName& alias_name,
 	attachment->att_client_version = options.dpb_client_version;
 	attachment->att_remote_protocol = options.dpb_remote_protocol;
 	attachment->att_ext_call_depth = options.dpb_ext_call_depth;
+	attachment->att_parallel_workers = options.dpb_parallel_workers;
 
 	StableAttachmentPart* sAtt = FB_NEW StableAttachmentPart(attachment);
 	attachment->setStable(sAtt);
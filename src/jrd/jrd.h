@@ -117,6 +117,7 @@ class ExternalFile;
 class ViewContext;
 class IndexBlock;
 class IndexLock;
+class IndexGarbage;
 class ArrayField;
 struct sort_context;
 class vcl;
@@ -521,6 +522,7 @@ public:
 		  tdbb_quantum(QUANTUM),
 		  tdbb_flags(0),
 		  tdbb_temp_traid(0),
+		  tdbb_index_garbage(NULL),
 		  tdbb_bdbs(*getDefaultMemoryPool()),
 		  tdbb_thread(Firebird::ThreadSync::getThread("thread_db"))
 	{
@@ -545,6 +547,7 @@ public:
 	ULONG		tdbb_flags;
 
 	TraNumber	tdbb_temp_traid;	// current temporary table scope
+	IndexGarbage*	tdbb_index_garbage;	// keys purged by background garbage collector
 
 	// BDB's held by thread
 	Firebird::HalfStaticArray<BufferDesc*, 16> tdbb_bdbs;
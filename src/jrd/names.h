@@ -457,3 +457,33 @@ NAME("MON$SESSION_TIMEZONE", nam_mon_session_tz)
 NAME("RDB$KEYWORDS", nam_keywords)
 NAME("RDB$KEYWORD_NAME", nam_keyword_name)
 NAME("RDB$KEYWORD_RESERVED", nam_keyword_reserved)
+
+NAME("MON$WAIT_STATS", nam_mon_wait_stats)
+NAME("MON$LATCH_WAITS", nam_mon_latch_waits)
+NAME("MON$LATCH_WAIT_TIME", nam_mon_latch_wait_time)
+NAME("MON$LOCK_WAITS", nam_mon_lock_waits)
+NAME("MON$LOCK_WAIT_TIME", nam_mon_lock_wait_time)
+NAME("MON$READ_WAITS", nam_mon_read_waits)
+NAME("MON$READ_WAIT_TIME", nam_mon_read_wait_time)
+NAME("MON$WRITE_WAITS", nam_mon_write_waits)
+NAME("MON$WRITE_WAIT_TIME", nam_mon_write_wait_time)
+
+NAME("RDB$PROFILE_STATEMENTS", nam_prof_statements)
+NAME("RDB$PROFILE_PSQL_STATS", nam_prof_psql_stats)
+NAME("RDB$PROFILE_RECORD_SOURCE_STATS", nam_prof_recsrc_stats)
+NAME("RDB$PROFILE_SESSION_ID", nam_prof_session_id)
+NAME("RDB$PROFILE_STATEMENT_ID", nam_prof_stmt_id)
+NAME("RDB$PARENT_STATEMENT_ID", nam_prof_parent_stmt_id)
+NAME("RDB$ROUTINE_NAME", nam_prof_routine_name)
+NAME("RDB$SQL_TEXT", nam_prof_sql_text)
+NAME("RDB$LINE_NUMBER", nam_prof_line)
+NAME("RDB$COLUMN_NUMBER", nam_prof_column)
+NAME("RDB$MIN_ELAPSED_TIME", nam_prof_min_time)
+NAME("RDB$MAX_ELAPSED_TIME", nam_prof_max_time)
+NAME("RDB$TOTAL_ELAPSED_TIME", nam_prof_total_time)
+NAME("RDB$RECORD_SOURCE_ID", nam_prof_recsrc_id)
+NAME("RDB$ACCESS_PATH", nam_prof_access_path)
+NAME("RDB$OPEN_COUNTER", nam_prof_open_counter)
+NAME("RDB$OPEN_ELAPSED_TIME", nam_prof_open_time)
+NAME("RDB$FETCH_COUNTER", nam_prof_fetch_counter)
+NAME("RDB$FETCH_ELAPSED_TIME", nam_prof_fetch_time)
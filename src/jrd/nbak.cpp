@@ -46,6 +46,7 @@
 #include "../common/os/isc_i_proto.h"
 #include "../jrd/CryptoManager.h"
 #include "../jrd/replication/Publisher.h"
+#include "../common/os/os_utils.h"
 
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
@@ -63,6 +64,14 @@
 #include <errno.h>
 #endif
 
+#ifdef WIN_NT
+#include <io.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY	0
+#endif
+
 #ifdef NBAK_DEBUG
 #include <stdarg.h>
 IMPLEMENT_TRACE_ROUTINE(nbak_trace, "NBAK")
@@ -157,6 +166,190 @@ void NBackupAllocLock::invalidate(thread_db* tdbb)
 	NBAK_TRACE(("invalidate alloc table allocLock(%p)", this));
 }
 
+/******************************** ChangedPageMap ******************************/
+
+ChangedPageMap::ChangedPageMap(MemoryPool& pool, Database* database) :
+	m_database(database), m_fileName(pool), m_entries(pool), m_handle(-1), m_failed(false)
+{
+	getFileName(database->dbb_filename, m_fileName);
+}
+
+ChangedPageMap::~ChangedPageMap()
+{
+	if (m_handle >= 0)
+		::close(m_handle);
+}
+
+void ChangedPageMap::remove(const PathName& dbName)
+{
+	PathName fileName;
+	getFileName(dbName, fileName);
+
+	if (unlink(fileName.c_str()) != 0 && errno != ENOENT)
+	{
+		// Stale map would make incremental backups miss the changes
+		gds__log("Cannot remove the changed page map %s, error %d. "
+				 "Remove it before the next incremental backup.", fileName.c_str(), errno);
+	}
+}
+
+void ChangedPageMap::open(ULONG scn)
+{
+	fb_assert(m_handle < 0);
+
+	m_handle = os_utils::openCreateSharedFile(m_fileName.c_str(), O_BINARY);
+
+	Ods::page_map_header header;
+	memset(&header, 0, sizeof(header));
+
+	const ULONG pageSize = m_database->dbb_page_size;
+	const ULONG pagesPerSCN = m_database->dbb_page_manager.pagesPerSCN;
+
+	if (::read(m_handle, &header, sizeof(header)) == sizeof(header) &&
+		!memcmp(header.pmh_signature, Ods::PAGE_MAP_SIGNATURE, sizeof(header.pmh_signature)) &&
+		header.pmh_version == Ods::PAGE_MAP_VERSION1 &&
+		header.pmh_page_size == pageSize / 1024 &&
+		header.pmh_pages_per_scn == pagesPerSCN &&
+		header.pmh_scn <= scn + 1)
+	{
+		// The map is maintained since pmh_scn, continue with it
+		return;
+	}
+
+	// The map is missing, broken or it was not maintained for some time.
+	// Start it from the next SCN, the existing entries (if any) are lower
+	// than that and thus don't break anything. The file is not truncated
+	// as another process could already write its entries there.
+
+	memcpy(header.pmh_signature, Ods::PAGE_MAP_SIGNATURE, sizeof(header.pmh_signature));
+	header.pmh_version = Ods::PAGE_MAP_VERSION1;
+	header.pmh_page_size = pageSize / 1024;
+	header.pmh_pages_per_scn = pagesPerSCN;
+	header.pmh_scn = scn + 1;
+
+	if (os_utils::lseek(m_handle, 0, SEEK_SET) != 0 ||
+		::write(m_handle, &header, sizeof(header)) != sizeof(header))
+	{
+		system_call_failed::raise("write");
+	}
+}
+
+bool ChangedPageMap::getStartScn(ULONG& scn)
+{
+	const SINT64 offset = offsetof(Ods::page_map_header, pmh_scn);
+
+	return os_utils::lseek(m_handle, offset, SEEK_SET) == offset &&
+		::read(m_handle, &scn, sizeof(ULONG)) == sizeof(ULONG);
+}
+
+bool ChangedPageMap::setStartScn(ULONG scn)
+{
+	// Never lower the starting SCN set by another process
+
+	ULONG current;
+	if (!getStartScn(current))
+		return false;
+
+	if (current >= scn)
+		return true;
+
+	const SINT64 offset = offsetof(Ods::page_map_header, pmh_scn);
+
+	if (os_utils::lseek(m_handle, offset, SEEK_SET) != offset ||
+		::write(m_handle, &scn, sizeof(ULONG)) != sizeof(ULONG))
+	{
+		return false;
+	}
+
+#ifdef WIN_NT
+	return FlushFileBuffers((HANDLE) _get_osfhandle(m_handle)) != 0;
+#else
+	return fsync(m_handle) == 0;
+#endif
+}
+
+void ChangedPageMap::invalidate(const char* syscall, ULONG scn)
+{
+	gds__log("Error %d in %s for the changed page map %s, it is restarted from SCN %" ULONGFORMAT,
+		errno, syscall, m_fileName.c_str(), scn + 1);
+
+	// The change may be missing in the map. The file is not removed as other
+	// processes keep writing into it, instead the map is declared reliable
+	// starting with the next SCN only. The changes of the current SCN are not
+	// needed by the backups relying on the map.
+
+	if (m_handle >= 0 && setStartScn(scn + 1))
+		return;
+
+	gds__log("Cannot restart the changed page map %s, tracking of changed pages is disabled. "
+			 "Remove it before the next incremental backup.", m_fileName.c_str());
+
+	m_failed = true;
+}
+
+void ChangedPageMap::markChanged(ULONG sequence, ULONG scn)
+{
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	if (m_failed)
+		return;
+
+	if (sequence < m_entries.getCount() && m_entries[sequence] >= scn)
+		return;
+
+	try
+	{
+		if (m_handle < 0)
+			open(scn);
+	}
+	catch (const Exception&)
+	{
+		invalidate("open", scn);
+		return;
+	}
+
+	// Check whether the map is restarted after a failure, by this or another
+	// process. The changes made before its starting SCN are not needed.
+
+	ULONG startScn;
+	if (!getStartScn(startScn))
+	{
+		invalidate("read", scn);
+		return;
+	}
+
+	if (scn < startScn)
+		return;
+
+	const SINT64 offset = sizeof(Ods::page_map_header) + (SINT64) sequence * sizeof(ULONG);
+
+	if (os_utils::lseek(m_handle, offset, SEEK_SET) != offset ||
+		::write(m_handle, &scn, sizeof(ULONG)) != sizeof(ULONG))
+	{
+		invalidate("write", scn);
+		return;
+	}
+
+	if (m_database->dbb_flags & DBB_force_write)
+	{
+#ifdef WIN_NT
+		if (!FlushFileBuffers((HANDLE) _get_osfhandle(m_handle)))
+#else
+		if (fsync(m_handle) != 0)
+#endif
+		{
+			invalidate("fsync", scn);
+			return;
+		}
+	}
+
+	if (sequence >= m_entries.getCount())
+		m_entries.grow(sequence + 1);
+
+	m_entries[sequence] = scn;
+}
+
+
 /******************************** BackupManager::StateWriteGuard ******************************/
 
 BackupManager::StateWriteGuard::StateWriteGuard(thread_db* tdbb, Jrd::WIN* window)
@@ -900,7 +1093,7 @@ void BackupManager::setForcedWrites(const bool forceWrite, const bool notUseFSCa
 BackupManager::BackupManager(thread_db* tdbb, Database* _database, int ini_state) :
 	dbCreating(false), database(_database), diff_file(NULL), alloc_table(NULL),
 	last_allocated_page(0), current_scn(0), diff_name(*_database->dbb_permanent),
-	explicit_diff_name(false), flushInProgress(false), shutDown(false), allocIsValid(false),
+	changedPages(NULL), explicit_diff_name(false), flushInProgress(false), shutDown(false), allocIsValid(false),
 	master(false), stateBlocking(false),
 	stateLock(FB_NEW_POOL(*database->dbb_permanent) NBackupStateLock(tdbb, *database->dbb_permanent, this)),
 	allocLock(FB_NEW_POOL(*database->dbb_permanent) NBackupAllocLock(tdbb, *database->dbb_permanent, this))
@@ -917,6 +1110,11 @@ BackupManager::BackupManager(thread_db* tdbb, Database* _database, int ini_state
 	spare_buffer = reinterpret_cast<ULONG*>(temp_buffers + database->dbb_page_size);
 	alloc_buffer = reinterpret_cast<ULONG*>(temp_buffers + database->dbb_page_size * 2);
 
+	if (database->dbb_config->getTrackChangedPages())
+		changedPages = FB_NEW_POOL(*database->dbb_permanent) ChangedPageMap(*database->dbb_permanent, database);
+	else
+		ChangedPageMap::remove(database->dbb_filename);
+
 	NBAK_TRACE(("Create BackupManager, database=%s", database->dbb_filename.c_str()));
 }
 
@@ -925,6 +1123,7 @@ BackupManager::~BackupManager()
 	delete stateLock;
 	delete allocLock;
 	delete alloc_table;
+	delete changedPages;
 	delete[] temp_buffers_space;
 }
 
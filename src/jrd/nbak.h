@@ -34,6 +34,8 @@
 #include "../common/classes/rwlock.h"
 #include "../common/classes/alloc.h"
 #include "../common/classes/fb_string.h"
+#include "../common/classes/array.h"
+#include "../common/classes/locks.h"
 #include "GlobalRWLock.h"
 #include "../jrd/err_proto.h"
 #include "../jrd/Attachment.h"
@@ -124,6 +126,8 @@ protected:
  *  4. to mark pages written by the engine with the current SCN [System Change
  *  Number] counter value for the database
  *  5. to increment SCN on each change of backup state
+ *  6. to maintain the map of changed pages for incremental nbackup when asked
+ *  (TrackChangedPages setting), see ChangedPageMap below
  *
  *  The backup state cycle is:
  *  hdr_nbak_normal -> hdr_nbak_stalled -> hdr_nbak_merge -> hdr_nbak_normal
@@ -172,6 +176,50 @@ protected:
  */
 
 
+// Map of changed pages kept in the file <database>.pagemap, its format is
+// described by Ods::page_map_header. The entry of the range of pages is
+// written (and flushed if forced writes are on) when the first page of the
+// range gets the SCN greater than the stored one, i.e. before that page could
+// be written to disk. Thus the map may describe more changes than were really
+// written but it never misses any of them.
+//
+// The file is shared by all processes working with the database. If an entry
+// can't be written, the map is restarted from the next SCN by raising pmh_scn
+// in its header, thus nbackup falls back to the full scan of the database for
+// the levels based on the earlier SCN's. The starting SCN is checked by every
+// process before it writes an entry.
+
+class ChangedPageMap
+{
+public:
+	ChangedPageMap(MemoryPool& pool, Database* database);
+	~ChangedPageMap();
+
+	// Record the change of page with the given SCN in the range of SCN page
+	void markChanged(ULONG sequence, ULONG scn);
+
+	static void remove(const Firebird::PathName& dbName);
+
+	static void getFileName(const Firebird::PathName& dbName, Firebird::PathName& fileName)
+	{
+		fileName = dbName + ".pagemap";
+	}
+
+private:
+	void open(ULONG scn);
+	bool getStartScn(ULONG& scn);
+	bool setStartScn(ULONG scn);
+	void invalidate(const char* syscall, ULONG scn);
+
+	Database* const m_database;
+	Firebird::Mutex m_mutex;
+	Firebird::PathName m_fileName;
+	Firebird::Array<ULONG> m_entries;	// entries known to be written
+	int m_handle;
+	bool m_failed;
+};
+
+
 class BackupManager
 {
 private:
@@ -370,6 +418,13 @@ public:
 		return current_scn;
 	}
 
+	// Record the change of page with the given SCN in the range of SCN page
+	void markChanged(ULONG sequence, ULONG scn)
+	{
+		if (changedPages)
+			changedPages->markChanged(sequence, scn);
+	}
+
 	// Initialize and open difference file for writing
 	void beginBackup(thread_db* tdbb);
 
@@ -497,6 +552,7 @@ private:
 	ULONG *alloc_buffer, *empty_buffer, *spare_buffer;
 	ULONG current_scn;
 	Firebird::PathName diff_name;
+	ChangedPageMap* changedPages;	// map of changed pages, if tracked
 	bool explicit_diff_name;
 	bool flushInProgress;
 	bool shutDown;
@@ -124,7 +124,8 @@ const USHORT ODS_CURRENT12		= 0;
 
 const USHORT ODS_CURRENT13_0	= 0;	// Firebird 4.0 features
 const USHORT ODS_CURRENT13_1	= 1;	// Firebird 4.1 features
-const USHORT ODS_CURRENT13		= 1;
+const USHORT ODS_CURRENT13_2	= 2;	// Long runs in record compression
+const USHORT ODS_CURRENT13		= 2;
 
 // useful ODS macros. These are currently used to flag the version of the
 // system triggers and system indices in ini.e
@@ -146,6 +147,7 @@ const USHORT ODS_11_2		= ENCODE_ODS(ODS_VERSION11, 2);
 const USHORT ODS_12_0		= ENCODE_ODS(ODS_VERSION12, 0);
 const USHORT ODS_13_0		= ENCODE_ODS(ODS_VERSION13, 0);
 const USHORT ODS_13_1		= ENCODE_ODS(ODS_VERSION13, 1);
+const USHORT ODS_13_2		= ENCODE_ODS(ODS_VERSION13, 2);
 
 const USHORT ODS_FIREBIRD_FLAG = 0x8000;
 
@@ -173,7 +175,7 @@ const USHORT ODS_RELEASED = ODS_CURRENT13_0;	// The lowest stable minor version
 const USHORT ODS_CURRENT = ODS_CURRENT13;		// The highest defined minor version
 												// number for this ODS_VERSION!
 
-const USHORT ODS_CURRENT_VERSION = ODS_13_1;	// Current ODS version in use which includes
+const USHORT ODS_CURRENT_VERSION = ODS_13_2;	// Current ODS version in use which includes
 												// both major and minor ODS versions!
 
 
@@ -628,6 +630,34 @@ static_assert(offsetof(struct scns_page, scn_pages) == 20, "scn_pages offset mis
 //    32768       261920            8187           8185
 //    65536       524064           16379          16377
 
+
+// Changed page map. It is not a database page but the header of the file
+// <database>.pagemap maintained by the engine when TrackChangedPages is set.
+// The header is followed by the vector of ULONG's, one per SCN page: the
+// highest SCN ever assigned to a page described by that SCN page. The vector
+// is reliable for the changes made with SCN not less than pmh_scn, nbackup
+// uses it to skip the ranges of pages not changed since the previous level.
+
+const char PAGE_MAP_SIGNATURE[] = "FBCHGPAGEMAP";
+const USHORT PAGE_MAP_VERSION1 = 1;
+
+struct page_map_header
+{
+	char pmh_signature[12];		// PAGE_MAP_SIGNATURE without trailing zero
+	USHORT pmh_version;			// PAGE_MAP_VERSION1
+	USHORT pmh_page_size;		// Database page size in kilobytes
+	ULONG pmh_pages_per_scn;	// Number of pages described by SCN page
+	ULONG pmh_scn;				// The map is reliable starting with this SCN
+};
+
+static_assert(sizeof(struct page_map_header) == 24, "struct page_map_header size mismatch");
+static_assert(offsetof(struct page_map_header, pmh_signature) == 0, "pmh_signature offset mismatch");
+static_assert(offsetof(struct page_map_header, pmh_version) == 12, "pmh_version offset mismatch");
+static_assert(offsetof(struct page_map_header, pmh_page_size) == 14, "pmh_page_size offset mismatch");
+static_assert(offsetof(struct page_map_header, pmh_pages_per_scn) == 16, "pmh_pages_per_scn offset mismatch");
+static_assert(offsetof(struct page_map_header, pmh_scn) == 20, "pmh_scn offset mismatch");
+
+
 // Pointer Page
 
 struct pointer_page
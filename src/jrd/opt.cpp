@@ -76,6 +76,7 @@
 #include "../yvalve/gds_proto.h"
 #include "../jrd/DataTypeUtil.h"
 #include "../jrd/KeywordsTable.h"
+#include "../jrd/Profiler.h"
 #include "../jrd/RecordSourceNodes.h"
 #include "../jrd/VirtualTable.h"
 #include "../jrd/Monitoring.h"
@@ -167,6 +168,17 @@ namespace
 			return m_streams;
 		}
 
+		double getCardinality(const CompilerScratch* csb) const
+		{
+			// Rough estimation: the largest base stream of the river
+			double cardinality = MINIMUM_CARDINALITY;
+
+			for (const StreamType* iter = m_streams.begin(); iter < m_streams.end(); iter++)
+				cardinality = MAX(cardinality, csb->csb_rpt[*iter].csb_cardinality);
+
+			return cardinality;
+		}
+
 		void activate(CompilerScratch* csb)
 		{
 			for (const StreamType* iter = m_streams.begin(); iter < m_streams.end(); iter++)
@@ -2322,6 +2334,12 @@ static RecordSource* gen_retrieval(thread_db*     tdbb,
 			rsb = FB_NEW_POOL(*tdbb->getDefaultPool()) KeywordsTableScan(csb, alias, stream, relation);
 			break;
 
+		case rel_prof_statements:
+		case rel_prof_psql_stats:
+		case rel_prof_recsrc_stats:
+			rsb = FB_NEW_POOL(*tdbb->getDefaultPool()) ProfilerTableScan(csb, alias, stream, relation);
+			break;
+
 		default:
 			rsb = FB_NEW_POOL(*tdbb->getDefaultPool()) MonitoringTableScan(csb, alias, stream, relation);
 			break;
@@ -2985,6 +3003,7 @@ static bool gen_equi_join(thread_db* tdbb, OptimizerBlk* opt, RiverList& org_riv
 
 	HalfStaticArray<RecordSource*, OPT_STATIC_ITEMS> rsbs;
 	HalfStaticArray<NestValueArray*, OPT_STATIC_ITEMS> keys;
+	HalfStaticArray<double, OPT_STATIC_ITEMS> cardinalities;
 
 	// Unconditionally disable merge joins in favor of hash joins.
 	// This is a temporary debugging measure.
@@ -3060,6 +3079,7 @@ static bool gen_equi_join(thread_db* tdbb, OptimizerBlk* opt, RiverList& org_riv
 		{
 			rsbs.insert(0, rsb);
 			keys.insert(0, &key->expressions);
+			cardinalities.insert(0, river->getCardinality(csb));
 		}
 	}
 
@@ -3077,7 +3097,8 @@ static bool gen_equi_join(thread_db* tdbb, OptimizerBlk* opt, RiverList& org_riv
 	else
 	{
 		rsb = FB_NEW_POOL(*tdbb->getDefaultPool())
-			HashJoin(tdbb, csb, rsbs.getCount(), rsbs.begin(), keys.begin());
+			HashJoin(tdbb, csb, rsbs.getCount(), rsbs.begin(), keys.begin(),
+					 cardinalities.begin());
 	}
 
 	// Activate streams of all the rivers being merged
@@ -34,10 +34,18 @@
 #include "../common/classes/array.h"
 #include "../common/classes/File.h"
 
+namespace Ods {
+	struct pag;
+}
+
 namespace Jrd {
 
+class BufferDesc;
+
 #ifdef UNIX
 
+class IoRing;
+
 class jrd_file : public pool_alloc_rpt<SCHAR, type_fil>
 {
 public:
@@ -48,6 +56,7 @@ public:
 	USHORT fil_fudge;			// Fudge factor for page relocation
 	int fil_desc;
 	Firebird::Mutex fil_mutex;
+	IoRing* fil_ring;			// io_uring instance used for batched I/O
 	USHORT fil_flags;
 	SCHAR fil_string[1];		// Expanded file name
 };
@@ -89,6 +98,15 @@ const USHORT FIL_readonly			= 4;	// file opened in readonly mode
 const USHORT FIL_sh_write			= 8;	// file opened in shared write mode
 const USHORT FIL_no_fast_extend		= 16;	// file not supports fast extending
 const USHORT FIL_raw_device			= 32;	// file is raw device
+const USHORT FIL_no_ring			= 64;	// io_uring is not available
+
+// Page transfer of the batched page I/O (PIO_read_pages, PIO_write_pages)
+
+struct PageIo
+{
+	BufferDesc* pio_bdb;		// buffer descriptor, defines the page number
+	Ods::pag* pio_page;			// page image to read into or write from
+};
 
 // Physical IO trace events
 
@@ -30,6 +30,7 @@ namespace Jrd {
 	class jrd_file;
 	class Database;
 	class BufferDesc;
+	struct PageIo;
 }
 
 namespace Ods {
@@ -50,6 +51,7 @@ USHORT	PIO_init_data(Jrd::thread_db*, Jrd::jrd_file*, Jrd::FbStatusVector*, ULON
 Jrd::jrd_file*	PIO_open(Jrd::thread_db*, const Firebird::PathName&,
 						 const Firebird::PathName&);
 bool	PIO_read(Jrd::thread_db*, Jrd::jrd_file*, Jrd::BufferDesc*, Ods::pag*, Jrd::FbStatusVector*);
+bool	PIO_read_pages(Jrd::thread_db*, Jrd::jrd_file*, Jrd::PageIo*, FB_SIZE_T, Jrd::FbStatusVector*);
 
 #ifdef SUPERSERVER_V2
 bool	PIO_read_ahead(Jrd::thread_db*, SLONG, SCHAR*, SLONG,
@@ -67,6 +69,7 @@ inline bool PIO_on_raw_device(const Firebird::PathName&)
 }
 #endif
 bool	PIO_write(Jrd::thread_db*, Jrd::jrd_file*, Jrd::BufferDesc*, Ods::pag*, Jrd::FbStatusVector*);
+bool	PIO_write_pages(Jrd::thread_db*, Jrd::jrd_file*, Jrd::PageIo*, FB_SIZE_T, Jrd::FbStatusVector*);
 
 #endif // JRD_PIO_PROTO_H
 
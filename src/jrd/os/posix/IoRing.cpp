@@ -0,0 +1,312 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		IoRing.cpp
+ *	DESCRIPTION:	Batched asynchronous file I/O using Linux io_uring
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../jrd/os/posix/IoRing.h"
+#include "../common/ThreadStart.h"
+
+#include <errno.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace Jrd;
+using namespace Firebird;
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define USE_IO_URING
+#endif
+
+// Attempts to enter the ring failed by other reason than a signal
+// before the ring is given up
+const unsigned MAX_ENTER_FAILURES = 8;
+
+
+IoRing::IoRing()
+	: m_desc(-1), m_broken(false),
+	  m_sqRing(NULL), m_sqRingSize(0),
+	  m_cqRing(NULL), m_cqRingSize(0),
+	  m_sqes(NULL), m_sqesSize(0),
+	  m_sqHead(NULL), m_sqTail(NULL), m_sqMask(0), m_sqArray(NULL), m_sqEntries(0),
+	  m_cqHead(NULL), m_cqTail(NULL), m_cqMask(0), m_cqes(NULL)
+{
+}
+
+
+IoRing* IoRing::create(MemoryPool& pool, unsigned entries)
+{
+	IoRing* const ring = FB_NEW_POOL(pool) IoRing;
+
+	if (!ring->setup(entries))
+	{
+		delete ring;
+		return NULL;
+	}
+
+	return ring;
+}
+
+
+#ifdef USE_IO_URING
+
+IoRing::~IoRing()
+{
+	if (m_sqes)
+		munmap(m_sqes, m_sqesSize);
+
+	if (m_cqRing && m_cqRing != m_sqRing)
+		munmap(m_cqRing, m_cqRingSize);
+
+	if (m_sqRing)
+		munmap(m_sqRing, m_sqRingSize);
+
+	if (m_desc >= 0)
+		close(m_desc);
+}
+
+
+bool IoRing::setup(unsigned entries)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	m_desc = syscall(__NR_io_uring_setup, entries, &params);
+
+	if (m_desc < 0)
+		return false;
+
+	m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	// Old kernels need the completion ring to be mapped separately
+
+#ifdef IORING_FEAT_SINGLE_MMAP
+	const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP);
+#else
+	const bool singleMap = false;
+#endif
+
+	if (singleMap)
+		m_sqRingSize = m_cqRingSize = MAX(m_sqRingSize, m_cqRingSize);
+
+	void* ptr = mmap(NULL, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		m_desc, IORING_OFF_SQ_RING);
+
+	if (ptr == MAP_FAILED)
+		return false;
+
+	m_sqRing = ptr;
+
+	if (singleMap)
+		m_cqRing = m_sqRing;
+	else
+	{
+		ptr = mmap(NULL, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			m_desc, IORING_OFF_CQ_RING);
+
+		if (ptr == MAP_FAILED)
+			return false;
+
+		m_cqRing = ptr;
+	}
+
+	m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	ptr = mmap(NULL, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		m_desc, IORING_OFF_SQES);
+
+	if (ptr == MAP_FAILED)
+		return false;
+
+	m_sqes = ptr;
+
+	UCHAR* const sq = static_cast<UCHAR*>(m_sqRing);
+	m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	m_sqEntries = params.sq_entries;
+
+	UCHAR* const cq = static_cast<UCHAR*>(m_cqRing);
+	m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	m_cqes = cq + params.cq_off.cqes;
+
+	return true;
+}
+
+
+void IoRing::execute(Request* requests, unsigned count)
+{
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	if (m_broken)
+	{
+		for (unsigned n = 0; n < count; n++)
+			requests[n].result = -EIO;
+
+		return;
+	}
+
+	struct io_uring_sqe* const sqes = static_cast<struct io_uring_sqe*>(m_sqes);
+	const struct io_uring_cqe* const cqes = static_cast<const struct io_uring_cqe*>(m_cqes);
+
+	for (unsigned start = 0; start < count; )
+	{
+		const unsigned batch = MIN(count - start, m_sqEntries);
+
+		// Fill submission queue entries. We are the only producer,
+		// the kernel only advances the head.
+
+		unsigned tail = *m_sqTail;
+
+		for (unsigned n = start; n < start + batch; n++, tail++)
+		{
+			const Request& request = requests[n];
+			const unsigned index = tail & m_sqMask;
+
+			struct io_uring_sqe* const sqe = &sqes[index];
+			memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = request.write ? IORING_OP_WRITEV : IORING_OP_READV;
+			sqe->fd = request.desc;
+			sqe->off = request.offset;
+			sqe->addr = (IPTR) request.iov;
+			sqe->len = request.iovcnt;
+			sqe->user_data = n;
+
+			m_sqArray[index] = index;
+			requests[n].result = -EINPROGRESS;
+		}
+
+		__atomic_store_n(m_sqTail, tail, __ATOMIC_RELEASE);
+
+		unsigned toSubmit = batch;
+		unsigned pending = batch;
+		unsigned failures = 0;
+
+		while (pending)
+		{
+			int rc = 0;
+
+			if (!m_broken)
+			{
+				rc = syscall(__NR_io_uring_enter, m_desc, toSubmit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+
+				if (rc < 0)
+				{
+					if (SYSCALL_INTERRUPTED(errno))
+						continue;
+
+					const int error = errno;
+
+					if (++failures < MAX_ENTER_FAILURES)
+					{
+						Thread::sleep(1);
+						continue;
+					}
+
+					// Give up the ring. The entries not submitted are taken back,
+					// the kernel did not consume them.
+
+					m_broken = true;
+					rc = 0;
+
+					if (toSubmit)
+					{
+						__atomic_store_n(m_sqTail, *m_sqTail - toSubmit, __ATOMIC_RELEASE);
+
+						for (unsigned n = start + batch - toSubmit; n < start + batch; n++)
+							requests[n].result = -error;
+
+						pending -= toSubmit;
+						toSubmit = 0;
+					}
+				}
+				else
+					failures = 0;
+			}
+			else
+			{
+				// The entries in flight can't be waited for. Their buffers must not
+				// be reused until they are complete, thus poll the completion ring.
+				// Completions are posted when the thread returns from a system call.
+
+				Thread::sleep(1);
+			}
+
+			toSubmit -= MIN((unsigned) rc, toSubmit);
+
+			// Reap completions
+
+			unsigned head = *m_cqHead;
+			const unsigned cqTail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+
+			for (; head != cqTail; head++)
+			{
+				const struct io_uring_cqe* const cqe = &cqes[head & m_cqMask];
+				requests[cqe->user_data].result = cqe->res;
+				pending--;
+			}
+
+			__atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+		}
+
+		start += batch;
+
+		if (m_broken)
+		{
+			for (unsigned n = start; n < count; n++)
+				requests[n].result = -EIO;
+
+			break;
+		}
+	}
+}
+
+#else // USE_IO_URING
+
+IoRing::~IoRing()
+{
+}
+
+
+bool IoRing::setup(unsigned)
+{
+	return false;
+}
+
+
+void IoRing::execute(Request* requests, unsigned count)
+{
+	for (unsigned n = 0; n < count; n++)
+		requests[n].result = -ENOSYS;
+}
+
+#endif // USE_IO_URING
@@ -0,0 +1,100 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		IoRing.h
+ *	DESCRIPTION:	Batched asynchronous file I/O using Linux io_uring
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created by the Firebird Project.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#ifndef JRD_OS_POSIX_IO_RING_H
+#define JRD_OS_POSIX_IO_RING_H
+
+#include "firebird.h"
+#include <sys/uio.h>
+#include "../common/classes/alloc.h"
+#include "../common/classes/locks.h"
+
+namespace Jrd {
+
+// Submission and completion rings shared with the kernel. A batch of
+// requests is submitted using a single system call and the caller waits
+// until all of them are complete, thus many page transfers are in flight
+// at once instead of being done one by one using pread/pwrite.
+//
+// The ring is used by one thread at a time. Requests which failed or
+// transferred less than requested are reported as is, the caller is
+// expected to redo them synchronously. If the kernel keeps refusing to
+// enter the ring, the requests in flight are reaped and the ring is
+// marked as broken, it fails all requests since then.
+
+class IoRing
+{
+public:
+	struct Request
+	{
+		int desc;					// file descriptor
+		bool write;					// write or read
+		FB_UINT64 offset;			// file offset
+		const struct iovec* iov;	// buffers
+		unsigned iovcnt;			// number of buffers
+		SINT64 result;				// bytes transferred or -errno
+	};
+
+	// Returns NULL if io_uring is not supported by the OS
+	static IoRing* create(Firebird::MemoryPool& pool, unsigned entries);
+
+	~IoRing();
+
+	// Submit the requests and wait for their completion
+	void execute(Request* requests, unsigned count);
+
+	bool isBroken() const
+	{
+		return m_broken;
+	}
+
+private:
+	IoRing();
+
+	bool setup(unsigned entries);
+
+	Firebird::Mutex m_mutex;
+	int m_desc;
+	bool m_broken;
+
+	void* m_sqRing;
+	size_t m_sqRingSize;
+	void* m_cqRing;
+	size_t m_cqRingSize;
+	void* m_sqes;
+	size_t m_sqesSize;
+
+	unsigned* m_sqHead;
+	unsigned* m_sqTail;
+	unsigned m_sqMask;
+	unsigned* m_sqArray;
+	unsigned m_sqEntries;
+
+	unsigned* m_cqHead;
+	unsigned* m_cqTail;
+	unsigned m_cqMask;
+	void* m_cqes;
+};
+
+} // namespace Jrd
+
+#endif // JRD_OS_POSIX_IO_RING_H
@@ -60,6 +60,7 @@
 
 #include "../jrd/jrd.h"
 #include "../jrd/os/pio.h"
+#include "../jrd/os/posix/IoRing.h"
 #include "../jrd/ods.h"
 #include "../jrd/lck.h"
 #include "../jrd/cch.h"
@@ -90,6 +91,12 @@ using namespace Firebird;
 
 #define IO_RETRY	20
 
+// Size of io_uring submission queue. Larger batches are submitted by parts.
+const unsigned IO_RING_ENTRIES = 64;
+
+// Maximum number of adjacent pages transferred by single vectored request
+const unsigned MAX_IO_VECTOR = 64;
+
 #ifdef O_SYNC
 #define SYNC		O_SYNC
 #endif
@@ -124,6 +131,8 @@ static const mode_t MASK = 0660;
 
 #define FCNTL_BROKEN
 static jrd_file* seek_file(jrd_file*, BufferDesc*, FB_UINT64*, FbStatusVector*);
+static IoRing* get_ring(Database*, jrd_file*);
+static bool batch_io(thread_db*, jrd_file*, PageIo*, FB_SIZE_T, bool, FbStatusVector*);
 static jrd_file* setup_file(Database*, const PathName&, const int, const bool, const bool, const bool);
 static void lockDatabaseFile(int& desc, const bool shareMode, const bool temporary,
 							 const char* fileName, ISC_STATUS operation);
@@ -197,6 +206,9 @@ void PIO_close(jrd_file* main_file)
 			close(file->fil_desc);
 			file->fil_desc = -1;
 		}
+
+		delete file->fil_ring;
+		file->fil_ring = NULL;
 	}
 }
 
@@ -756,6 +768,7 @@ bool PIO_read(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 
 	Database* const dbb = tdbb->getDatabase();
 
+	RuntimeStatistics::WaitTimer timer(tdbb, RuntimeStatistics::READ_WAITS);
 	EngineCheckout cout(tdbb, FB_FUNCTION, true);
 
 	const SLONG size = dbb->dbb_page_size;
@@ -796,6 +809,23 @@ bool PIO_read(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+bool PIO_read_pages(thread_db* tdbb, jrd_file* file, PageIo* pages, FB_SIZE_T count,
+	FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ r e a d _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read a batch of pages.
+ *
+ **************************************/
+	return batch_io(tdbb, file, pages, count, false, status_vector);
+}
+
+
 bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page, FbStatusVector* status_vector)
 {
 /**************************************
@@ -817,6 +847,7 @@ bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 
 	Database* const dbb = tdbb->getDatabase();
 
+	RuntimeStatistics::WaitTimer timer(tdbb, RuntimeStatistics::WRITE_WAITS);
 	EngineCheckout cout(tdbb, FB_FUNCTION, true);
 
 	const SLONG size = dbb->dbb_page_size;
@@ -837,6 +868,205 @@ bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+bool PIO_write_pages(thread_db* tdbb, jrd_file* file, PageIo* pages, FB_SIZE_T count,
+	FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ w r i t e _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write a batch of pages.
+ *
+ **************************************/
+	return batch_io(tdbb, file, pages, count, true, status_vector);
+}
+
+
+static IoRing* get_ring(Database* dbb, jrd_file* file)
+{
+/**************************************
+ *
+ *	g e t _ r i n g
+ *
+ **************************************
+ *
+ * Functional description
+ *	Return io_uring instance of the file, create it
+ *	when used first time. Return NULL if io_uring is
+ *	not enabled or not supported.
+ *
+ **************************************/
+	if (!dbb->dbb_config->getUseIoUring() || (file->fil_flags & FIL_no_ring))
+		return NULL;
+
+	MutexLockGuard guard(file->fil_mutex, FB_FUNCTION);
+
+	if (!file->fil_ring && !(file->fil_flags & FIL_no_ring))
+	{
+		file->fil_ring = IoRing::create(*dbb->dbb_permanent, IO_RING_ENTRIES);
+
+		if (!file->fil_ring)
+		{
+			file->fil_flags |= FIL_no_ring;
+			gds__log("Database %s: io_uring is not available, using synchronous I/O",
+				file->fil_string);
+		}
+	}
+
+	return file->fil_ring;
+}
+
+
+static bool batch_io(thread_db* tdbb, jrd_file* file, PageIo* pages, FB_SIZE_T count,
+	bool write, FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	b a t c h _ i o
+ *
+ **************************************
+ *
+ * Functional description
+ *	Transfer a batch of pages. Pages adjacent in the same
+ *	file are transferred by single vectored request. When
+ *	io_uring is used all requests are submitted at once.
+ *	Any page not transferred completely is transferred
+ *	again using the regular single page I/O.
+ *
+ **************************************/
+	Database* const dbb = tdbb->getDatabase();
+	const SLONG size = dbb->dbb_page_size;
+
+	HalfStaticArray<bool, IO_RING_ENTRIES> done;
+	bool* const pageDone = done.getBuffer(count);
+	memset(pageDone, 0, count * sizeof(bool));
+
+	IoRing* const ring = get_ring(dbb, file);
+
+#if defined(HAVE_PREADV) && defined(HAVE_PWRITEV)
+	const bool vectored = true;
+#else
+	const bool vectored = false;
+#endif
+
+	if (count > 1 && (ring || vectored))
+	{
+		HalfStaticArray<IoRing::Request, IO_RING_ENTRIES> requests;
+		HalfStaticArray<FB_SIZE_T, IO_RING_ENTRIES> firstPages;
+		HalfStaticArray<struct iovec, IO_RING_ENTRIES> vectors;
+		struct iovec* const iov = vectors.getBuffer(count);
+
+		for (FB_SIZE_T n = 0; n < count; n++)
+		{
+			FB_UINT64 offset;
+			jrd_file* const pageFile = seek_file(file, pages[n].pio_bdb, &offset, status_vector);
+
+			if (!pageFile)
+				return false;
+
+			iov[n].iov_base = pages[n].pio_page;
+			iov[n].iov_len = size;
+
+			if (requests.hasData())
+			{
+				IoRing::Request& last = requests.back();
+
+				if (last.desc == pageFile->fil_desc && last.iovcnt < MAX_IO_VECTOR &&
+					last.offset + (FB_UINT64) last.iovcnt * size == offset)
+				{
+					last.iovcnt++;
+					continue;
+				}
+			}
+
+			IoRing::Request request;
+			request.desc = pageFile->fil_desc;
+			request.write = write;
+			request.offset = offset;
+			request.iov = &iov[n];
+			request.iovcnt = 1;
+			request.result = 0;
+
+			requests.add(request);
+			firstPages.add(n);
+		}
+
+		{	// scope
+			RuntimeStatistics::WaitTimer timer(tdbb,
+				write ? RuntimeStatistics::WRITE_WAITS : RuntimeStatistics::READ_WAITS,
+				requests.getCount());
+			EngineCheckout cout(tdbb, FB_FUNCTION, true);
+
+			if (ring && requests.getCount() > 1)
+			{
+				ring->execute(requests.begin(), requests.getCount());
+
+				if (ring->isBroken() && !(file->fil_flags & FIL_no_ring))
+				{
+					MutexLockGuard guard(file->fil_mutex, FB_FUNCTION);
+
+					if (!(file->fil_flags & FIL_no_ring))
+					{
+						file->fil_flags |= FIL_no_ring;
+						gds__log("Database %s: io_uring failed, using synchronous I/O",
+							file->fil_string);
+					}
+				}
+			}
+#if defined(HAVE_PREADV) && defined(HAVE_PWRITEV)
+			else
+			{
+				for (IoRing::Request* request = requests.begin(); request < requests.end(); request++)
+				{
+					do
+					{
+						request->result = write ?
+							os_utils::pwritev(request->desc, request->iov, request->iovcnt,
+								LSEEK_OFFSET_CAST request->offset) :
+							os_utils::preadv(request->desc, request->iov, request->iovcnt,
+								LSEEK_OFFSET_CAST request->offset);
+					} while (request->result < 0 && SYSCALL_INTERRUPTED(errno));
+				}
+			}
+#endif
+		}
+
+		for (FB_SIZE_T i = 0; i < requests.getCount(); i++)
+		{
+			const IoRing::Request& request = requests[i];
+
+			if (request.result == (SINT64) request.iovcnt * size)
+			{
+				for (FB_SIZE_T n = firstPages[i]; n < firstPages[i] + request.iovcnt; n++)
+					pageDone[n] = true;
+			}
+		}
+	}
+
+	for (FB_SIZE_T n = 0; n < count; n++)
+	{
+		if (pageDone[n])
+			continue;
+
+		if (write)
+		{
+			if (!PIO_write(tdbb, file, pages[n].pio_bdb, pages[n].pio_page, status_vector))
+				return false;
+		}
+		else
+		{
+			if (!PIO_read(tdbb, file, pages[n].pio_bdb, pages[n].pio_page, status_vector))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+
 static jrd_file* seek_file(jrd_file* file, BufferDesc* bdb, FB_UINT64* offset,
 	FbStatusVector* status_vector)
 {
@@ -570,6 +570,7 @@ bool PIO_read(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 
 	const DWORD size = dbb->dbb_page_size;
 
+	RuntimeStatistics::WaitTimer timer(tdbb, RuntimeStatistics::READ_WAITS);
 	EngineCheckout cout(tdbb, FB_FUNCTION, true);
 	FileExtendLockGuard extLock(file->fil_ext_lock, false);
 
@@ -591,6 +592,29 @@ bool PIO_read(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+bool PIO_read_pages(thread_db* tdbb, jrd_file* file, PageIo* pages, FB_SIZE_T count,
+	FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ r e a d _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read a batch of pages.
+ *
+ **************************************/
+	for (FB_SIZE_T n = 0; n < count; n++)
+	{
+		if (!PIO_read(tdbb, file, pages[n].pio_bdb, pages[n].pio_page, status_vector))
+			return false;
+	}
+
+	return true;
+}
+
+
 #ifdef SUPERSERVER_V2
 bool PIO_read_ahead(thread_db*	tdbb,
 				   SLONG	start_page,
@@ -744,6 +768,7 @@ bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 
 	const DWORD size = dbb->dbb_page_size;
 
+	RuntimeStatistics::WaitTimer timer(tdbb, RuntimeStatistics::WRITE_WAITS);
 	EngineCheckout cout(tdbb, FB_FUNCTION, true);
 	FileExtendLockGuard extLock(file->fil_ext_lock, false);
 
@@ -765,6 +790,29 @@ bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+bool PIO_write_pages(thread_db* tdbb, jrd_file* file, PageIo* pages, FB_SIZE_T count,
+	FbStatusVector* status_vector)
+{
+/**************************************
+ *
+ *	P I O _ w r i t e _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write a batch of pages.
+ *
+ **************************************/
+	for (FB_SIZE_T n = 0; n < count; n++)
+	{
+		if (!PIO_write(tdbb, file, pages[n].pio_bdb, pages[n].pio_page, status_vector))
+			return false;
+	}
+
+	return true;
+}
+
+
 ULONG PIO_get_number_of_pages(const jrd_file* file, const USHORT pagesize)
 {
 /**************************************
@@ -2654,6 +2654,9 @@ void PAG_set_page_scn(thread_db* tdbb, win* window)
 
 	const ULONG scn_page = pageSpace->getSCNPageNum(scn_seq);
 
+	// The map of changed pages must know about the change before the page is written
+	dbb->dbb_backup_manager->markChanged(scn_seq, curr_scn);
+
 	if (scn_page == page_num)
 	{
 		scns_page* page = (scns_page*) window->win_buffer;
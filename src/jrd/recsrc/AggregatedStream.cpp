@@ -52,7 +52,7 @@ BaseAggWinStream<ThisType, NextType>::BaseAggWinStream(thread_db* tdbb, Compiler
 }
 
 template <typename ThisType, typename NextType>
-void BaseAggWinStream<ThisType, NextType>::open(thread_db* tdbb) const
+void BaseAggWinStream<ThisType, NextType>::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = getImpure(request);
@@ -375,7 +375,7 @@ void AggregatedStream::print(thread_db* tdbb, string& plan, bool detailed, unsig
 	m_next->print(tdbb, plan, detailed, level);
 }
 
-bool AggregatedStream::getRecord(thread_db* tdbb) const
+bool AggregatedStream::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
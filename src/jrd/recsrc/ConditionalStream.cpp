@@ -48,7 +48,7 @@ ConditionalStream::ConditionalStream(CompilerScratch* csb,
 	m_impure = csb->allocImpure<Impure>();
 }
 
-void ConditionalStream::open(thread_db* tdbb) const
+void ConditionalStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -75,7 +75,7 @@ void ConditionalStream::close(thread_db* tdbb) const
 	}
 }
 
-bool ConditionalStream::getRecord(thread_db* tdbb) const
+bool ConditionalStream::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
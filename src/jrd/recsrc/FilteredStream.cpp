@@ -44,7 +44,7 @@ FilteredStream::FilteredStream(CompilerScratch* csb, RecordSource* next, BoolExp
 	m_impure = csb->allocImpure<Impure>();
 }
 
-void FilteredStream::open(thread_db* tdbb) const
+void FilteredStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -70,7 +70,7 @@ void FilteredStream::close(thread_db* tdbb) const
 	}
 }
 
-bool FilteredStream::getRecord(thread_db* tdbb) const
+bool FilteredStream::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
@@ -44,7 +44,7 @@ FirstRowsStream::FirstRowsStream(CompilerScratch* csb, RecordSource* next, Value
 	m_impure = csb->allocImpure<Impure>();
 }
 
-void FirstRowsStream::open(thread_db* tdbb) const
+void FirstRowsStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -81,7 +81,7 @@ void FirstRowsStream::close(thread_db* tdbb) const
 	}
 }
 
-bool FirstRowsStream::getRecord(thread_db* tdbb) const
+bool FirstRowsStream::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
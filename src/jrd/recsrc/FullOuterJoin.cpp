@@ -45,7 +45,7 @@ FullOuterJoin::FullOuterJoin(CompilerScratch* csb, RecordSource* arg1, RecordSou
 	m_impure = csb->allocImpure<Impure>();
 }
 
-void FullOuterJoin::open(thread_db* tdbb) const
+void FullOuterJoin::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -74,7 +74,7 @@ void FullOuterJoin::close(thread_db* tdbb) const
 	}
 }
 
-bool FullOuterJoin::getRecord(thread_db* tdbb) const
+bool FullOuterJoin::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
@@ -40,96 +40,278 @@ using namespace Jrd;
 // Data access: hash join
 // ----------------------
 
-// NS: FIXME - Why use static hash table here??? Hash table shall support dynamic resizing
-static const ULONG HASH_SIZE = 1009;
-static const ULONG BUCKET_PREALLOCATE_SIZE = 32;	// 256 bytes per slot
-
-class HashJoin::HashTable : public PermanentStorage
+// The hash table uses open addressing with linear probing. Every slot stores
+// a distinct hash value together with the first and the last links having
+// this hash value, links to the record positions are chained through
+// a separate array. The table is initially sized from the optimizer's
+// cardinality estimate, capped to a modest number of slots as the estimate
+// may be far off, and doubles its size whenever the load factor exceeds 50%.
+//
+// If the inner streams are too large to keep their hash table in memory,
+// the join switches to the partitioned (grace) mode: the leading stream is
+// buffered as well, (hash, position) pairs of all streams are spilled into
+// temporary space split by hash value, and then partitions are joined one by one.
+// Partitions that are still too large are split again using other hash bits.
+
+static const char* const SCRATCH = "fb_hash_";
+
+static const ULONG HASH_MIN_SIZE = 256;					// initial slots if no estimate
+static const ULONG HASH_MAX_PRESIZE = 64 * 1024;		// initial slots for larger estimates
+static const ULONG HASH_MAX_SIZE = 1U << 31;
+
+static const ULONG HASH_ENTRY_COST = 32;				// approx. bytes of memory per entry
+static const FB_UINT64 HASH_MIN_MEMORY_ENTRIES = 64 * 1024;
+
+static const ULONG PARTITION_BITS = 5;
+static const ULONG PARTITION_COUNT = 1 << PARTITION_BITS;
+static const ULONG PARTITION_MAX_LEVEL = 32 / PARTITION_BITS - 1;
+static const ULONG PARTITION_BATCH_SIZE = 256;			// entries per I/O call
+
+namespace
 {
-	class CollisionList
+	inline ULONG spreadHash(ULONG hash)
+	{
+		// Fibonacci hashing, to distribute the bits of a weak hash function
+		// over both the lower bits (hash table slot) and the higher bits (partition)
+		return hash * 0x9E3779B1;
+	}
+
+	inline ULONG getPartition(ULONG hash, ULONG level)
 	{
-		static const FB_SIZE_T INVALID_ITERATOR = FB_SIZE_T(~0);
+		return (spreadHash(hash) >> (32 - PARTITION_BITS * (level + 1))) & (PARTITION_COUNT - 1);
+	}
 
-		struct Entry
+	struct HashEntry
+	{
+		ULONG hash;
+		ULONG position;
+	};
+
+	// Sequence of hash entries spilled to temporary space
+
+	class EntryFile
+	{
+	public:
+		explicit EntryFile(MemoryPool& pool)
+			: m_space(pool, SCRATCH), m_count(0), m_cursor(0), m_bufferPos(0), m_reading(false)
+		{}
+
+		FB_UINT64 getCount() const
 		{
-			Entry()
-				: hash(0), position(0)
-			{}
+			return m_reading ? m_count : m_count + m_buffer.getCount();
+		}
+
+		void put(ULONG hash, ULONG position)
+		{
+			fb_assert(!m_reading);
+
+			if (m_buffer.getCount() == PARTITION_BATCH_SIZE)
+				flush();
+
+			const HashEntry entry = {hash, position};
+			m_buffer.add(entry);
+		}
+
+		void rewind()
+		{
+			if (!m_reading)
+			{
+				flush();
+				m_reading = true;
+			}
+
+			m_buffer.clear();
+			m_cursor = 0;
+			m_bufferPos = 0;
+		}
+
+		bool get(HashEntry& entry)
+		{
+			fb_assert(m_reading);
+
+			if (m_bufferPos >= m_buffer.getCount())
+			{
+				if (m_cursor >= m_count)
+					return false;
+
+				const ULONG count = (ULONG) MIN(m_count - m_cursor, PARTITION_BATCH_SIZE);
+				HashEntry* const ptr = m_buffer.getBuffer(count);
+				m_space.read(m_cursor * sizeof(HashEntry), ptr, count * sizeof(HashEntry));
+				m_cursor += count;
+				m_bufferPos = 0;
+			}
+
+			entry = m_buffer[m_bufferPos++];
+			return true;
+		}
 
-			Entry(ULONG h, ULONG pos)
-				: hash(h), position(pos)
-			{}
+	private:
+		void flush()
+		{
+			const FB_SIZE_T count = m_buffer.getCount();
 
-			static const ULONG generate(const Entry& item)
+			if (count)
 			{
-				return item.hash;
+				m_space.write(m_count * sizeof(HashEntry), m_buffer.begin(), count * sizeof(HashEntry));
+				m_count += count;
+				m_buffer.clear();
 			}
+		}
 
+		TempSpace m_space;
+		HalfStaticArray<HashEntry, PARTITION_BATCH_SIZE> m_buffer;
+		FB_UINT64 m_count;
+		FB_UINT64 m_cursor;
+		FB_SIZE_T m_bufferPos;
+		bool m_reading;
+	};
+}
+
+class HashJoin::HashTable : public PermanentStorage
+{
+	static const ULONG INVALID_POSITION = ~0U;
+
+	class CollisionTable
+	{
+		struct Slot
+		{
 			ULONG hash;
+			ULONG first;
+			ULONG last;
+		};
+
+		struct Link
+		{
 			ULONG position;
+			ULONG next;
 		};
 
 	public:
-		CollisionList(MemoryPool& pool)
-			: m_collisions(pool, BUCKET_PREALLOCATE_SIZE),
-			  m_iterator(INVALID_ITERATOR)
+		CollisionTable(MemoryPool& pool, ULONG size)
+			: m_pool(pool), m_slots(NULL), m_mask(0), m_count(0),
+			  m_links(pool), m_cursor(INVALID_POSITION)
 		{
-			m_collisions.setSortMode(FB_ARRAY_SORT_MANUAL);
+			allocate(size);
 		}
 
-		void sort()
+		~CollisionTable()
 		{
-			m_collisions.sort();
+			delete[] m_slots;
 		}
 
 		void add(ULONG hash, ULONG position)
 		{
-			m_collisions.add(Entry(hash, position));
+			// Grow the table keeping the load factor below 50%
+
+			if ((m_count + 1) * 2 > m_mask + 1 && m_mask + 1 < HASH_MAX_SIZE)
+				grow();
+
+			const ULONG link = m_links.getCount();
+			const Link newLink = {position, INVALID_POSITION};
+			m_links.add(newLink);
+
+			Slot* const slot = lookup(hash);
+
+			if (slot->first == INVALID_POSITION)
+			{
+				slot->hash = hash;
+				slot->first = slot->last = link;
+				m_count++;
+			}
+			else
+			{
+				m_links[slot->last].next = link;
+				slot->last = link;
+			}
 		}
 
 		bool locate(ULONG hash)
 		{
-			if (m_collisions.find(hash, m_iterator))
-				return true;
-
-			m_iterator = INVALID_ITERATOR;
-			return false;
+			const Slot* const slot = lookup(hash);
+			m_cursor = slot->first;
+			return (m_cursor != INVALID_POSITION);
 		}
 
-		bool iterate(ULONG hash, ULONG& position)
+		bool iterate(ULONG& position)
 		{
-			if (m_iterator >= m_collisions.getCount())
+			if (m_cursor == INVALID_POSITION)
 				return false;
 
-			const Entry& collision = m_collisions[m_iterator++];
+			const Link& link = m_links[m_cursor];
+			position = link.position;
+			m_cursor = link.next;
+			return true;
+		}
+
+	private:
+		void allocate(ULONG size)
+		{
+			ULONG capacity = HASH_MIN_SIZE;
+
+			while (capacity < size && capacity < HASH_MAX_SIZE)
+				capacity <<= 1;
+
+			m_slots = FB_NEW_POOL(m_pool) Slot[capacity];
+			m_mask = capacity - 1;
 
-			if (hash != collision.hash)
+			for (ULONG i = 0; i < capacity; i++)
+				m_slots[i].first = m_slots[i].last = INVALID_POSITION;
+		}
+
+		Slot* lookup(ULONG hash) const
+		{
+			ULONG index = spreadHash(hash) & m_mask;
+
+			while (true)
 			{
-				m_iterator = INVALID_ITERATOR;
-				return false;
+				Slot* const slot = m_slots + index;
+
+				if (slot->first == INVALID_POSITION || slot->hash == hash)
+					return slot;
+
+				index = (index + 1) & m_mask;
 			}
+		}
 
-			position = collision.position;
-			return true;
+		void grow()
+		{
+			Slot* const oldSlots = m_slots;
+			const ULONG oldCapacity = m_mask + 1;
+
+			allocate(oldCapacity * 2);
+
+			for (ULONG i = 0; i < oldCapacity; i++)
+			{
+				const Slot& oldSlot = oldSlots[i];
+
+				if (oldSlot.first != INVALID_POSITION)
+					*lookup(oldSlot.hash) = oldSlot;
+			}
+
+			delete[] oldSlots;
 		}
 
-	private:
-		SortedArray<Entry, EmptyStorage<Entry>, ULONG, Entry> m_collisions;
-		FB_SIZE_T m_iterator;
+		MemoryPool& m_pool;
+		Slot* m_slots;
+		ULONG m_mask;
+		ULONG m_count;
+		Array<Link> m_links;
+		ULONG m_cursor;
 	};
 
 public:
-	HashTable(MemoryPool& pool, ULONG streamCount, ULONG tableSize = HASH_SIZE)
-		: PermanentStorage(pool), m_streamCount(streamCount),
-		  m_tableSize(tableSize), m_slot(0)
+	HashTable(MemoryPool& pool, ULONG streamCount, const ULONG* tableSizes)
+		: PermanentStorage(pool), m_streamCount(streamCount), m_hash(0)
 	{
-		m_collisions = FB_NEW_POOL(pool) CollisionList*[streamCount * tableSize];
-		memset(m_collisions, 0, streamCount * tableSize * sizeof(CollisionList*));
+		m_collisions = FB_NEW_POOL(pool) CollisionTable*[streamCount];
+
+		for (ULONG i = 0; i < streamCount; i++)
+			m_collisions[i] = FB_NEW_POOL(pool) CollisionTable(pool, tableSizes[i]);
 	}
 
 	~HashTable()
 	{
-		for (ULONG i = 0; i < m_streamCount * m_tableSize; i++)
+		for (ULONG i = 0; i < m_streamCount; i++)
 			delete m_collisions[i];
 
 		delete[] m_collisions;
@@ -137,78 +319,206 @@ public:
 
 	void put(ULONG stream, ULONG hash, ULONG position)
 	{
-		const ULONG slot = hash % m_tableSize;
-
 		fb_assert(stream < m_streamCount);
-		fb_assert(slot < m_tableSize);
-
-		CollisionList* collisions = m_collisions[stream * m_tableSize + slot];
-
-		if (!collisions)
-		{
-			collisions = FB_NEW_POOL(getPool()) CollisionList(getPool());
-			m_collisions[stream * m_tableSize + slot] = collisions;
-		}
-
-		collisions->add(hash, position);
+		m_collisions[stream]->add(hash, position);
 	}
 
 	bool setup(ULONG hash)
 	{
-		const ULONG slot = hash % m_tableSize;
-
 		for (ULONG i = 0; i < m_streamCount; i++)
 		{
-			CollisionList* const collisions = m_collisions[i * m_tableSize + slot];
-
-			if (!collisions)
-				return false;
-
-			if (!collisions->locate(hash))
+			if (!m_collisions[i]->locate(hash))
 				return false;
 		}
 
-		m_slot = slot;
+		m_hash = hash;
 		return true;
 	}
 
 	void reset(ULONG stream, ULONG hash)
 	{
 		fb_assert(stream < m_streamCount);
+		fb_assert(hash == m_hash);
 
-		CollisionList* const collisions = m_collisions[stream * m_tableSize + m_slot];
-		collisions->locate(hash);
+		m_collisions[stream]->locate(hash);
 	}
 
 	bool iterate(ULONG stream, ULONG hash, ULONG& position)
 	{
 		fb_assert(stream < m_streamCount);
+		fb_assert(hash == m_hash);
+
+		return m_collisions[stream]->iterate(position);
+	}
+
+private:
+	const ULONG m_streamCount;
+	CollisionTable** m_collisions;
+	ULONG m_hash;
+};
+
+
+class HashJoin::PartitionSet : public PermanentStorage
+{
+	class Partition
+	{
+	public:
+		Partition(MemoryPool& pool, ULONG streamCount, ULONG level)
+			: m_leader(pool), m_inner(pool), m_level(level)
+		{
+			for (ULONG i = 0; i < streamCount; i++)
+				m_inner.add(FB_NEW_POOL(pool) EntryFile(pool));
+		}
+
+		~Partition()
+		{
+			for (FB_SIZE_T i = 0; i < m_inner.getCount(); i++)
+				delete m_inner[i];
+		}
+
+		EntryFile m_leader;
+		Array<EntryFile*> m_inner;
+		const ULONG m_level;
+	};
+
+public:
+	PartitionSet(MemoryPool& pool, ULONG streamCount, FB_UINT64 maxEntries)
+		: PermanentStorage(pool), m_streamCount(streamCount), m_maxEntries(maxEntries),
+		  m_pending(pool), m_current(NULL)
+	{
+		for (ULONG i = 0; i < PARTITION_COUNT; i++)
+			m_pending.add(FB_NEW_POOL(pool) Partition(pool, streamCount, 0));
+	}
+
+	~PartitionSet()
+	{
+		delete m_current;
 
-		CollisionList* const collisions = m_collisions[stream * m_tableSize + m_slot];
-		return collisions->iterate(hash, position);
+		for (FB_SIZE_T i = 0; i < m_pending.getCount(); i++)
+			delete m_pending[i];
 	}
 
-	void sort()
+	void putLeader(ULONG hash, ULONG position)
+	{
+		fb_assert(!m_current);
+		m_pending[getPartition(hash, 0)]->m_leader.put(hash, position);
+	}
+
+	void put(ULONG stream, ULONG hash, ULONG position)
+	{
+		fb_assert(!m_current && stream < m_streamCount);
+		m_pending[getPartition(hash, 0)]->m_inner[stream]->put(hash, position);
+	}
+
+	bool getLeader(HashEntry& entry)
+	{
+		return m_current && m_current->m_leader.get(entry);
+	}
+
+	// Release the current partition and build the hash table for the next one.
+	// Returns NULL if there are no more partitions to join.
+
+	HashTable* loadNext()
 	{
-		for (ULONG i = 0; i < m_streamCount * m_tableSize; i++)
+		delete m_current;
+		m_current = NULL;
+
+		while (m_pending.hasData())
 		{
-			CollisionList* const collisions = m_collisions[i];
+			Partition* const partition = m_pending.pop();
+
+			// Inner join: partitions without matches in some stream produce nothing
+
+			bool empty = !partition->m_leader.getCount();
+			FB_UINT64 total = 0;
+
+			for (ULONG i = 0; i < m_streamCount; i++)
+			{
+				const FB_UINT64 count = partition->m_inner[i]->getCount();
+				empty = empty || !count;
+				total += count;
+			}
+
+			if (empty)
+			{
+				delete partition;
+				continue;
+			}
+
+			if (total > m_maxEntries && partition->m_level < PARTITION_MAX_LEVEL)
+			{
+				split(partition);
+				delete partition;
+				continue;
+			}
 
-			if (collisions)
-				collisions->sort();
+			HalfStaticArray<ULONG, OPT_STATIC_ITEMS> tableSizes(getPool(), m_streamCount);
+
+			for (ULONG i = 0; i < m_streamCount; i++)
+				tableSizes.add((ULONG) MIN(partition->m_inner[i]->getCount() * 2, HASH_MAX_SIZE));
+
+			AutoPtr<HashTable> hashTable(FB_NEW_POOL(getPool())
+				HashTable(getPool(), m_streamCount, tableSizes.begin()));
+
+			HashEntry entry;
+
+			for (ULONG i = 0; i < m_streamCount; i++)
+			{
+				EntryFile* const file = partition->m_inner[i];
+				file->rewind();
+
+				while (file->get(entry))
+					hashTable->put(i, entry.hash, entry.position);
+			}
+
+			partition->m_leader.rewind();
+			m_current = partition;
+
+			return hashTable.release();
 		}
+
+		return NULL;
 	}
 
 private:
+	void split(Partition* partition)
+	{
+		const ULONG level = partition->m_level + 1;
+		Partition* children[PARTITION_COUNT];
+
+		for (ULONG i = 0; i < PARTITION_COUNT; i++)
+		{
+			children[i] = FB_NEW_POOL(getPool()) Partition(getPool(), m_streamCount, level);
+			m_pending.add(children[i]);
+		}
+
+		HashEntry entry;
+
+		partition->m_leader.rewind();
+
+		while (partition->m_leader.get(entry))
+			children[getPartition(entry.hash, level)]->m_leader.put(entry.hash, entry.position);
+
+		for (ULONG i = 0; i < m_streamCount; i++)
+		{
+			EntryFile* const file = partition->m_inner[i];
+			file->rewind();
+
+			while (file->get(entry))
+				children[getPartition(entry.hash, level)]->m_inner[i]->put(entry.hash, entry.position);
+		}
+	}
+
 	const ULONG m_streamCount;
-	const ULONG m_tableSize;
-	CollisionList** m_collisions;
-	ULONG m_slot;
+	const FB_UINT64 m_maxEntries;
+	Array<Partition*> m_pending;
+	Partition* m_current;
 };
 
 
 HashJoin::HashJoin(thread_db* tdbb, CompilerScratch* csb, FB_SIZE_T count,
-				   RecordSource* const* args, NestValueArray* const* keys)
+				   RecordSource* const* args, NestValueArray* const* keys,
+				   const double* cardinalities)
 	: m_args(csb->csb_pool, count - 1)
 {
 	fb_assert(count >= 2);
@@ -251,6 +561,7 @@ HashJoin::HashJoin(thread_db* tdbb, CompilerScratch* csb, FB_SIZE_T count,
 		SubStream sub;
 		sub.buffer = FB_NEW_POOL(csb->csb_pool) BufferedStream(csb, sub_rsb);
 		sub.keys = keys[i];
+		sub.cardinality = (ULONG) MIN(cardinalities[i], (double) (HASH_MAX_PRESIZE / 2));
 		const FB_SIZE_T subKeyCount = sub.keys->getCount();
 		sub.keyLengths = FB_NEW_POOL(csb->csb_pool) ULONG[subKeyCount];
 		sub.totalKeyLength = 0;
@@ -279,9 +590,11 @@ HashJoin::HashJoin(thread_db* tdbb, CompilerScratch* csb, FB_SIZE_T count,
 
 		m_args.add(sub);
 	}
+
+	m_leaderBuffer = FB_NEW_POOL(csb->csb_pool) BufferedStream(csb, m_leader.source);
 }
 
-void HashJoin::open(thread_db* tdbb) const
+void HashJoin::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -289,21 +602,35 @@ void HashJoin::open(thread_db* tdbb) const
 	impure->irsb_flags = irsb_open | irsb_mustread;
 
 	delete impure->irsb_hash_table;
+	delete impure->irsb_partitions;
 	delete[] impure->irsb_leader_buffer;
 
+	impure->irsb_partitions = NULL;
+
 	MemoryPool& pool = *tdbb->getDefaultPool();
 
 	const FB_SIZE_T argCount = m_args.getCount();
 
-	impure->irsb_hash_table = FB_NEW_POOL(pool) HashTable(pool, argCount);
+	HalfStaticArray<ULONG, OPT_STATIC_ITEMS> tableSizes(pool, argCount);
+
+	for (FB_SIZE_T i = 0; i < argCount; i++)
+		tableSizes.add(m_args[i].cardinality * 2);
+
+	impure->irsb_hash_table = FB_NEW_POOL(pool) HashTable(pool, argCount, tableSizes.begin());
 	impure->irsb_leader_buffer = FB_NEW_POOL(pool) UCHAR[m_leader.totalKeyLength];
 
+	const FB_UINT64 maxEntries =
+		MAX(tdbb->getDatabase()->dbb_config->getTempCacheLimit() / HASH_ENTRY_COST,
+			HASH_MIN_MEMORY_ENTRIES);
+	FB_UINT64 totalEntries = 0;
+
 	UCharBuffer buffer(pool);
 
 	for (FB_SIZE_T i = 0; i < argCount; i++)
 	{
 		// Read and cache the inner streams. While doing that,
 		// hash the join condition values and populate hash tables.
+		// If the hash tables grow too large, just cache the records.
 
 		m_args[i].buffer->open(tdbb);
 
@@ -312,14 +639,56 @@ void HashJoin::open(thread_db* tdbb) const
 
 		while (m_args[i].buffer->getRecord(tdbb))
 		{
+			if (!impure->irsb_hash_table)
+				continue;
+
 			const ULONG hash = computeHash(tdbb, request, m_args[i], keyBuffer);
 			impure->irsb_hash_table->put(i, hash, counter++);
+
+			if (++totalEntries > maxEntries)
+			{
+				delete impure->irsb_hash_table;
+				impure->irsb_hash_table = NULL;
+			}
 		}
 	}
 
-	impure->irsb_hash_table->sort();
+	if (impure->irsb_hash_table)
+	{
+		m_leader.source->open(tdbb);
+		return;
+	}
+
+	// Switch to the partitioned mode. Re-read the cached inner streams
+	// and the leading stream, spilling their hashes into partitions.
+
+	impure->irsb_partitions = FB_NEW_POOL(pool) PartitionSet(pool, argCount, maxEntries);
+
+	for (FB_SIZE_T i = 0; i < argCount; i++)
+	{
+		ULONG counter = 0;
+		UCHAR* const keyBuffer = buffer.getBuffer(m_args[i].totalKeyLength, false);
 
-	m_leader.source->open(tdbb);
+		m_args[i].buffer->locate(tdbb, 0);
+
+		while (m_args[i].buffer->getRecord(tdbb))
+		{
+			const ULONG hash = computeHash(tdbb, request, m_args[i], keyBuffer);
+			impure->irsb_partitions->put(i, hash, counter++);
+		}
+	}
+
+	m_leaderBuffer->open(tdbb);
+
+	ULONG counter = 0;
+
+	while (m_leaderBuffer->getRecord(tdbb))
+	{
+		const ULONG hash = computeHash(tdbb, request, m_leader, impure->irsb_leader_buffer);
+		impure->irsb_partitions->putLeader(hash, counter++);
+	}
+
+	impure->irsb_hash_table = impure->irsb_partitions->loadNext();
 }
 
 void HashJoin::close(thread_db* tdbb) const
@@ -342,11 +711,19 @@ void HashJoin::close(thread_db* tdbb) const
 		for (FB_SIZE_T i = 0; i < m_args.getCount(); i++)
 			m_args[i].buffer->close(tdbb);
 
-		m_leader.source->close(tdbb);
+		if (impure->irsb_partitions)
+		{
+			m_leaderBuffer->close(tdbb);
+
+			delete impure->irsb_partitions;
+			impure->irsb_partitions = NULL;
+		}
+		else
+			m_leader.source->close(tdbb);
 	}
 }
 
-bool HashJoin::getRecord(thread_db* tdbb) const
+bool HashJoin::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
@@ -360,21 +737,32 @@ bool HashJoin::getRecord(thread_db* tdbb) const
 	{
 		if (impure->irsb_flags & irsb_mustread)
 		{
-			// Fetch the record from the leading stream
+			if (impure->irsb_partitions)
+			{
+				// Fetch the next matching record of the leading stream
+				// from the current (or some following) partition
 
-			if (!m_leader.source->getRecord(tdbb))
-				return false;
+				if (!fetchLeader(tdbb, impure))
+					return false;
+			}
+			else
+			{
+				// Fetch the record from the leading stream
 
-			// Compute and hash the comparison keys
+				if (!m_leader.source->getRecord(tdbb))
+					return false;
 
-			impure->irsb_leader_hash =
-				computeHash(tdbb, request, m_leader, impure->irsb_leader_buffer);
+				// Compute and hash the comparison keys
 
-			// Ensure the every inner stream having matches for this hash slot.
-			// Setup the hash table for the iteration through collisions.
+				impure->irsb_leader_hash =
+					computeHash(tdbb, request, m_leader, impure->irsb_leader_buffer);
 
-			if (!impure->irsb_hash_table->setup(impure->irsb_leader_hash))
-				continue;
+				// Ensure the every inner stream having matches for this hash slot.
+				// Setup the hash table for the iteration through collisions.
+
+				if (!impure->irsb_hash_table->setup(impure->irsb_leader_hash))
+					continue;
+			}
 
 			impure->irsb_flags &= ~irsb_mustread;
 			impure->irsb_flags |= irsb_first;
@@ -565,6 +953,39 @@ ULONG HashJoin::computeHash(thread_db* tdbb,
 	return InternalHash::hash(sub.totalKeyLength, keyBuffer);
 }
 
+bool HashJoin::fetchLeader(thread_db* tdbb, Impure* impure) const
+{
+	PartitionSet* const partitions = impure->irsb_partitions;
+	HashEntry entry;
+
+	while (impure->irsb_hash_table)
+	{
+		while (partitions->getLeader(entry))
+		{
+			// Check for matches before fetching the buffered leader record
+
+			if (impure->irsb_hash_table->setup(entry.hash))
+			{
+				m_leaderBuffer->locate(tdbb, entry.position);
+
+				if (!m_leaderBuffer->getRecord(tdbb))
+				{
+					fb_assert(false);
+					return false;
+				}
+
+				impure->irsb_leader_hash = entry.hash;
+				return true;
+			}
+		}
+
+		delete impure->irsb_hash_table;
+		impure->irsb_hash_table = partitions->loadNext();
+	}
+
+	return false;
+}
+
 bool HashJoin::fetchRecord(thread_db* tdbb, Impure* impure, FB_SIZE_T stream) const
 {
 	HashTable* const hashTable = impure->irsb_hash_table;
@@ -30,6 +30,7 @@
 #include "../jrd/met_proto.h"
 #include "../jrd/vio_proto.h"
 #include "../jrd/rlck_proto.h"
+#include "../jrd/DeferredIndexKeys.h"
 
 #include "RecordSource.h"
 
@@ -60,7 +61,7 @@ IndexTableScan::IndexTableScan(CompilerScratch* csb, const string& alias,
 	m_impure = csb->allocImpure(FB_ALIGNMENT, static_cast<ULONG>(size));
 }
 
-void IndexTableScan::open(thread_db* tdbb) const
+void IndexTableScan::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -70,6 +71,9 @@ void IndexTableScan::open(thread_db* tdbb) const
 	record_param* const rpb = &request->req_rpb[m_stream];
 	RLCK_reserve_relation(tdbb, request->req_transaction, m_relation, false);
 
+	// Let the transaction see the keys of its bulk modifications
+	DeferredIndexKeys::flushRelation(tdbb, m_relation);
+
 	rpb->rpb_number.setValue(BOF_NUMBER);
 }
 
@@ -123,7 +127,7 @@ void IndexTableScan::close(thread_db* tdbb) const
 #endif
 }
 
-bool IndexTableScan::getRecord(thread_db* tdbb) const
+bool IndexTableScan::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
@@ -56,7 +56,7 @@ MergeJoin::MergeJoin(CompilerScratch* csb, FB_SIZE_T count,
 	}
 }
 
-void MergeJoin::open(thread_db* tdbb) const
+void MergeJoin::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -125,7 +125,7 @@ void MergeJoin::close(thread_db* tdbb) const
 	}
 }
 
-bool MergeJoin::getRecord(thread_db* tdbb) const
+bool MergeJoin::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
@@ -57,7 +57,7 @@ NestedLoopJoin::NestedLoopJoin(CompilerScratch* csb, RecordSource* outer, Record
 	m_args.add(inner);
 }
 
-void NestedLoopJoin::open(thread_db* tdbb) const
+void NestedLoopJoin::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -82,7 +82,7 @@ void NestedLoopJoin::close(thread_db* tdbb) const
 	}
 }
 
-bool NestedLoopJoin::getRecord(thread_db* tdbb) const
+bool NestedLoopJoin::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
@@ -53,7 +53,7 @@ ProcedureScan::ProcedureScan(CompilerScratch* csb, const string& alias, StreamTy
 		fb_assert(sourceList->items.getCount() == targetList->items.getCount());
 }
 
-void ProcedureScan::open(thread_db* tdbb) const
+void ProcedureScan::internalOpen(thread_db* tdbb) const
 {
 	if (!m_procedure->isImplemented())
 	{
@@ -159,7 +159,7 @@ void ProcedureScan::close(thread_db* tdbb) const
 	}
 }
 
-bool ProcedureScan::getRecord(thread_db* tdbb) const
+bool ProcedureScan::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
@@ -34,6 +34,8 @@
 #include "../jrd/rlck_proto.h"
 #include "../jrd/vio_proto.h"
 #include "../jrd/DataTypeUtil.h"
+#include "../jrd/Profiler.h"
+#include "../common/utils_proto.h"
 
 #include "RecordSource.h"
 
@@ -44,6 +46,41 @@ using namespace Jrd;
 // Record source class
 // -------------------
 
+void RecordSource::open(thread_db* tdbb) const
+{
+	Attachment* const attachment = tdbb->getAttachment();
+
+	if (!(attachment->att_flags & ATT_profiling))
+	{
+		internalOpen(tdbb);
+		return;
+	}
+
+	const SINT64 start = fb_utils::query_performance_counter();
+
+	internalOpen(tdbb);
+
+	attachment->att_profiler->recordSourceOpen(tdbb, this,
+		fb_utils::query_performance_counter() - start);
+}
+
+bool RecordSource::getRecord(thread_db* tdbb) const
+{
+	Attachment* const attachment = tdbb->getAttachment();
+
+	if (!(attachment->att_flags & ATT_profiling))
+		return internalGetRecord(tdbb);
+
+	const SINT64 start = fb_utils::query_performance_counter();
+
+	const bool result = internalGetRecord(tdbb);
+
+	attachment->att_profiler->recordSourceFetch(tdbb, this,
+		fb_utils::query_performance_counter() - start);
+
+	return result;
+}
+
 string RecordSource::printName(thread_db* tdbb, const string& name, bool quote)
 {
 	const UCHAR* namePtr = (const UCHAR*) name.c_str();
@@ -57,10 +57,12 @@ namespace Jrd
 	class RecordSource
 	{
 	public:
-		virtual void open(thread_db* tdbb) const = 0;
+		// These account the time spent by the record source if the profiler is active
+		void open(thread_db* tdbb) const;
+		bool getRecord(thread_db* tdbb) const;
+
 		virtual void close(thread_db* tdbb) const = 0;
 
-		virtual bool getRecord(thread_db* tdbb) const = 0;
 		virtual bool refetchRecord(thread_db* tdbb) const = 0;
 		virtual bool lockRecord(thread_db* tdbb) const = 0;
 
@@ -86,6 +88,9 @@ namespace Jrd
 		}
 
 	protected:
+		virtual void internalOpen(thread_db* tdbb) const = 0;
+		virtual bool internalGetRecord(thread_db* tdbb) const = 0;
+
 		// Generic impure block
 		struct Impure
 		{
@@ -156,10 +161,10 @@ namespace Jrd
 					  StreamType stream, jrd_rel* relation,
 					  const Firebird::Array<DbKeyRangeNode*>& dbkeyRanges);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 
 		void print(thread_db* tdbb, Firebird::string& plan,
 				   bool detailed, unsigned level) const override;
@@ -181,10 +186,10 @@ namespace Jrd
 		BitmapTableScan(CompilerScratch* csb, const Firebird::string& alias,
 						StreamType stream, jrd_rel* relation, InversionNode* inversion);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 
 		void print(thread_db* tdbb, Firebird::string& plan,
 				   bool detailed, unsigned level) const override;
@@ -216,10 +221,10 @@ namespace Jrd
 					   StreamType stream, jrd_rel* relation,
 					   InversionNode* index, USHORT keyLength);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 
 		void print(thread_db* tdbb, Firebird::string& plan,
 				   bool detailed, unsigned level) const override;
@@ -261,10 +266,10 @@ namespace Jrd
 		ExternalTableScan(CompilerScratch* csb, const Firebird::string& alias,
 						  StreamType stream, jrd_rel* relation);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -282,10 +287,10 @@ namespace Jrd
 		VirtualTableScan(CompilerScratch* csb, const Firebird::string& alias,
 						 StreamType stream, jrd_rel* relation);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -315,10 +320,10 @@ namespace Jrd
 					  const jrd_prc* procedure, const ValueListNode* sourceList,
 					  const ValueListNode* targetList, MessageNode* message);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -344,10 +349,10 @@ namespace Jrd
 	public:
 		SingularStream(CompilerScratch* csb, RecordSource* next);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -372,10 +377,10 @@ namespace Jrd
 	public:
 		LockedStream(CompilerScratch* csb, RecordSource* next);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -402,10 +407,10 @@ namespace Jrd
 	public:
 		FirstRowsStream(CompilerScratch* csb, RecordSource* next, ValueExprNode* value);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -438,10 +443,10 @@ namespace Jrd
 	public:
 		SkipRowsStream(CompilerScratch* csb, RecordSource* next, ValueExprNode* value);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -469,10 +474,10 @@ namespace Jrd
 	public:
 		FilteredStream(CompilerScratch* csb, RecordSource* next, BoolExprNode* boolean);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -564,10 +569,10 @@ namespace Jrd
 
 		SortedStream(CompilerScratch* csb, RecordSource* next, SortMap* map);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -707,7 +712,7 @@ namespace Jrd
 			const NestValueArray* group, MapNode* groupMap, bool oneRowWhenEmpty, NextType* next);
 
 	public:
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
 		bool refetchRecord(thread_db* tdbb) const override;
@@ -784,7 +789,7 @@ namespace Jrd
 
 	public:
 		void print(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
-		bool getRecord(thread_db* tdbb) const;
+		bool internalGetRecord(thread_db* tdbb) const;
 	};
 
 	class WindowedStream : public RecordSource
@@ -843,10 +848,10 @@ namespace Jrd
 				WindowClause::Exclusion exclusion);
 
 		public:
-			void open(thread_db* tdbb) const;
+			void internalOpen(thread_db* tdbb) const;
 			void close(thread_db* tdbb) const;
 
-			bool getRecord(thread_db* tdbb) const;
+			bool internalGetRecord(thread_db* tdbb) const;
 
 			void print(thread_db* tdbb, Firebird::string& plan, bool detailed, unsigned level) const;
 			void findUsedStreams(StreamList& streams, bool expandAll = false) const;
@@ -880,10 +885,10 @@ namespace Jrd
 		WindowedStream(thread_db* tdbb, CompilerScratch* csb,
 			Firebird::ObjectsArray<WindowSourceNode::Window>& windows, RecordSource* next);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -940,10 +945,10 @@ namespace Jrd
 	public:
 		BufferedStream(CompilerScratch* csb, RecordSource* next);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -980,10 +985,10 @@ namespace Jrd
 		NestedLoopJoin(CompilerScratch* csb, RecordSource* outer, RecordSource* inner,
 					   BoolExprNode* boolean, JoinType joinType);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -1009,10 +1014,10 @@ namespace Jrd
 	public:
 		FullOuterJoin(CompilerScratch* csb, RecordSource* arg1, RecordSource* arg2);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -1033,6 +1038,7 @@ namespace Jrd
 	class HashJoin : public RecordSource
 	{
 		class HashTable;
+		class PartitionSet;
 
 		struct SubStream
 		{
@@ -1045,23 +1051,26 @@ namespace Jrd
 			NestValueArray* keys;
 			ULONG* keyLengths;
 			ULONG totalKeyLength;
+			ULONG cardinality;
 		};
 
 		struct Impure : public RecordSource::Impure
 		{
 			HashTable* irsb_hash_table;
+			PartitionSet* irsb_partitions;
 			UCHAR* irsb_leader_buffer;
 			ULONG irsb_leader_hash;
 		};
 
 	public:
 		HashJoin(thread_db* tdbb, CompilerScratch* csb, FB_SIZE_T count,
-				 RecordSource* const* args, NestValueArray* const* keys);
+				 RecordSource* const* args, NestValueArray* const* keys,
+				 const double* cardinalities);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -1077,9 +1086,11 @@ namespace Jrd
 	private:
 		ULONG computeHash(thread_db* tdbb, jrd_req* request,
 						  const SubStream& sub, UCHAR* buffer) const;
+		bool fetchLeader(thread_db* tdbb, Impure* impure) const;
 		bool fetchRecord(thread_db* tdbb, Impure* impure, FB_SIZE_T stream) const;
 
 		SubStream m_leader;
+		BufferedStream* m_leaderBuffer;
 		Firebird::Array<SubStream> m_args;
 	};
 
@@ -1118,10 +1129,10 @@ namespace Jrd
 				  SortedStream* const* args,
 				  const NestValueArray* const* keys);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -1157,10 +1168,10 @@ namespace Jrd
 			  FB_SIZE_T argCount, RecordSource* const* args, NestConst<MapNode>* maps,
 			  FB_SIZE_T streamCount, const StreamType* streams);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -1198,10 +1209,10 @@ namespace Jrd
 					    FB_SIZE_T streamCount, const StreamType* innerStreams,
 					    ULONG saveOffset);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
@@ -1236,10 +1247,10 @@ namespace Jrd
 		ConditionalStream(CompilerScratch* csb, RecordSource* first, RecordSource* second,
 						  BoolExprNode* boolean);
 
-		void open(thread_db* tdbb) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		void close(thread_db* tdbb) const override;
 
-		bool getRecord(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
 		bool refetchRecord(thread_db* tdbb) const override;
 		bool lockRecord(thread_db* tdbb) const override;
 
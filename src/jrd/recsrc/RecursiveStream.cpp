@@ -66,7 +66,7 @@ RecursiveStream::RecursiveStream(CompilerScratch* csb, StreamType stream, Stream
 	m_inner->markRecursive();
 }
 
-void RecursiveStream::open(thread_db* tdbb) const
+void RecursiveStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -115,7 +115,7 @@ void RecursiveStream::close(thread_db* tdbb) const
 	}
 }
 
-bool RecursiveStream::getRecord(thread_db* tdbb) const
+bool RecursiveStream::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
@@ -42,7 +42,7 @@ SingularStream::SingularStream(CompilerScratch* csb, RecordSource* next)
 	m_impure = csb->allocImpure<Impure>();
 }
 
-void SingularStream::open(thread_db* tdbb) const
+void SingularStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -68,7 +68,7 @@ void SingularStream::close(thread_db* tdbb) const
 	}
 }
 
-bool SingularStream::getRecord(thread_db* tdbb) const
+bool SingularStream::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
@@ -50,7 +50,7 @@ SortedStream::SortedStream(CompilerScratch* csb, RecordSource* next, SortMap* ma
 	m_impure = csb->allocImpure<Impure>();
 }
 
-void SortedStream::open(thread_db* tdbb) const
+void SortedStream::internalOpen(thread_db* tdbb) const
 {
 	jrd_req* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
@@ -84,7 +84,7 @@ void SortedStream::close(thread_db* tdbb) const
 	}
 }
 
-bool SortedStream::getRecord(thread_db* tdbb) const
+bool SortedStream::internalGetRecord(thread_db* tdbb) const
 {
 	JRD_reschedule(tdbb);
 
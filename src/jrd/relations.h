@@ -741,3 +741,50 @@ RELATION(nam_keywords, rel_keywords, ODS_13_1, rel_virtual)
 	FIELD(f_keyword_name, nam_keyword_name, fld_keyword_name, 0, ODS_13_1)
 	FIELD(f_keyword_reserved, nam_keyword_reserved, fld_keyword_reserved, 0, ODS_13_1)
 END_RELATION
+
+// Relation 55 (MON$WAIT_STATS)
+RELATION(nam_mon_wait_stats, rel_mon_wait_stats, ODS_13_2, rel_virtual)
+	FIELD(f_mon_wait_stat_id, nam_mon_stat_id, fld_stat_id, 0, ODS_13_2)
+	FIELD(f_mon_wait_stat_group, nam_mon_stat_group, fld_stat_group, 0, ODS_13_2)
+	FIELD(f_mon_wait_latch_waits, nam_mon_latch_waits, fld_counter, 0, ODS_13_2)
+	FIELD(f_mon_wait_latch_time, nam_mon_latch_wait_time, fld_counter, 0, ODS_13_2)
+	FIELD(f_mon_wait_lock_waits, nam_mon_lock_waits, fld_counter, 0, ODS_13_2)
+	FIELD(f_mon_wait_lock_time, nam_mon_lock_wait_time, fld_counter, 0, ODS_13_2)
+	FIELD(f_mon_wait_read_waits, nam_mon_read_waits, fld_counter, 0, ODS_13_2)
+	FIELD(f_mon_wait_read_time, nam_mon_read_wait_time, fld_counter, 0, ODS_13_2)
+	FIELD(f_mon_wait_write_waits, nam_mon_write_waits, fld_counter, 0, ODS_13_2)
+	FIELD(f_mon_wait_write_time, nam_mon_write_wait_time, fld_counter, 0, ODS_13_2)
+END_RELATION
+
+// Relation 56 (RDB$PROFILE_STATEMENTS)
+RELATION(nam_prof_statements, rel_prof_statements, ODS_13_2, rel_virtual)
+	FIELD(f_prof_stmt_session_id, nam_prof_session_id, fld_gen_val, 0, ODS_13_2)
+	FIELD(f_prof_stmt_id, nam_prof_stmt_id, fld_stmt_id, 0, ODS_13_2)
+	FIELD(f_prof_stmt_parent_id, nam_prof_parent_stmt_id, fld_stmt_id, 0, ODS_13_2)
+	FIELD(f_prof_stmt_obj_type, nam_obj_type, fld_obj_type, 0, ODS_13_2)
+	FIELD(f_prof_stmt_pkg_name, nam_pkg_name, fld_pkg_name, 0, ODS_13_2)
+	FIELD(f_prof_stmt_routine_name, nam_prof_routine_name, fld_prc_name, 0, ODS_13_2)
+	FIELD(f_prof_stmt_sql_text, nam_prof_sql_text, fld_source, 0, ODS_13_2)
+END_RELATION
+
+// Relation 57 (RDB$PROFILE_PSQL_STATS)
+RELATION(nam_prof_psql_stats, rel_prof_psql_stats, ODS_13_2, rel_virtual)
+	FIELD(f_prof_psql_stmt_id, nam_prof_stmt_id, fld_stmt_id, 0, ODS_13_2)
+	FIELD(f_prof_psql_line, nam_prof_line, fld_src_info, 0, ODS_13_2)
+	FIELD(f_prof_psql_column, nam_prof_column, fld_src_info, 0, ODS_13_2)
+	FIELD(f_prof_psql_counter, nam_counter, fld_counter, 0, ODS_13_2)
+	FIELD(f_prof_psql_min_time, nam_prof_min_time, fld_counter, 0, ODS_13_2)
+	FIELD(f_prof_psql_max_time, nam_prof_max_time, fld_counter, 0, ODS_13_2)
+	FIELD(f_prof_psql_total_time, nam_prof_total_time, fld_counter, 0, ODS_13_2)
+END_RELATION
+
+// Relation 58 (RDB$PROFILE_RECORD_SOURCE_STATS)
+RELATION(nam_prof_recsrc_stats, rel_prof_recsrc_stats, ODS_13_2, rel_virtual)
+	FIELD(f_prof_recsrc_stmt_id, nam_prof_stmt_id, fld_stmt_id, 0, ODS_13_2)
+	FIELD(f_prof_recsrc_id, nam_prof_recsrc_id, fld_src_info, 0, ODS_13_2)
+	FIELD(f_prof_recsrc_access_path, nam_prof_access_path, fld_plan, 0, ODS_13_2)
+	FIELD(f_prof_recsrc_open_counter, nam_prof_open_counter, fld_counter, 0, ODS_13_2)
+	FIELD(f_prof_recsrc_open_time, nam_prof_open_time, fld_counter, 0, ODS_13_2)
+	FIELD(f_prof_recsrc_fetch_counter, nam_prof_fetch_counter, fld_counter, 0, ODS_13_2)
+	FIELD(f_prof_recsrc_fetch_time, nam_prof_fetch_time, fld_counter, 0, ODS_13_2)
+END_RELATION
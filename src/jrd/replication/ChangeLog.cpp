@@ -131,11 +131,11 @@ ChangeLog::Segment::~Segment()
 	::close(m_handle);
 }
 
-void ChangeLog::Segment::init(FB_UINT64 sequence, const Guid& guid)
+void ChangeLog::Segment::init(FB_UINT64 sequence, const Guid& guid, USHORT version)
 {
 	fb_assert(sizeof(CHANGELOG_SIGNATURE) == sizeof(m_header->hdr_signature));
 	strcpy(m_header->hdr_signature, CHANGELOG_SIGNATURE);
-	m_header->hdr_version = CHANGELOG_CURRENT_VERSION;
+	m_header->hdr_version = version;
 	m_header->hdr_state = SEGMENT_STATE_USED;
 	memcpy(&m_header->hdr_guid, &guid, sizeof(Guid));
 	m_header->hdr_sequence = sequence;
@@ -149,8 +149,11 @@ bool ChangeLog::Segment::validate(const Guid& guid) const
 	if (strcmp(m_header->hdr_signature, CHANGELOG_SIGNATURE))
 		return false;
 
-	if (m_header->hdr_version != CHANGELOG_CURRENT_VERSION)
+	if (m_header->hdr_version < CHANGELOG_VERSION_1 ||
+		m_header->hdr_version > CHANGELOG_CURRENT_VERSION)
+	{
 		return false;
+	}
 
 	if (m_header->hdr_state != SEGMENT_STATE_FREE &&
 		m_header->hdr_state != SEGMENT_STATE_USED &&
@@ -558,6 +561,16 @@ void ChangeLog::forceSwitch()
 
 FB_UINT64 ChangeLog::write(ULONG length, const UCHAR* data, bool sync)
 {
+	// Compress outside the lock, concurrent writers do it in parallel
+
+	UCharBuffer compressed;
+
+	if (m_config->journalCompression && compressBlock(length, data, compressed))
+	{
+		length = (ULONG) compressed.getCount();
+		data = compressed.begin();
+	}
+
 	LockGuard guard(this);
 
 	auto segment = getSegment(length);
@@ -900,7 +913,7 @@ ChangeLog::Segment* ChangeLog::createSegment()
 
 	const auto segment = FB_NEW_POOL(getPool()) Segment(getPool(), filename, fd);
 
-	segment->init(sequence, m_guid);
+	segment->init(sequence, m_guid, getSegmentVersion());
 	segment->addRef();
 
 	m_segments.add(segment);
@@ -945,7 +958,7 @@ ChangeLog::Segment* ChangeLog::reuseSegment(ChangeLog::Segment* segment)
 
 	segment = FB_NEW_POOL(getPool()) Segment(getPool(), newname, fd);
 
-	segment->init(sequence, m_guid);
+	segment->init(sequence, m_guid, getSegmentVersion());
 	segment->addRef();
 
 	m_segments.add(segment);
@@ -986,7 +999,22 @@ ChangeLog::Segment* ChangeLog::getSegment(ULONG length)
 
 	if (activeSegment)
 	{
-		if (activeSegment->getLength() + length > m_config->segmentSize)
+		// The segment started with another compression setting must not get
+		// blocks its version doesn't allow, or be marked as newer needlessly
+
+		if (activeSegment->getVersion() != getSegmentVersion())
+		{
+			if (activeSegment->hasData())
+			{
+				activeSegment->setState(SEGMENT_STATE_FULL);
+				state->flushMark++;
+				activeSegment = NULL;
+				m_workingSemaphore.release();
+			}
+			else
+				activeSegment->init(activeSegment->getSequence(), m_guid, getSegmentVersion());
+		}
+		else if (activeSegment->getLength() + length > m_config->segmentSize)
 		{
 			activeSegment->setState(SEGMENT_STATE_FULL);
 			state->flushMark++;
@@ -54,7 +54,8 @@ namespace Replication
 	const char CHANGELOG_SIGNATURE[] = "FBCHANGELOG";
 
 	const USHORT CHANGELOG_VERSION_1 = 1;
-	const USHORT CHANGELOG_CURRENT_VERSION = CHANGELOG_VERSION_1;
+	const USHORT CHANGELOG_VERSION_2 = 2;	// blocks could be compressed
+	const USHORT CHANGELOG_CURRENT_VERSION = CHANGELOG_VERSION_2;
 
 	class ChangeLog : protected Firebird::PermanentStorage, public Firebird::IpcObject
 	{
@@ -139,7 +140,7 @@ namespace Replication
 			Segment(MemoryPool& pool, const Firebird::PathName& filename, int handle);
 			virtual ~Segment();
 
-			void init(FB_UINT64 sequence, const Firebird::Guid& guid);
+			void init(FB_UINT64 sequence, const Firebird::Guid& guid, USHORT version);
 			bool validate(const Firebird::Guid& guid) const;
 			void append(ULONG length, const UCHAR* data);
 			void copyTo(const Firebird::PathName& filename) const;
@@ -164,6 +165,11 @@ namespace Replication
 				return m_header->hdr_sequence;
 			}
 
+			USHORT getVersion() const
+			{
+				return m_header->hdr_version;
+			}
+
 			SegmentState getState() const
 			{
 				return m_header->hdr_state;
@@ -224,6 +230,12 @@ namespace Replication
 			return segment->validate(m_guid);
 		}
 
+		// Older replication servers could read segments without compressed blocks
+		USHORT getSegmentVersion() const
+		{
+			return m_config->journalCompression ? CHANGELOG_VERSION_2 : CHANGELOG_VERSION_1;
+		}
+
 		void initSegments();
 		void clearSegments();
 
@@ -58,6 +58,8 @@ namespace
 	const ULONG DEFAULT_GROUP_FLUSH_DELAY = 0;
 	const ULONG DEFAULT_APPLY_IDLE_TIMEOUT = 10;				// seconds
 	const ULONG DEFAULT_APPLY_ERROR_TIMEOUT = 60;				// seconds
+	const ULONG DEFAULT_APPLY_WORKERS = 1;
+	const ULONG MAX_APPLY_WORKERS = 64;
 
 	void parseLong(const string& input, ULONG& output)
 	{
@@ -114,6 +116,7 @@ Config::Config()
 	  journalDirectory(getPool()),
 	  filePrefix(getPool()),
 	  groupFlushDelay(DEFAULT_GROUP_FLUSH_DELAY),
+	  journalCompression(false),
 	  archiveDirectory(getPool()),
 	  archiveCommand(getPool()),
 	  archiveTimeout(DEFAULT_ARCHIVE_TIMEOUT),
@@ -123,6 +126,7 @@ Config::Config()
 	  verboseLogging(false),
 	  applyIdleTimeout(DEFAULT_APPLY_IDLE_TIMEOUT),
 	  applyErrorTimeout(DEFAULT_APPLY_ERROR_TIMEOUT),
+	  applyWorkers(DEFAULT_APPLY_WORKERS),
 	  pluginName(getPool()),
 	  logErrors(true),
 	  reportErrors(false),
@@ -140,6 +144,7 @@ Config::Config(const Config& other)
 	  journalDirectory(getPool(), other.journalDirectory),
 	  filePrefix(getPool(), other.filePrefix),
 	  groupFlushDelay(other.groupFlushDelay),
+	  journalCompression(other.journalCompression),
 	  archiveDirectory(getPool(), other.archiveDirectory),
 	  archiveCommand(getPool(), other.archiveCommand),
 	  archiveTimeout(other.archiveTimeout),
@@ -149,6 +154,7 @@ Config::Config(const Config& other)
 	  verboseLogging(other.verboseLogging),
 	  applyIdleTimeout(other.applyIdleTimeout),
 	  applyErrorTimeout(other.applyErrorTimeout),
+	  applyWorkers(other.applyWorkers),
 	  pluginName(getPool(), other.pluginName),
 	  logErrors(other.logErrors),
 	  reportErrors(other.reportErrors),
@@ -256,6 +262,10 @@ Config* Config::get(const PathName& lookupName)
 				{
 					parseLong(value, config->groupFlushDelay);
 				}
+				else if (key == "journal_compression")
+				{
+					parseBoolean(value, config->journalCompression);
+				}
 				else if (key == "journal_archive_directory")
 				{
 					config->archiveDirectory = value.c_str();
@@ -401,6 +411,11 @@ void Config::enumerate(Firebird::Array<Config*>& replicas)
 				{
 					parseLong(value, config->applyErrorTimeout);
 				}
+				else if (key == "apply_workers")
+				{
+					parseLong(value, config->applyWorkers);
+					config->applyWorkers = MIN(config->applyWorkers, MAX_APPLY_WORKERS);
+				}
 			}
 
 			if (dbName.hasData() && config->sourceDirectory.hasData())
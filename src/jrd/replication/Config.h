@@ -48,6 +48,7 @@ namespace Replication
 		Firebird::PathName journalDirectory;
 		Firebird::PathName filePrefix;
 		ULONG groupFlushDelay;
+		bool journalCompression;
 		Firebird::PathName archiveDirectory;
 		Firebird::string archiveCommand;
 		ULONG archiveTimeout;
@@ -57,6 +58,7 @@ namespace Replication
 		bool verboseLogging;
 		ULONG applyIdleTimeout;
 		ULONG applyErrorTimeout;
+		ULONG applyWorkers;
 		Firebird::string pluginName;
 		bool logErrors;
 		bool reportErrors;
@@ -27,10 +27,13 @@
 #include "../common/isc_f_proto.h"
 #include "../common/utils_proto.h"
 #include "../common/ScanDir.h"
+#include "../common/classes/init.h"
+#include "../common/classes/zip.h"
 #include "../common/os/mod_loader.h"
 #include "../common/os/path_utils.h"
 #include "../jrd/constants.h"
 
+#include "Protocol.h"
 #include "Utils.h"
 
 #ifdef HAVE_UNISTD_H
@@ -70,6 +73,13 @@ namespace
 
 	const char* REPLICATION_LOGFILE = "replication.log";
 
+	// Smaller blocks are not worth compressing
+	const ULONG MIN_COMPRESS_LENGTH = 256;
+
+#ifdef HAVE_ZLIB_H
+	InitInstance<ZLib> zlib;
+#endif
+
 	class LogWriter : private GlobalStorage
 	{
 	public:
@@ -274,4 +284,111 @@ namespace Replication
 		logMessage(REPLICA_SIDE, VERBOSE_MSG, database, message);
 	}
 
+	// Compress the block data. The block header is copied with BLOCK_COMPRESSED
+	// flag set and the new length, the original length of the data is stored
+	// before the deflated data. Returns false if the data cannot be compressed
+	// or does not become smaller, it should be written as is then.
+
+	bool compressBlock(ULONG length, const UCHAR* data, UCharBuffer& output)
+	{
+#ifdef HAVE_ZLIB_H
+		fb_assert(length >= sizeof(Block));
+
+		Block header;
+		memcpy(&header, data, sizeof(Block));
+
+		const ULONG dataLength = length - sizeof(Block);
+
+		if (dataLength < MIN_COMPRESS_LENGTH || (header.flags & BLOCK_COMPRESSED) || !zlib())
+			return false;
+
+		const ULONG prefixLength = sizeof(Block) + sizeof(ULONG);
+		UCHAR* const buffer = output.getBuffer(length);
+
+		z_stream strm;
+		strm.zalloc = ZLib::allocFunc;
+		strm.zfree = ZLib::freeFunc;
+		strm.opaque = Z_NULL;
+
+		if (zlib().deflateInit(&strm, Z_DEFAULT_COMPRESSION) != Z_OK)
+			return false;
+
+		strm.next_in = const_cast<Bytef*>(data + sizeof(Block));
+		strm.avail_in = dataLength;
+		strm.next_out = buffer + prefixLength;
+		strm.avail_out = length - prefixLength;
+
+		// The output space is limited by the original length, thus the stream
+		// is not finished when the data does not become smaller
+		const int ret = zlib().deflate(&strm, Z_FINISH);
+		const ULONG packedLength = strm.total_out;
+		zlib().deflateEnd(&strm);
+
+		if (ret != Z_STREAM_END)
+			return false;
+
+		header.flags |= BLOCK_COMPRESSED;
+		header.length = sizeof(ULONG) + packedLength;
+
+		memcpy(buffer, &header, sizeof(Block));
+		memcpy(buffer + sizeof(Block), &dataLength, sizeof(ULONG));
+		output.shrink(prefixLength + packedLength);
+
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// Restore the block compressed by compressBlock()
+
+	void decompressBlock(ULONG length, const UCHAR* data, UCharBuffer& output)
+	{
+		Block header;
+		memcpy(&header, data, sizeof(Block));
+		fb_assert(header.flags & BLOCK_COMPRESSED);
+
+		const ULONG prefixLength = sizeof(Block) + sizeof(ULONG);
+
+		if (length < prefixLength || header.length != length - sizeof(Block))
+			raiseError("Compressed replication block is corrupted");
+
+#ifdef HAVE_ZLIB_H
+		if (!zlib())
+			(Arg::Gds(isc_random) << "Compressed replication block cannot be read" <<
+			 Arg::StatusVector(zlib().status)).raise();
+
+		ULONG dataLength;
+		memcpy(&dataLength, data + sizeof(Block), sizeof(ULONG));
+
+		UCHAR* const buffer = output.getBuffer(sizeof(Block) + dataLength);
+
+		z_stream strm;
+		strm.zalloc = ZLib::allocFunc;
+		strm.zfree = ZLib::freeFunc;
+		strm.opaque = Z_NULL;
+		strm.next_in = const_cast<Bytef*>(data + prefixLength);
+		strm.avail_in = length - prefixLength;
+
+		if (zlib().inflateInit(&strm) != Z_OK)
+			raiseError("Compressed replication block cannot be read");
+
+		strm.next_out = buffer + sizeof(Block);
+		strm.avail_out = dataLength;
+
+		const int ret = zlib().inflate(&strm, Z_FINISH);
+		const ULONG unpackedLength = strm.total_out;
+		zlib().inflateEnd(&strm);
+
+		if (ret != Z_STREAM_END || unpackedLength != dataLength)
+			raiseError("Compressed replication block is corrupted");
+
+		header.flags &= ~BLOCK_COMPRESSED;
+		header.length = dataLength;
+		memcpy(buffer, &header, sizeof(Block));
+#else
+		raiseError("Compressed replication block cannot be read, zlib is not supported");
+#endif
+	}
+
 } // namespace
@@ -25,6 +25,7 @@
 #define JRD_REPLICATION_UTILS_H
 
 #include "../common/classes/fb_string.h"
+#include "../common/classes/array.h"
 
 #ifdef WIN_NT
 #include <io.h>
@@ -71,6 +72,9 @@ namespace Replication
 	void logReplicaVerbose(const Firebird::PathName& database,
 						   const Firebird::string& message);
 
+	bool compressBlock(ULONG length, const UCHAR* data, Firebird::UCharBuffer& output);
+	void decompressBlock(ULONG length, const UCHAR* data, Firebird::UCharBuffer& output);
+
 	class AutoFile
 	{
 	public:
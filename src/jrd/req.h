@@ -282,6 +282,13 @@ public:
 	ULONG req_src_line;
 	ULONG req_src_column;
 
+	// Profiler state, see Profiler::enterLine()
+	ULONG req_prof_line;			// source position being timed, 0 if none
+	ULONG req_prof_column;
+	SINT64 req_prof_start;			// when its execution was started
+	SINT64 req_prof_session;		// profiler session req_prof_statement belongs to
+	FB_SIZE_T req_prof_statement;	// statement index in the profiler
+
 	dsc*			req_domain_validation;	// Current VALUE for constraint validation
 	SortOwner req_sorts;
 	Firebird::Array<record_param> req_rpb;	// record parameter blocks
@@ -42,6 +42,8 @@
 #include "../jrd/val.h"
 #include "../jrd/err_proto.h"
 #include "../yvalve/gds_proto.h"
+#include "../common/ThreadStart.h"
+#include "../common/classes/fb_atomic.h"
 
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
@@ -86,6 +88,11 @@ void SortOwner::unlinkAll()
 const ULONG MAX_SORT_BUFFER_SIZE = 1024 * 128;	// 128KB
 const ULONG MIN_RECORDS_TO_ALLOC = 8;
 
+// Parallel in-memory sorting is used only if every thread has enough work to do
+
+const ULONG MIN_RECORDS_PER_THREAD = 8192;
+const ULONG INTERVALS_PER_THREAD = 4;
+
 // the size of sr_bckptr (everything before sort_record) in bytes
 #define SIZEOF_SR_BCKPTR offsetof(sr, sr_sort_record)
 // the size of sr_bckptr in # of 32 bit longwords
@@ -154,6 +161,111 @@ namespace
 		*a = *b;
 		*b = temp;
 	}
+
+	// Interval of record pointers sorted independently from the others
+
+	struct SortInterval
+	{
+		SORTP** lower;
+		SORTP** upper;
+
+		SLONG getSize() const
+		{
+			return upper - lower + 1;
+		}
+	};
+
+	// Work shared between the threads of the parallel sort
+
+	struct SortWork
+	{
+		const SortInterval* intervals;
+		ULONG count;
+		ULONG length;
+		AtomicCounter next;
+	};
+
+	SORTP** partition(SORTP** r, SORTP** const upper, ULONG length)
+	{
+	/**************************************
+	 *
+	 * Partition the interval [r, upper] around a pivot record.
+	 * Return the final position of the pivot: all the records below it
+	 * are not greater and all the records above it are not less than the pivot.
+	 *
+	 **************************************/
+		SORTP** j = upper;
+		const SLONG interval = j - r;
+
+		// Go guard against pre-ordered data, swap the first record with the
+		// middle record. This isn't perfect, but it is cheap.
+
+		SORTP** i = r + interval / 2;
+		swap(i, r);
+
+		// Prepare to do the partition. Pick up the first longword of the
+		// key to speed up comparisons.
+
+		i = r + 1;
+		const ULONG key = **r;
+
+		// From each end of the interval converge to the middle swapping out of
+		// parition records as we go. Stop when we converge.
+
+		while (true)
+		{
+			while (**i < key)
+				i++;
+			if (**i == key)
+				while (i <= upper)
+				{
+					const SORTP* p = *i;
+					const SORTP* q = *r;
+					ULONG tl = length - 1;
+					while (tl && *p == *q)
+					{
+						p++;
+						q++;
+						tl--;
+					}
+					if (tl && *p > *q)
+						break;
+					i++;
+				}
+
+			while (**j > key)
+				j--;
+			if (**j == key)
+				while (j != r)
+				{
+					const SORTP* p = *j;
+					const SORTP* q = *r;
+					ULONG tl = length - 1;
+					while (tl && *p == *q)
+					{
+						p++;
+						q++;
+						tl--;
+					}
+					if (tl && *p < *q)
+						break;
+					j--;
+				}
+			if (i >= j)
+				break;
+			swap(i, j);
+			i++;
+			j--;
+		}
+
+		// We have formed two partitions, separated by a slot for the
+		// initial record "r". Exchange the record currently in the
+		// slot with "r".
+
+		swap(r, j);
+
+		return j;
+	}
 } // namespace
 
 
@@ -203,6 +315,13 @@ Sort::Sort(Database* dbb,
 		m_min_alloc_size = record_size * MIN_RECORDS_TO_ALLOC;
 		m_max_alloc_size = MAX(record_size * MIN_RECORDS_TO_ALLOC, MAX_SORT_BUFFER_SIZE);
 
+		// Parallel sorting makes sense only for buffers bigger than the default one
+
+		m_max_threads = MAX(dbb->dbb_config->getMaxSortThreads(), 1U);
+
+		if (m_max_threads > 1)
+			m_max_alloc_size = MAX(m_max_alloc_size, MAX_SORT_BUFFER_SIZE * RUN_GROUP);
+
 		m_dup_callback = call_back;
 		m_dup_callback_arg = user_arg;
 		m_max_records = max_records;
@@ -1763,84 +1882,18 @@ void Sort::quick(SLONG size, SORTP** pointers, ULONG length)
 		// Pick up the next interval off the respective stacks
 
 		SORTP** r = *--sl;
-		SORTP** j = *--su;
+		SORTP** i = *--su;
 
 		// Compute the interval. If two or less, defer the sort to a final pass.
 
-		const SLONG interval = j - r;
+		const SLONG interval = i - r;
 		if (interval < 2)
 			continue;
 
-		// Go guard against pre-ordered data, swap the first record with the
-		// middle record. This isn't perfect, but it is cheap.
-
-		SORTP** i = r + interval / 2;
-		swap(i, r);
-
-		// Prepare to do the partition. Pick up the first longword of the
-		// key to speed up comparisons.
-
-		i = r + 1;
-		const ULONG key = **r;
-
-		// From each end of the interval converge to the middle swapping out of
-		// parition records as we go. Stop when we converge.
-
-		while (true)
-		{
-			while (**i < key)
-				i++;
-			if (**i == key)
-				while (i <= *su)
-				{
-					const SORTP* p = *i;
-					const SORTP* q = *r;
-					ULONG tl = length - 1;
-					while (tl && *p == *q)
-					{
-						p++;
-						q++;
-						tl--;
-					}
-					if (tl && *p > *q)
-						break;
-					i++;
-				}
-
-			while (**j > key)
-				j--;
-			if (**j == key)
-				while (j != r)
-				{
-					const SORTP* p = *j;
-					const SORTP* q = *r;
-					ULONG tl = length - 1;
-					while (tl && *p == *q)
-					{
-						p++;
-						q++;
-						tl--;
-					}
-					if (tl && *p < *q)
-						break;
-					j--;
-				}
-			if (i >= j)
-				break;
-			swap(i, j);
-			i++;
-			j--;
-		}
-
-		// We have formed two partitions, separated by a slot for the
-		// initial record "r". Exchange the record currently in the
-		// slot with "r".
-
-		swap(r, j);
+		SORTP** const j = partition(r, i, length);
 
 		// Finally, stack the two intervals, longest first
 
-		i = *su;
 		if ((j - r) > (i - j + 1))
 		{
 			*sl++ = r;
@@ -1859,6 +1912,111 @@ void Sort::quick(SLONG size, SORTP** pointers, ULONG length)
 }
 
 
+void Sort::quickParallel(SLONG size, SORTP** pointers, ULONG length, ULONG threads)
+{
+/**************************************
+ *
+ * Sort an array of record pointers using multiple threads.
+ *
+ * The array is split into independent intervals using the same
+ * partitioning as quick() does. Every interval is surrounded by pivot
+ * records (or by the guard records) which never move anymore and thus
+ * serve as guards for the interval. Then intervals are sorted by
+ * quick() in parallel, no merge is required afterwards.
+ *
+ * The same warning as for quick() applies: partitions of size two
+ * are left unordered.
+ *
+ **************************************/
+	fb_assert(threads > 1);
+
+	HalfStaticArray<SortInterval, 64> intervals(m_owner->getPool());
+
+	SortInterval all;
+	all.lower = pointers;
+	all.upper = pointers + size - 1;
+	intervals.add(all);
+
+	const SLONG minSize = MIN_RECORDS_PER_THREAD / INTERVALS_PER_THREAD;
+
+	while (intervals.getCount() < threads * INTERVALS_PER_THREAD)
+	{
+		// Split the largest interval
+
+		FB_SIZE_T largest = 0;
+
+		for (FB_SIZE_T n = 1; n < intervals.getCount(); n++)
+		{
+			if (intervals[n].getSize() > intervals[largest].getSize())
+				largest = n;
+		}
+
+		SortInterval& interval = intervals[largest];
+
+		if (interval.getSize() < minSize)
+			break;
+
+		SORTP** const j = partition(interval.lower, interval.upper, length);
+
+		SortInterval upper;
+		upper.lower = j + 1;
+		upper.upper = interval.upper;
+
+		interval.upper = j - 1;
+		intervals.add(upper);
+	}
+
+	SortWork work;
+	work.intervals = intervals.begin();
+	work.count = intervals.getCount();
+	work.length = length;
+
+	HalfStaticArray<Thread::Handle, 16> handles(m_owner->getPool());
+
+	try
+	{
+		for (ULONG n = 1; n < threads; n++)
+		{
+			Thread::Handle handle;
+			Thread::start(sortThread, &work, THREAD_medium, &handle);
+			handles.add(handle);
+		}
+	}
+	catch (const Exception&)
+	{
+		// Failed to start more threads, work with those we already have
+	}
+
+	sortThread(&work);
+
+	for (FB_SIZE_T n = 0; n < handles.getCount(); n++)
+		Thread::waitForCompletion(handles[n]);
+}
+
+
+THREAD_ENTRY_DECLARE Sort::sortThread(THREAD_ENTRY_PARAM arg)
+{
+/**************************************
+ *
+ * Sort intervals of the parallel sort until there are no more.
+ *
+ **************************************/
+	SortWork* const work = static_cast<SortWork*>(arg);
+
+	while (true)
+	{
+		const ULONG n = (ULONG) work->next.exchangeAdd(1);
+
+		if (n >= work->count)
+			break;
+
+		const SortInterval& interval = work->intervals[n];
+		quick(interval.getSize(), interval.lower, work->length);
+	}
+
+	return 0;
+}
+
 ULONG Sort::order()
 {
 /**************************************
@@ -2065,7 +2223,12 @@ void Sort::sortBuffer(thread_db* tdbb)
 	SORTP** j = (SORTP**) (m_first_pointer) + 1;
 	const ULONG n = (SORTP**) (m_next_pointer) - j;	// calculate # of records
 
-	quick(n, j, m_longs);
+	const ULONG threads = MIN(m_max_threads, n / MIN_RECORDS_PER_THREAD);
+
+	if (threads > 1)
+		quickParallel(n, j, m_longs, threads);
+	else
+		quick(n, j, m_longs);
 
 	// Scream through and correct any out of order pairs
 	// hvlad: don't compare user keys against high_key
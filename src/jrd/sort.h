@@ -28,6 +28,7 @@
 #include "../common/DecFloat.h"
 #include "../jrd/TempSpace.h"
 #include "../jrd/align.h"
+#include "../common/ThreadData.h"
 
 namespace Jrd {
 
@@ -304,6 +305,8 @@ private:
 #endif
 
 	static void quick(SLONG, SORTP**, ULONG);
+	void quickParallel(SLONG, SORTP**, ULONG, ULONG);
+	static THREAD_ENTRY_DECLARE sortThread(THREAD_ENTRY_PARAM);
 
 	Database* m_dbb;							// Database
 	SortOwner* m_owner;							// Sort owner
@@ -329,6 +332,7 @@ private:
 
 	ULONG m_min_alloc_size;						// MIN and MAX values
 	ULONG m_max_alloc_size;						// for the run buffer size
+	ULONG m_max_threads;						// Threads allowed for in-memory sorting
 
 	Firebird::Array<sort_key_def> m_description;
 };
@@ -25,15 +25,40 @@
 #include <string.h>
 #include "../jrd/sqz.h"
 #include "../jrd/req.h"
+#include "../jrd/jrd.h"
+#include "../jrd/ods.h"
 #include "../jrd/err_proto.h"
 #include "../yvalve/gds_proto.h"
 
 using namespace Jrd;
 
+namespace
+{
+	const int MAX_SHORT_RUN = 128;
+	const int MAX_LONG_RUN = MAX_USHORT;
+
+	// Control byte of a long run. In the control array a long run takes four
+	// bytes: marker, length (low byte first) and marker again, thus the array
+	// could be walked both forward and backward. In the packed record the
+	// second marker is replaced by the repeated byte.
+	const int LONG_RUN = -1;
+	const int LONG_RUN_SIZE = 4;
+
+	inline FB_SIZE_T getLongRun(const UCHAR* p)
+	{
+		return p[0] | (p[1] << 8);
+	}
+}
 
-Compressor::Compressor(MemoryPool& pool, FB_SIZE_T length, const UCHAR* data)
-	: m_control(pool), m_length(0)
+
+Compressor::Compressor(thread_db* tdbb, FB_SIZE_T length, const UCHAR* data)
+	: m_control(*tdbb->getDefaultPool()), m_length(0)
 {
+	const Database* const dbb = tdbb->getDatabase();
+	const int maxRun =
+		(ENCODE_ODS(dbb->dbb_ods_version, dbb->dbb_minor_version) >= ODS_13_2) ?
+			MAX_LONG_RUN : MAX_SHORT_RUN;
+
 	UCHAR* control = m_control.getBuffer((length + 1) / 2, false);
 	const UCHAR* const end = data + length;
 
@@ -72,9 +97,10 @@ Compressor::Compressor(MemoryPool& pool, FB_SIZE_T length, const UCHAR* data)
 			*control++ = (UCHAR) max;
 		}
 
-		// Find compressible run. Compressable runs are limited to 128 bytes.
+		// Find compressible run. Compressable runs are limited to 128 bytes
+		// unless long runs are allowed.
 
-		if ((max = MIN(128, end - data)) >= 3)
+		if ((max = MIN(maxRun, end - data)) >= 3)
 		{
 			start = data;
 			const UCHAR c = *data;
@@ -87,8 +113,21 @@ Compressor::Compressor(MemoryPool& pool, FB_SIZE_T length, const UCHAR* data)
 				++data;
 			} while (--max);
 
-			*control++ = (UCHAR) (start - data);
-			m_length += 2;
+			const FB_SIZE_T run = data - start;
+
+			if (run > MAX_SHORT_RUN)
+			{
+				*control++ = (UCHAR) LONG_RUN;
+				*control++ = (UCHAR) run;
+				*control++ = (UCHAR) (run >> 8);
+				*control++ = (UCHAR) LONG_RUN;
+				m_length += LONG_RUN_SIZE;
+			}
+			else
+			{
+				*control++ = (UCHAR) (start - data);
+				m_length += 2;
+			}
 		}
 	}
 
@@ -179,7 +218,34 @@ FB_SIZE_T Compressor::pack(const UCHAR* input, FB_SIZE_T outLength, UCHAR* outpu
 		int length = (signed char) *control++;
 		*output++ = (UCHAR) length;
 
-		if (length < 0)
+		if (length == LONG_RUN)
+		{
+			const FB_SIZE_T run = getLongRun(control);
+			control += LONG_RUN_SIZE - 1;
+
+			if (space < LONG_RUN_SIZE - 1)
+			{
+				// Long run does not fit, store its head as a short run
+
+				--space;
+				output[-1] = (UCHAR) -MAX_SHORT_RUN;
+				*output++ = *input;
+				input += MAX_SHORT_RUN;
+
+				if (space > 0)
+				{
+					*output = 0;
+				}
+				return input - start;
+			}
+
+			space -= LONG_RUN_SIZE - 1;
+			*output++ = (UCHAR) run;
+			*output++ = (UCHAR) (run >> 8);
+			*output++ = *input;
+			input += run;
+		}
+		else if (length < 0)
 		{
 			--space;
 			*output++ = *input;
@@ -236,7 +302,21 @@ FB_SIZE_T Compressor::getPartialLength(FB_SIZE_T inLength, const UCHAR* input) c
 
 		int length = (signed char) *control++;
 
-		if (length < 0)
+		if (length == LONG_RUN)
+		{
+			const FB_SIZE_T run = getLongRun(control);
+			control += LONG_RUN_SIZE - 1;
+
+			if (space < LONG_RUN_SIZE - 1)
+			{
+				input += MAX_SHORT_RUN;
+				return input - start;
+			}
+
+			space -= LONG_RUN_SIZE - 1;
+			input += run;
+		}
+		else if (length < 0)
 		{
 			--space;
 			input += (-length) & 255;
@@ -275,7 +355,25 @@ UCHAR* Compressor::unpack(FB_SIZE_T inLength,
 	{
 		const int len = (signed char) *input++;
 
-		if (len < 0)
+		if (len == LONG_RUN)
+		{
+			if (end - input < LONG_RUN_SIZE - 1)
+			{
+				BUGCHECK(179);	// msg 179 decompression overran buffer
+			}
+
+			const FB_SIZE_T run = getLongRun(input);
+
+			if (run > (FB_SIZE_T) (output_end - output))
+			{
+				BUGCHECK(179);	// msg 179 decompression overran buffer
+			}
+
+			memset(output, input[2], run);
+			output += run;
+			input += LONG_RUN_SIZE - 1;
+		}
+		else if (len < 0)
 		{
 			if (input >= end || (output - len) > output_end)
 			{
@@ -446,7 +544,15 @@ void Compressor::pack(const UCHAR* input, UCHAR* output) const
 		const int length = (signed char) *control++;
 		*output++ = (UCHAR) length;
 
-		if (length < 0)
+		if (length == LONG_RUN)
+		{
+			*output++ = control[0];
+			*output++ = control[1];
+			*output++ = *input;
+			input += getLongRun(control);
+			control += LONG_RUN_SIZE - 1;
+		}
+		else if (length < 0)
 		{
 			*output++ = *input;
 			input -= length;
@@ -29,10 +29,23 @@
 
 namespace Jrd
 {
+	class thread_db;
+
+	// Compressed record is a sequence of control bytes followed by data:
+	//
+	//	1 .. 127	- the given number of bytes follows as is
+	//	-3 .. -128	- the next byte is repeated the given number of times
+	//	-1			- the next two bytes are the run length (up to 64KB, low byte
+	//				  first) and the byte after them is repeated that many times
+	//
+	// Long runs are generated for databases with ODS 13.2 and newer only, thus
+	// NULL or zero columns and unused tails of VARCHARs take a few bytes
+	// instead of two bytes per every 128 bytes. Older records are read as is.
+
 	class Compressor
 	{
 	public:
-		Compressor(MemoryPool& pool, FB_SIZE_T length, const UCHAR* data);
+		Compressor(thread_db* tdbb, FB_SIZE_T length, const UCHAR* data);
 
 		FB_SIZE_T getPackedLength() const
 		{
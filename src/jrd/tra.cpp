@@ -106,6 +106,7 @@ static void restart_requests(thread_db*, jrd_tra*);
 static void start_sweeper(thread_db*);
 //static THREAD_ENTRY_DECLARE sweep_database(THREAD_ENTRY_PARAM);
 static void transaction_flush(thread_db* tdbb, USHORT flush_flag, TraNumber tra_number);
+static bool group_commit(thread_db* tdbb, const jrd_tra* transaction);
 static void transaction_options(thread_db*, jrd_tra*, const UCHAR*, USHORT);
 static void transaction_start(thread_db* tdbb, jrd_tra* temp);
 
@@ -469,6 +470,11 @@ void TRA_commit(thread_db* tdbb, jrd_tra* transaction, const bool retaining_flag
 	while (transaction->tra_save_point && !transaction->tra_save_point->isRoot())
 		transaction->rollforwardSavepoint(tdbb);
 
+	// Insert index keys deferred by bulk modifications
+
+	if (transaction->tra_deferred_keys)
+		transaction->tra_deferred_keys->flush(tdbb, transaction);
+
 	// Let replicator perform heavy and error-prone part of work
 
 	REPL_trans_prepare(tdbb, transaction);
@@ -505,11 +511,13 @@ void TRA_commit(thread_db* tdbb, jrd_tra* transaction, const bool retaining_flag
 	while (transaction->tra_save_point)
 		transaction->rollforwardSavepoint(tdbb);
 
-	// Flush pages if transaction logically modified data
+	// Flush pages if transaction logically modified data. With the group
+	// commit they're written together with the state of the transaction.
 
 	if (transaction->tra_flags & TRA_write)
 	{
-		transaction_flush(tdbb, FLUSH_TRAN, transaction->tra_number);
+		if (retaining_flag || !group_commit(tdbb, transaction))
+			transaction_flush(tdbb, FLUSH_TRAN, transaction->tra_number);
 	}
 	else if ((transaction->tra_flags & (TRA_prepare2 | TRA_reconnected)) ||
 		(sysTran->tra_flags & TRA_write))
@@ -1094,6 +1102,11 @@ void TRA_prepare(thread_db* tdbb, jrd_tra* transaction, USHORT length, const UCH
 			status_exception::raise(&st);
 	}
 
+	// Insert index keys deferred by bulk modifications
+
+	if (transaction->tra_deferred_keys)
+		transaction->tra_deferred_keys->flush(tdbb, transaction);
+
 	// Perform any meta data work deferred
 
 	DFW_perform_work(tdbb, transaction);
@@ -1102,7 +1115,10 @@ void TRA_prepare(thread_db* tdbb, jrd_tra* transaction, USHORT length, const UCH
 	jrd_tra* sysTran = tdbb->getAttachment()->getSysTransaction();
 
 	if (transaction->tra_flags & TRA_write)
-		transaction_flush(tdbb, FLUSH_TRAN, transaction->tra_number);
+	{
+		if ((tdbb->tdbb_flags & TDBB_replicator) || !group_commit(tdbb, transaction))
+			transaction_flush(tdbb, FLUSH_TRAN, transaction->tra_number);
+	}
 	else if ((transaction->tra_flags & TRA_prepare2) || (sysTran->tra_flags & TRA_write))
 	{
 		// If the transaction only read data but is a member of a
@@ -1367,6 +1383,11 @@ void TRA_rollback(thread_db* tdbb, jrd_tra* transaction, const bool retaining_fl
 	if (transaction->tra_flags & (TRA_prepare2 | TRA_reconnected))
 		MET_update_transaction(tdbb, transaction, false);
 
+	// Index keys of the records being rolled back are not needed
+
+	if (transaction->tra_deferred_keys)
+		transaction->tra_deferred_keys->clear();
+
 	// If force flag is true, get rid of all savepoints to mark the transaction as dead
 	if (force_flag || (transaction->tra_flags & TRA_invalidated))
 	{
@@ -1493,6 +1514,21 @@ void TRA_set_state(thread_db* tdbb, jrd_tra* transaction, TraNumber number, int
 		return;
 	}
 
+	// The group commit leader sets the state after the pages of the transaction
+	// are written. The state of the read-only transaction committed in the shared
+	// cache doesn't need to be written immediately.
+
+	if (transaction && transaction->tra_number == number && group_commit(tdbb, transaction) &&
+		(!(dbb->dbb_flags & DBB_shared) || (transaction->tra_flags & (TRA_write | TRA_prepared)) ||
+			state != tra_committed))
+	{
+		dbb->dbb_group_commit.setState(tdbb, number, state);
+
+		jrd_tra* const sysTran = tdbb->getAttachment()->getSysTransaction();
+		sysTran->tra_flags &= ~TRA_write;
+		return;
+	}
+
 	const ULONG trans_per_tip = dbb->dbb_page_manager.transPerTIP;
 	const ULONG sequence = number / trans_per_tip;
 	const ULONG byte = TRANS_OFFSET(number % trans_per_tip);
@@ -1552,6 +1588,45 @@ void TRA_set_state(thread_db* tdbb, jrd_tra* transaction, TraNumber number, int
 }
 
 
+void TRA_set_group_state(thread_db* tdbb, TraNumber number, int state)
+{
+/**************************************
+ *
+ *	T R A _ s e t _ g r o u p _ s t a t e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Set the state of a transaction of the commit group on
+ *	the inventory page. The pages of the transaction are
+ *	already written, the inventory page is written by the
+ *	group leader after the states of all the group are set.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	Database* const dbb = tdbb->getDatabase();
+
+	const ULONG trans_per_tip = dbb->dbb_page_manager.transPerTIP;
+	const ULONG sequence = number / trans_per_tip;
+	const ULONG byte = TRANS_OFFSET(number % trans_per_tip);
+	const USHORT shift = TRANS_SHIFT(number);
+
+	WIN window(DB_PAGE_SPACE, -1);
+	tx_inv_page* tip = fetch_inventory_page(tdbb, &window, sequence, LCK_write);
+
+	CCH_MARK_SYSTEM(tdbb, &window);
+
+	UCHAR* address = tip->tip_transactions + byte;
+	*address &= ~(TRA_MASK << shift);
+	*address |= state << shift;
+
+	if (dbb->dbb_tip_cache)
+		TPC_set_state(tdbb, number, state);
+
+	CCH_RELEASE(tdbb, &window);
+}
+
+
 int TRA_snapshot_state(thread_db* tdbb, const jrd_tra* trans, TraNumber number, CommitNumber* snapshot)
 {
 /**************************************
@@ -2840,13 +2915,39 @@ static void transaction_flush(thread_db* tdbb, USHORT flush_flag, TraNumber tra_
  **************************************/
 	fb_assert(flush_flag == FLUSH_TRAN || flush_flag == FLUSH_SYSTEM);
 
-	CCH_flush(tdbb, flush_flag, tra_number);
+	Database* const dbb = tdbb->getDatabase();
+
+	if (GroupCommit::isEnabled(tdbb))
+		dbb->dbb_group_commit.flush(tdbb, (flush_flag == FLUSH_TRAN) ? tra_number : 0);
+	else
+		CCH_flush(tdbb, flush_flag, tra_number);
 
 	jrd_tra* const sysTran = tdbb->getAttachment()->getSysTransaction();
 	sysTran->tra_flags &= ~TRA_write;
 }
 
 
+static bool group_commit(thread_db* tdbb, const jrd_tra* transaction)
+{
+/**************************************
+ *
+ *	g r o u p _ c o m m i t
+ *
+ **************************************
+ *
+ * Functional description
+ *	Check whether the state of the transaction is set
+ *	by the group commit after its pages are written.
+ *
+ **************************************/
+#ifdef SUPERSERVER_V2
+	return false;
+#else
+	return GroupCommit::isEnabled(tdbb) && !(transaction->tra_flags & TRA_precommitted);
+#endif
+}
+
+
 static void transaction_options(thread_db* tdbb,
 								jrd_tra* transaction,
 								const UCHAR* tpb, USHORT tpb_length)
@@ -3750,6 +3851,7 @@ jrd_tra::~jrd_tra()
 	delete tra_timezone_snapshot;
 	delete tra_mapping_list;
 	delete tra_gen_ids;
+	delete tra_deferred_keys;
 
 	if (!tra_outer)
 		delete tra_blob_space;
@@ -3961,6 +4063,9 @@ void jrd_tra::rollbackSavepoint(thread_db* tdbb, bool preserveLocks)
 		if (tra_flags & TRA_ex_restart)
 			preserveLocks = true;
 
+		if (tra_deferred_keys)
+			tra_deferred_keys->undo(tra_save_point->getNumber());
+
 		Jrd::ContextPoolHolder context(tdbb, tra_pool);
 		tra_save_point = tra_save_point->rollback(tdbb, NULL, preserveLocks);
 	}
@@ -46,6 +46,7 @@
 #include "../jrd/obj.h"
 #include "../jrd/EngineInterface.h"
 #include "../jrd/Savepoint.h"
+#include "../jrd/DeferredIndexKeys.h"
 
 namespace EDS {
 class Transaction;
@@ -186,6 +187,7 @@ public:
 		tra_snapshot_number(0),
 		tra_sorts(*p),
 		tra_gen_ids(NULL),
+		tra_deferred_keys(NULL),
 		tra_replicator(NULL),
 		tra_interface(NULL),
 		tra_blob_space(NULL),
@@ -300,6 +302,7 @@ public:
 	EDS::Transaction *tra_ext_common;
 	//Transaction *tra_ext_two_phase;
 	GenIdCache* tra_gen_ids;
+	DeferredIndexKeys* tra_deferred_keys;	// index keys not inserted yet
 	Firebird::IReplicatedTransaction* tra_replicator;
 
 private:
@@ -398,6 +401,14 @@ public:
 
 		return tra_gen_ids;
 	}
+
+	DeferredIndexKeys* getDeferredKeys()
+	{
+		if (!tra_deferred_keys)
+			tra_deferred_keys = FB_NEW_POOL(*tra_pool) DeferredIndexKeys(*tra_pool);
+
+		return tra_deferred_keys;
+	}
 };
 
 // System transaction is always transaction 0.
@@ -426,6 +437,7 @@ const ULONG TRA_own_interface		= 0x20000L;		// tra_interface was created for int
 const ULONG TRA_read_consistency	= 0x40000L; 	// ensure read consistency in this transaction
 const ULONG TRA_ex_restart			= 0x80000L; 	// Exception was raised to restart request
 const ULONG TRA_replicating			= 0x100000L;	// transaction is allowed to be replicated
+const ULONG TRA_defer_keys			= 0x200000L;	// top level statement may defer index keys
 
 // flags derived from TPB, see also transaction_options() at tra.cpp
 const ULONG TRA_OPTIONS_MASK = (TRA_degree3 | TRA_readonly | TRA_ignore_limbo | TRA_read_committed |
@@ -2715,6 +2715,12 @@ Validation::RTN Validation::walk_record(jrd_rel* relation, const rhd* header, US
 			record_length += c;
 			p += c;
 		}
+		else if (c == -1)
+		{
+			// Long run: two bytes of length (low byte first) and the repeated byte
+			record_length += (UCHAR) p[0] | ((UCHAR) p[1] << 8);
+			p += 3;
+		}
 		else
 		{
 			record_length -= c;
@@ -2774,6 +2780,12 @@ Validation::RTN Validation::walk_record(jrd_rel* relation, const rhd* header, US
 				record_length += c;
 				p += c;
 			}
+			else if (c == -1)
+			{
+				// Long run: two bytes of length (low byte first) and the repeated byte
+				record_length += (UCHAR) p[0] | ((UCHAR) p[1] << 8);
+				p += 3;
+			}
 			else
 			{
 				record_length -= c;
@@ -88,6 +88,8 @@
 #include "../jrd/Function.h"
 #include "../common/StatusArg.h"
 #include "../jrd/GarbageCollector.h"
+#include "../jrd/IndexGarbage.h"
+#include "../jrd/ParallelTask.h"
 #include "../jrd/trace/TraceManager.h"
 #include "../jrd/trace/TraceJrdHelpers.h"
 
@@ -106,7 +108,7 @@ static UCHAR* delete_tail(thread_db*, record_param*, ULONG, UCHAR*, const UCHAR*
 static void expunge(thread_db*, record_param*, const jrd_tra*, ULONG);
 static bool dfw_should_know(thread_db*, record_param* org_rpb, record_param* new_rpb,
 	USHORT irrelevant_field, bool void_update_is_relevant = false);
-static void garbage_collect(thread_db*, record_param*, ULONG, RecordStack&);
+static void garbage_collect(thread_db*, record_param*, ULONG, RecordStack&, IndexGarbage* = NULL);
 
 
 #ifdef VIO_DEBUG
@@ -3310,7 +3312,7 @@ bool VIO_next_record(thread_db* tdbb,
 #endif
 
 	do {
-		if (!DPM_next(tdbb, rpb, lock_type, onepage))
+		if (!DPM_next(tdbb, rpb, lock_type, onepage ? DPM_next_data_page : DPM_next_all))
 		{
 			return false;
 		}
@@ -3872,6 +3874,185 @@ void VIO_store(thread_db* tdbb, record_param* rpb, jrd_tra* transaction)
 }
 
 
+namespace
+{
+	// Number of pointer pages swept by a parallel worker at a time
+	const ULONG SWEEP_PARALLEL_UNIT_PP = 1;
+
+	// Sweep by a number of parallel workers. Every unit of work is a range
+	// of pointer pages of a relation, the scan of each pointer page stops at
+	// its end. The last unit of the relation is not limited as the relation
+	// could grow while we are here.
+
+	class SweepTask : public ParallelTask
+	{
+	public:
+		SweepTask(thread_db* tdbb, jrd_tra* transaction)
+			: m_attachment(tdbb->getAttachment()),
+			  m_transaction(transaction),
+			  m_units(*tdbb->getDefaultPool()),
+			  m_nextUnit(0),
+			  m_gcDisabled(0)
+		{}
+
+		void addRelation(thread_db* tdbb, jrd_rel* relation);
+
+		FB_SIZE_T getUnits() const
+		{
+			return m_units.getCount();
+		}
+
+		bool isGcDisabled() const
+		{
+			return m_gcDisabled.value() != 0;
+		}
+
+	protected:
+		void work(thread_db* tdbb);
+
+	private:
+		struct Unit
+		{
+			USHORT relationId;
+			ULONG firstPointerPage;
+			bool last;
+		};
+
+		bool sweep(thread_db* tdbb, jrd_rel* relation, jrd_tra* transaction, const Unit& unit);
+
+		Jrd::Attachment* const m_attachment;
+		jrd_tra* const m_transaction;
+		HalfStaticArray<Unit, 64> m_units;
+		AtomicCounter m_nextUnit;
+		AtomicCounter m_gcDisabled;
+	};
+
+	void SweepTask::addRelation(thread_db* tdbb, jrd_rel* relation)
+	{
+		const ULONG pointerPages = relation->getPages(tdbb)->rel_pages->count();
+
+		for (ULONG sequence = 0; sequence < pointerPages; sequence += SWEEP_PARALLEL_UNIT_PP)
+		{
+			Unit unit;
+			unit.relationId = relation->rel_id;
+			unit.firstPointerPage = sequence;
+			unit.last = (sequence + SWEEP_PARALLEL_UNIT_PP >= pointerPages);
+			m_units.add(unit);
+		}
+	}
+
+	void SweepTask::work(thread_db* tdbb)
+	{
+		jrd_tra* transaction = m_transaction;
+
+		// Additional workers use their own attachments and transactions,
+		// they must garbage collect synchronously just like the sweeper does
+
+		if (tdbb->getAttachment() != m_attachment)
+		{
+			tdbb->markAsSweeper();
+			tdbb->getAttachment()->att_flags &= ~ATT_notify_gc;
+			transaction = tdbb->getTransaction();
+		}
+
+		while (!isCancelled() && !isGcDisabled())
+		{
+			const FB_SIZE_T n = (FB_SIZE_T) m_nextUnit.exchangeAdd(1);
+
+			if (n >= m_units.getCount())
+				break;
+
+			const Unit& unit = m_units[n];
+
+			jrd_rel* const relation = MET_lookup_relation_id(tdbb, unit.relationId, false);
+
+			if (!relation || (relation->rel_flags & (REL_deleted | REL_deleting)))
+				continue;
+
+			if (tdbb->getAttachment() != m_attachment)
+				MET_scan_relation(tdbb, relation);
+
+			if (!sweep(tdbb, relation, transaction, unit))
+			{
+				m_gcDisabled.setValue(1);
+				break;
+			}
+		}
+	}
+
+	bool SweepTask::sweep(thread_db* tdbb, jrd_rel* relation, jrd_tra* transaction, const Unit& unit)
+	{
+		// Returns false if garbage collection is disabled for the relation
+
+		Database* const dbb = tdbb->getDatabase();
+		Jrd::Attachment* const attachment = tdbb->getAttachment();
+
+		jrd_rel::GCShared gcGuard(tdbb, relation);
+		if (!gcGuard.gcEnabled())
+			return false;
+
+		if (unit.firstPointerPage == 0)
+		{
+			if (GarbageCollector* gc = dbb->dbb_garbage_collector)
+				gc->sweptRelation(transaction->tra_oldest_active, relation->rel_id);
+		}
+
+		const SINT64 ppRecords = (SINT64) dbb->dbb_dp_per_pp * dbb->dbb_max_records;
+		const ULONG ppEnd = unit.firstPointerPage + (unit.last ? 1 : SWEEP_PARALLEL_UNIT_PP);
+
+		record_param rpb;
+		rpb.rpb_record = NULL;
+		rpb.rpb_stream_flags = RPB_s_no_data | RPB_s_sweeper;
+		rpb.getWindow(tdbb).win_flags = WIN_large_scan;
+		rpb.rpb_relation = relation;
+		rpb.rpb_org_scans = relation->rel_scan_count++;
+
+		try
+		{
+			for (ULONG sequence = unit.firstPointerPage;
+				 sequence < ppEnd && !(relation->rel_flags & REL_deleting);
+				 sequence++)
+			{
+				// The scan is not let beyond the pointer page, thus no record
+				// is fetched and garbage collected by two workers
+
+				const FindNextRecordScope scope = unit.last ? DPM_next_all : DPM_next_pointer_page;
+
+				rpb.rpb_number.setValue(sequence * ppRecords - 1);
+
+				while (DPM_next(tdbb, &rpb, LCK_read, scope))
+				{
+					if (!VIO_chase_record_version(tdbb, &rpb, transaction, NULL, false, false))
+						continue;
+
+					CCH_RELEASE(tdbb, &rpb.getWindow(tdbb));
+
+					if (relation->rel_flags & REL_deleting)
+						break;
+
+					JRD_reschedule(tdbb);
+
+					transaction->tra_oldest_active = dbb->dbb_oldest_snapshot;
+					if (TipCache* cache = dbb->dbb_tip_cache)
+						cache->updateActiveSnapshots(tdbb, &attachment->att_active_snapshots);
+				}
+			}
+		}
+		catch (const Exception&)
+		{
+			delete rpb.rpb_record;
+			--relation->rel_scan_count;
+			throw;
+		}
+
+		delete rpb.rpb_record;
+		--relation->rel_scan_count;
+
+		return true;
+	}
+}
+
+
 bool VIO_sweep(thread_db* tdbb, jrd_tra* transaction, TraceSweepEvent* traceSweep)
 {
 /**************************************
@@ -3901,6 +4082,36 @@ bool VIO_sweep(thread_db* tdbb, jrd_tra* transaction, TraceSweepEvent* traceSwee
 	// hvlad: restore tdbb->transaction since it can be used later
 	tdbb->setTransaction(transaction);
 
+	// Split relations into ranges of pointer pages and sweep them by a
+	// number of workers. Per-relation progress is not traced in this case.
+
+	const unsigned workers = ParallelTask::getWorkers(tdbb);
+
+	if (workers > 1)
+	{
+		SweepTask task(tdbb, transaction);
+
+		vec<jrd_rel*>* vector;
+		for (FB_SIZE_T i = 1; (vector = attachment->att_relations) && i < vector->count(); i++)
+		{
+			jrd_rel* relation = (*vector)[i];
+			if (relation)
+				relation = MET_lookup_relation_id(tdbb, i, false);
+
+			if (relation &&
+				!(relation->rel_flags & (REL_deleted | REL_deleting)) &&
+				!relation->isTemporary() &&
+				relation->getPages(tdbb)->rel_pages)
+			{
+				task.addRelation(tdbb, relation);
+			}
+		}
+
+		task.run(tdbb, (unsigned) MIN(workers, MAX(task.getUnits(), 1)));
+
+		return !task.isGcDisabled();
+	}
+
 	record_param rpb;
 	rpb.rpb_record = NULL;
 	rpb.rpb_stream_flags = RPB_s_no_data | RPB_s_sweeper;
@@ -4661,7 +4872,8 @@ static void expunge(thread_db* tdbb, record_param* rpb, const jrd_tra* transacti
 }
 
 
-static void garbage_collect(thread_db* tdbb, record_param* rpb, ULONG prior_page, RecordStack& staying)
+static void garbage_collect(thread_db* tdbb, record_param* rpb, ULONG prior_page, RecordStack& staying,
+							IndexGarbage* garbage)
 {
 /**************************************
  *
@@ -4677,6 +4889,7 @@ static void garbage_collect(thread_db* tdbb, record_param* rpb, ULONG prior_page
  *	2) just had its back pointers set to zero
  *	Therefor we can do a fetch on the back pointers we've got
  *	because we have the last existing copy of them.
+ *	If the batch is passed, removal of the index keys is deferred.
  *
  **************************************/
 
@@ -4724,7 +4937,7 @@ static void garbage_collect(thread_db* tdbb, record_param* rpb, ULONG prior_page
 		JRD_reschedule(tdbb);
 	}
 
-	IDX_garbage_collect(tdbb, rpb, going, staying);
+	IDX_garbage_collect(tdbb, rpb, going, staying, garbage);
 	BLB_garbage_collect(tdbb, going, staying, prior_page, rpb->rpb_relation);
 
 	clearRecordStack(going);
@@ -4888,6 +5101,9 @@ void Database::garbage_collector(Database* dbb)
 
 						rpb.rpb_relation = relation;
 
+						IndexGarbage indexGarbage(*tdbb->getDefaultPool(), relation);
+						AutoSetRestore<IndexGarbage*> autoGarbage(&tdbb->tdbb_index_garbage, &indexGarbage);
+
 						while (gc_bitmap->getFirst())
 						{
 							const ULONG dp_sequence = gc_bitmap->current();
@@ -4922,39 +5138,69 @@ void Database::garbage_collector(Database* dbb)
 
 							bool rel_exit = false;
 
-							while (VIO_next_record(tdbb, &rpb, transaction, NULL, true))
+							try
 							{
-								CCH_RELEASE(tdbb, &rpb.getWindow(tdbb));
-
-								if (!(dbb->dbb_flags & DBB_garbage_collector))
+								while (VIO_next_record(tdbb, &rpb, transaction, NULL, true))
 								{
-									gc_exit = true;
-									break;
-								}
+									CCH_RELEASE(tdbb, &rpb.getWindow(tdbb));
 
-								if (relation->rel_flags & REL_deleting)
-								{
-									rel_exit = true;
-									break;
+									if (!(dbb->dbb_flags & DBB_garbage_collector))
+									{
+										gc_exit = true;
+										break;
+									}
+
+									if (relation->rel_flags & REL_deleting)
+									{
+										rel_exit = true;
+										break;
+									}
+
+									if (relation->rel_flags & REL_gc_disabled)
+									{
+										rel_exit = true;
+										break;
+									}
+
+									JRD_reschedule(tdbb);
+
+									if (rpb.rpb_number >= last)
+										break;
+
+									// Refresh our notion of the oldest transactions for
+									// efficient garbage collection. This is very cheap.
+
+									transaction->tra_oldest = dbb->dbb_oldest_transaction;
+									transaction->tra_oldest_active = dbb->dbb_oldest_snapshot;
 								}
+							}
+							catch (const Firebird::Exception&)
+							{
+								// The versions purged so far are gone, their keys could not
+								// be collected again. Remove them unless the page buffers
+								// are still held, the original error is reported anyway.
 
-								if (relation->rel_flags & REL_gc_disabled)
+								if (!(relation->rel_flags & REL_deleting) && tdbb->tdbb_bdbs.isEmpty())
 								{
-									rel_exit = true;
-									break;
+									try
+									{
+										indexGarbage.flush(tdbb);
+									}
+									catch (const Firebird::Exception&)
+									{} // no-op
 								}
 
-								JRD_reschedule(tdbb);
+								throw;
+							}
 
-								if (rpb.rpb_number >= last)
-									break;
+							// Remove the index keys of the versions purged on the page
+							// before the records could be updated again. There is no
+							// point to do it if the relation is being dropped.
 
-								// Refresh our notion of the oldest transactions for
-								// efficient garbage collection. This is very cheap.
-
-								transaction->tra_oldest = dbb->dbb_oldest_transaction;
-								transaction->tra_oldest_active = dbb->dbb_oldest_snapshot;
-							}
+							if (relation->rel_flags & REL_deleting)
+								indexGarbage.clear();
+							else
+								indexGarbage.flush(tdbb);
 
 							if (TipCache* cache = dbb->dbb_tip_cache)
 								cache->updateActiveSnapshots(tdbb, &attachment->att_active_snapshots);
@@ -6033,9 +6279,16 @@ static void purge(thread_db* tdbb, record_param* rpb)
 	DPM_rewrite_header(tdbb, rpb);
 	CCH_RELEASE(tdbb, &rpb->getWindow(tdbb));
 
+	// The background garbage collector removes the index keys of
+	// the purged versions in batches, see IndexGarbage.
+
+	IndexGarbage* garbage = tdbb->tdbb_index_garbage;
+	if (garbage && garbage->getRelation() != relation)
+		garbage = NULL;
+
 	RecordStack staying;
 	staying.push(record);
-	garbage_collect(tdbb, &temp, rpb->rpb_page, staying);
+	garbage_collect(tdbb, &temp, rpb->rpb_page, staying, garbage);
 
 	tdbb->bumpRelStats(RuntimeStatistics::RECORD_PURGES, relation->rel_id);
 	return; // true;
@@ -3715,6 +3715,8 @@ void LockManager::wait_for_request(thread_db* tdbb, lrq* request, SSHORT lck_wai
  **************************************/
 	ASSERT_ACQUIRED;
 
+	RuntimeStatistics::WaitTimer timer(tdbb, RuntimeStatistics::LOCK_WAITS);
+
 	++(m_sharedMemory->getHeader()->lhb_waits);
 	const ULONG scan_interval = m_sharedMemory->getHeader()->lhb_scan_interval;
 
@@ -18,7 +18,7 @@ set bulk_insert INSERT INTO FACILITIES (LAST_CHANGE, FACILITY, FAC_CODE, MAX_NUM
 ('2019-10-19 12:52:29', 'GSTAT', 21, 63)
 ('2021-02-04 10:32:00', 'FBSVCMGR', 22, 62)
 ('2009-07-18 12:12:12', 'UTL', 23, 2)
-('2020-12-20 15:40:00', 'NBACKUP', 24, 82)
+('2026-10-18 12:00:00', 'NBACKUP', 24, 84)
 ('2009-07-20 07:55:48', 'FBTRACEMGR', 25, 41)
 ('2015-07-27 00:00:00', 'JAYBIRD', 26, 1)
 ('2020-11-27 00:00:00', 'R2DBC_FIREBIRD', 27, 1)
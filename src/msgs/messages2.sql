@@ -2994,6 +2994,8 @@ Analyzing database pages ...', NULL, NULL);
 (NULL, 'usage', 'nbackup.cpp', NULL, 24, 79, NULL, '  -INPLACE option could corrupt the database that has changed since previous restore.', NULL, NULL)
 (NULL, 'usage', 'nbackup.cpp', NULL, 24, 80, NULL, '  -SEQ(UENCE)                            Preserve original replication sequence', NULL, NULL)
 ('nbackup_seq_misuse', 'nbackup', 'nbackup.cpp', NULL, 24, 81, NULL, 'Switch -SEQ(UENCE) can be used only with -FIXUP or -RESTORE', NULL, NULL)
+(NULL, 'usage', 'nbackup.cpp', NULL, 24, 82, NULL, '  -PAR(ALLEL) <n>                        Number of threads to read, compress and decompress backup', NULL, NULL)
+(NULL, 'usage', 'nbackup.cpp', NULL, 24, 83, NULL, '  -COMP(RESS)                            Compress backup file', NULL, NULL)
 -- FBTRACEMGR
 -- All messages use the new format.
 (NULL, 'usage', 'TraceCmdLine.cpp', NULL, 25, 1, NULL, 'Firebird Trace Manager version @1', NULL, NULL)
@@ -1012,6 +1012,7 @@ static rem_port* analyze(ClntAuthBlock& cBlock, PathName& attach_name, unsigned
 	Firebird::ICryptKeyCallback* cryptCb);
 static void batch_gds_receive(rem_port*, struct rmtque *, USHORT);
 static void batch_dsql_fetch(rem_port*, struct rmtque *, USHORT);
+static void cache_inline_blob(Rdb*, const P_INLINE_BLOB*);
 static void clear_queue(rem_port*);
 static void clear_stmt_que(rem_port*, Rsr*);
 static void disconnect(rem_port*);
@@ -1024,6 +1025,7 @@ static void info(CheckStatusWrapper*, Rdb*, P_OP, USHORT, USHORT, USHORT,
 	const UCHAR*, USHORT, const UCHAR*, ULONG, UCHAR*);
 static void init(CheckStatusWrapper*, ClntAuthBlock&, rem_port*, P_OP, PathName&,
 	ClumpletWriter&, IntlParametersBlock&, ICryptKeyCallback* cryptCallback);
+static void inline_blob_info(const Rbl*, unsigned int, const UCHAR*, unsigned int, UCHAR*);
 static Rtr* make_transaction(Rdb*, USHORT);
 static void mov_dsql_message(const UCHAR*, const rem_fmt*, UCHAR*, const rem_fmt*);
 static void move_error(const Arg::StatusVector& v);
@@ -1034,6 +1036,7 @@ static void receive_queued_packet(rem_port*, USHORT);
 static void receive_response(IStatus*, Rdb*, PACKET *);
 static void release_blob(Rbl*);
 static void release_event(Rvnt*);
+static void release_inline_blobs(Rtr*);
 static void release_object(IStatus*, Rdb*, P_OP, USHORT);
 static void release_request(Rrq*);
 static void release_statement(Rsr**);
@@ -1208,6 +1211,12 @@ void Blob::getInfo(CheckStatusWrapper* status,
 		rem_port* port = rdb->rdb_port;
 		RefMutexGuard portGuard(*port->port_sync, FB_FUNCTION);
 
+		if (blob->rbl_flags & Rbl::CACHED)
+		{
+			inline_blob_info(blob, itemsLength, items, bufferLength, buffer);
+			return;
+		}
+
 		info(status, rdb, op_info_blob, blob->rbl_id, 0,
 			 itemsLength, items, 0, 0, bufferLength, buffer);
 	}
@@ -1246,7 +1255,8 @@ void Blob::freeClientData(CheckStatusWrapper* status, bool force)
 
 		try
 		{
-			release_object(status, rdb, op_cancel_blob, blob->rbl_id);
+			if (!(blob->rbl_flags & Rbl::CACHED))
+				release_object(status, rdb, op_cancel_blob, blob->rbl_id);
 		}
 		catch (const Exception&)
 		{
@@ -1308,7 +1318,9 @@ void Blob::close(CheckStatusWrapper* status)
 			send_blob(status, blob, 0, NULL);
 		}
 
-		release_object(status, rdb, op_close_blob, blob->rbl_id);
+		if (!(blob->rbl_flags & Rbl::CACHED))
+			release_object(status, rdb, op_close_blob, blob->rbl_id);
+
 		release_blob(blob);
 		blob = NULL;
 	}
@@ -4173,6 +4185,7 @@ int ResultSet::fetchNext(CheckStatusWrapper* status, void* buffer)
 			sqldata->p_sqldata_blr.cstr_address = const_cast<unsigned char*>(blr);
 			sqldata->p_sqldata_message_number = 0;	// msg_type
 			sqldata->p_sqldata_messages = 0;
+			sqldata->p_sqldata_inline_blob_size = port->getPortConfig()->getMaxInlineBlobSize();
 			if (statement->rsr_select_format)
 			{
 				sqldata->p_sqldata_messages =
@@ -4935,6 +4948,24 @@ IBlob* Attachment::openBlob(CheckStatusWrapper* status, ITransaction* apiTra, IS
 
 		CHECK_LENGTH(port, bpb_length);
 
+		// Blob could be already sent by the server together with the fetched row.
+		// It's used only once and only if no filter or translation is requested.
+
+		FB_SIZE_T pos;
+		if (bpb_length <= 1 && transaction->rtr_inline_blobs.find(*id, pos))
+		{
+			Rbl* const blob = transaction->rtr_inline_blobs[pos];
+			transaction->rtr_inline_blobs.remove(pos);
+			rdb->rdb_blob_cache_size -= blob->rbl_data.getCount();
+
+			blob->rbl_next = transaction->rtr_blobs;
+			transaction->rtr_blobs = blob;
+
+			Firebird::IBlob* b = FB_NEW Blob(blob);
+			b->addRef();
+			return b;
+		}
+
 		PACKET* packet = &rdb->rdb_packet;
 		packet->p_operation = op_open_blob2;
 		P_BLOB* p_blob = &packet->p_blob;
@@ -5737,6 +5768,10 @@ int Blob::seek(CheckStatusWrapper* status, int mode, int offset)
 		rem_port* port = rdb->rdb_port;
 		RefMutexGuard portGuard(*port->port_sync, FB_FUNCTION);
 
+		// Only segmented blobs are sent inline and they can't be positioned
+		if (blob->rbl_flags & Rbl::CACHED)
+			Arg::Gds(isc_bad_segstr_type).raise();
+
 		PACKET* packet = &rdb->rdb_packet;
 		packet->p_operation = op_seek_blob;
 		P_SEEK* seek = &packet->p_seek;
@@ -6788,6 +6823,71 @@ static rem_port* analyze(ClntAuthBlock& cBlock, PathName& attach_name, unsigned
 }
 
 
+static void cache_inline_blob(Rdb* rdb, const P_INLINE_BLOB* inlineBlob)
+{
+/**************************************
+ *
+ *	c a c h e _ i n l i n e _ b l o b
+ *
+ **************************************
+ *
+ * Functional description
+ *	Keep the blob sent by the server together with
+ *	the fetched row until the user opens it. If the cache
+ *	is full, the blob is dropped and will be read from
+ *	the server as usual.
+ *
+ **************************************/
+	Rtr* transaction = rdb->rdb_transactions;
+
+	while (transaction && transaction->rtr_id != inlineBlob->p_tran_id)
+		transaction = transaction->rtr_next;
+
+	if (!transaction)
+		return;
+
+	// The blob sent again replaces the cached one, its contents could be changed since then
+
+	FB_SIZE_T pos;
+	if (transaction->rtr_inline_blobs.find(inlineBlob->p_blob_id, pos))
+	{
+		Rbl* const oldBlob = transaction->rtr_inline_blobs[pos];
+		transaction->rtr_inline_blobs.remove(pos);
+		rdb->rdb_blob_cache_size -= oldBlob->rbl_data.getCount();
+		delete oldBlob;
+	}
+
+	// Buffer length of the blob is limited to USHORT
+
+	const ULONG length = inlineBlob->p_blob_data.cstr_length;
+
+	if (length > MAX_USHORT ||
+		rdb->rdb_blob_cache_size + length > rdb->rdb_port->getPortConfig()->getMaxBlobCacheSize())
+	{
+		return;
+	}
+
+	Rbl* const blob = FB_NEW Rbl;
+	blob->rbl_rdb = rdb;
+	blob->rbl_rtr = transaction;
+	blob->rbl_id = INVALID_OBJECT;
+	blob->rbl_flags = Rbl::CACHED | Rbl::EOF_PENDING;
+	blob->rbl_blob_id = inlineBlob->p_blob_id;
+
+	memcpy(blob->rbl_info.getBuffer(inlineBlob->p_blob_info.cstr_length),
+		inlineBlob->p_blob_info.cstr_address, inlineBlob->p_blob_info.cstr_length);
+
+	// Segments are already in the form expected by getSegment()
+
+	blob->rbl_ptr = blob->rbl_buffer = blob->rbl_data.getBuffer(length);
+	blob->rbl_buffer_length = blob->rbl_length = (USHORT) length;
+	memcpy(blob->rbl_buffer, inlineBlob->p_blob_data.cstr_address, length);
+
+	transaction->rtr_inline_blobs.insert(pos, blob);
+	rdb->rdb_blob_cache_size += length;
+}
+
+
 static void clear_stmt_que(rem_port* port, Rsr* statement)
 {
 /**************************************
@@ -6907,6 +7007,14 @@ static void batch_dsql_fetch(rem_port*	port,
 			throw;
 		}
 
+		// Blobs of the row are sent before the row itself
+
+		if (packet->p_operation == op_inline_blob)
+		{
+			cache_inline_blob(rdb, &packet->p_inline_blob);
+			continue;
+		}
+
 		if (packet->p_operation != op_fetch_response)
 		{
 			statement->rsr_flags.set(Rsr::STREAM_ERR);
@@ -7667,6 +7775,76 @@ static void init(CheckStatusWrapper* status, ClntAuthBlock& cBlock, rem_port* po
 }
 
 
+static void inline_blob_info(const Rbl* blob, unsigned int itemsLength, const UCHAR* items,
+	unsigned int bufferLength, UCHAR* buffer)
+{
+/**************************************
+ *
+ *	i n l i n e _ b l o b _ i n f o
+ *
+ **************************************
+ *
+ * Functional description
+ *	Provide information on the cached blob using the info
+ *	response sent by the server together with the blob.
+ *
+ **************************************/
+	const UCHAR* const cached = blob->rbl_info.begin();
+	const UCHAR* const cachedEnd = blob->rbl_info.end();
+
+	const UCHAR* const itemsEnd = items + itemsLength;
+	UCHAR* ptr = buffer;
+	const UCHAR* const end = buffer + bufferLength;
+
+	while (items < itemsEnd && *items != isc_info_end)
+	{
+		const UCHAR item = *items++;
+
+		// Find the item in the server response
+
+		const UCHAR* p = cached;
+		while (p + 3 <= cachedEnd && *p != isc_info_end && *p != item)
+			p += 3 + gds__vax_integer(p + 1, 2);
+
+		UCHAR unknown[7];
+		const UCHAR* data = unknown;
+		ULONG length;
+
+		if (p + 3 <= cachedEnd && *p == item)
+		{
+			length = 3 + gds__vax_integer(p + 1, 2);
+			data = p;
+		}
+		else
+		{
+			// Server would answer the same way to the item it does not know
+
+			unknown[0] = isc_info_error;
+			unknown[1] = 4;
+			unknown[2] = 0;
+			unknown[3] = (UCHAR) isc_infunk;
+			unknown[4] = (UCHAR) (isc_infunk >> 8);
+			unknown[5] = (UCHAR) (isc_infunk >> 16);
+			unknown[6] = (UCHAR) (isc_infunk >> 24);
+			length = sizeof(unknown);
+		}
+
+		if (ptr + length >= end)
+		{
+			if (ptr < end)
+				*ptr++ = isc_info_truncated;
+			return;
+		}
+
+		memcpy(ptr, data, length);
+		ptr += length;
+	}
+
+	if (ptr < end)
+		*ptr++ = isc_info_end;
+}
+
+
 static Rtr* make_transaction( Rdb* rdb, USHORT id)
 {
 /**************************************
@@ -8184,6 +8362,31 @@ static void release_event( Rvnt* event)
 }
 
 
+static void release_inline_blobs(Rtr* transaction)
+{
+/**************************************
+ *
+ *	r e l e a s e _ i n l i n e _ b l o b s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Release the blobs received inline and never opened.
+ *
+ **************************************/
+	Rdb* rdb = transaction->rtr_rdb;
+
+	for (Rbl** iter = transaction->rtr_inline_blobs.begin();
+		 iter != transaction->rtr_inline_blobs.end(); ++iter)
+	{
+		rdb->rdb_blob_cache_size -= (*iter)->rbl_data.getCount();
+		delete *iter;
+	}
+
+	transaction->rtr_inline_blobs.clear();
+}
+
+
 static void release_object(IStatus* status, Rdb* rdb, P_OP op, USHORT id)
 {
 /**************************************
@@ -8312,6 +8515,8 @@ static void release_transaction( Rtr* transaction)
 	while (transaction->rtr_blobs)
 		release_blob(transaction->rtr_blobs);
 
+	release_inline_blobs(transaction);
+
 	for (Rtr** p = &rdb->rdb_transactions; *p; p = &(*p)->rtr_next)
 	{
 		if (*p == transaction)
@@ -95,6 +95,11 @@
 #include <sys/select.h>
 #endif
 
+#if defined(HAVE_POLL) && defined(HAVE_SYS_EPOLL_H)
+#include <sys/epoll.h>
+#define USE_EPOLL
+#endif
+
 #endif // !WIN_NT
 
 const int INET_RETRY_CALL = 5;
@@ -289,20 +294,8 @@ public:
 	// assume port_mutex is locked
 	HandleState checkNext(RemPortPtr& port)
 	{
-#ifdef WIRE_COMPRESS_SUPPORT
-		if (slct_zport)
-		{
-			if (slct_zport->port_z_data &&
-				(slct_zport->port_state != rem_port::DISCONNECTED))
-			{
-				port = slct_zport;
-				slct_zport = nullptr;	// Will be set again by select_multi() if needed
-				return SEL_READY;
-			}
-
-			slct_zport = nullptr;
-		}
-#endif
+		if (checkZData(port))
+			return SEL_READY;
 
 		if (slct_port && slct_port->port_state == rem_port::DISCONNECTED)
 		{
@@ -478,7 +471,27 @@ public:
 
 	time_t	slct_time;
 
-private:
+protected:
+	// return the port with some compressed data remaining in the buffer
+	bool checkZData(RemPortPtr& port)
+	{
+#ifdef WIRE_COMPRESS_SUPPORT
+		if (slct_zport)
+		{
+			if (slct_zport->port_z_data &&
+				(slct_zport->port_state != rem_port::DISCONNECTED))
+			{
+				port = slct_zport;
+				slct_zport = nullptr;	// Will be set again by select_multi() if needed
+				return true;
+			}
+
+			slct_zport = nullptr;
+		}
+#endif
+		return false;
+	}
+
 	int		slct_count;
 #ifdef HAVE_POLL
 	class PollToFD
@@ -501,6 +514,326 @@ private:
 #endif
 };
 
+// Select used by the dispatch loop of multi-client server.
+//
+// If epoll is available, the socket of the port is registered in the epoll
+// set when the port gets it and stays there until the socket is closed, the
+// set is level-triggered just like poll(). The dispatch loop does not walk
+// the ports then, it checks only the sockets reported as ready by the kernel
+// and, once a second at most, expires keepalive timers of the ports. If epoll
+// can't be used, the loop falls back to poll() of all ports.
+
+class DispatchSelect : public Select
+{
+#ifdef USE_EPOLL
+	static const int SEL_EPOLL_EVENTS = EPOLLIN;
+	static const int SEL_EPOLL_READY = EPOLLIN | EPOLLHUP | EPOLLERR;
+	static const int SEL_EPOLL_BATCH = 64;
+
+	struct WatchedSocket
+	{
+		SOCKET fd;
+		rem_port* port;		// owner of the socket
+	};
+
+	struct ActiveSocket
+	{
+		SOCKET fd;
+		bool ready;			// reported by the kernel, else keepalive timer has expired
+	};
+
+	class WatchedToFD
+	{
+	public:
+		static SOCKET generate(const WatchedSocket& w) { return w.fd; };
+	};
+
+	class ActiveToFD
+	{
+	public:
+		static SOCKET generate(const ActiveSocket& a) { return a.fd; };
+	};
+#endif
+
+public:
+	explicit DispatchSelect(Firebird::MemoryPool& pool)
+		: Select(pool)
+#ifdef USE_EPOLL
+		  , slct_epoll(-1), slct_state(EPOLL_UNKNOWN), slct_watched(pool), slct_active(pool),
+		  slct_next(0)
+#endif
+	{ }
+
+	~DispatchSelect()
+	{
+#ifdef USE_EPOLL
+		if (slct_epoll >= 0)
+			close(slct_epoll);
+#endif
+	}
+
+#ifdef USE_EPOLL
+	// Returns true if the ports are waited for using epoll
+	bool isEpoll()
+	{
+		MutexLockGuard guard(slct_mutex, FB_FUNCTION);
+		return init();
+	}
+
+	// The port got its socket, start waiting for it.
+	// Called by any thread.
+	void watch(rem_port* port)
+	{
+		MutexLockGuard guard(slct_mutex, FB_FUNCTION);
+
+		const SOCKET handle = port->port_handle;
+
+		if (!init() || handle == INVALID_SOCKET)
+			return;
+
+		FB_SIZE_T pos;
+		if (slct_watched.find(handle, pos))
+		{
+			if (slct_watched[pos].port == port)
+				return;
+
+			// The socket number was not forgotten when closed
+			slct_watched[pos].port = port;
+		}
+		else
+		{
+			WatchedSocket watched;
+			watched.fd = handle;
+			watched.port = port;
+			slct_watched.insert(pos, watched);
+		}
+
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = SEL_EPOLL_EVENTS;
+		ev.data.fd = handle;
+
+		int rc = epoll_ctl(slct_epoll, EPOLL_CTL_ADD, handle, &ev);
+
+		if (rc < 0 && errno == EEXIST)
+			rc = epoll_ctl(slct_epoll, EPOLL_CTL_MOD, handle, &ev);
+
+		if (rc < 0)
+		{
+			slct_watched.remove(pos);
+
+			// Socket closed meanwhile, there is nothing to wait for
+			if (errno == EBADF)
+				return;
+
+			// The dispatch loop switches to poll() after the current wait
+			gds__log("INET/select: epoll_ctl failed, errno = %d, using poll()", errno);
+			slct_state = EPOLL_FAILED;
+		}
+	}
+
+	// The socket is going to be closed, stop waiting for it.
+	// Called by any thread.
+	void forget(SOCKET handle)
+	{
+		MutexLockGuard guard(slct_mutex, FB_FUNCTION);
+
+		FB_SIZE_T pos;
+		if (slct_epoll >= 0 && slct_watched.find(handle, pos))
+		{
+			epoll_ctl(slct_epoll, EPOLL_CTL_DEL, handle, NULL);
+			slct_watched.remove(pos);
+		}
+	}
+
+	bool hasWatched()
+	{
+		MutexLockGuard guard(slct_mutex, FB_FUNCTION);
+		return slct_watched.hasData();
+	}
+
+	// The keepalive timer of the port has expired, check it after the wait
+	void setExpired(const rem_port* port)
+	{
+		FB_SIZE_T pos;
+		if (!slct_active.find(port->port_handle, pos))
+		{
+			ActiveSocket active;
+			active.fd = port->port_handle;
+			active.ready = false;
+			slct_active.insert(pos, active);
+		}
+	}
+
+	void checkStart(RemPortPtr& port)
+	{
+		Select::checkStart(port);
+		slct_next = 0;
+	}
+
+	HandleState checkNext(RemPortPtr& port)
+	{
+		if (slct_epoll < 0)
+			return Select::checkNext(port);
+
+		if (checkZData(port))
+			return SEL_READY;
+
+		while (slct_next < slct_active.getCount())
+		{
+			const ActiveSocket& active = slct_active[slct_next++];
+
+			{ // scope
+				MutexLockGuard guard(slct_mutex, FB_FUNCTION);
+
+				// The socket is forgotten before its port is released
+				FB_SIZE_T pos;
+				if (!slct_watched.find(active.fd, pos))
+					continue;
+
+				port = slct_watched[pos].port;
+			}
+
+			// poll() is not asked about such ports, don't let them be reported again
+			if (port->port_state != rem_port::PENDING)
+			{
+				forget(active.fd);
+				continue;
+			}
+
+#ifdef WIRE_COMPRESS_SUPPORT
+			if (port->port_z_data)
+				return SEL_READY;
+#endif
+			return active.ready ? SEL_READY : SEL_NO_DATA;
+		}
+
+		port = nullptr;
+		return SEL_NO_DATA;
+	}
+
+	void unset(SOCKET handle)
+	{
+		if (slct_epoll < 0)
+			Select::unset(handle);
+	}
+
+	void clear()
+	{
+		Select::clear();
+		slct_active.clear();
+		slct_next = 0;
+	}
+
+	void select(timeval* timeout)
+	{
+		if (slct_epoll < 0)
+		{
+			Select::select(timeout);
+			return;
+		}
+
+		if (slct_state == EPOLL_FAILED)
+		{
+			// Nothing is ready, the next wait is done using poll()
+			fallbackToPoll();
+			slct_count = 0;
+			return;
+		}
+
+		struct epoll_event events[SEL_EPOLL_BATCH];
+		const int milliseconds = timeout ? timeout->tv_sec * 1000 + timeout->tv_usec / 1000 : -1;
+		const int n = epoll_wait(slct_epoll, events, SEL_EPOLL_BATCH, milliseconds);
+
+		if (n < 0)
+		{
+			slct_count = -1;
+			return;
+		}
+
+		for (int i = 0; i < n; i++)
+		{
+			if (!(events[i].events & SEL_EPOLL_READY))
+				continue;
+
+			FB_SIZE_T pos;
+			if (slct_active.find(events[i].data.fd, pos))
+				slct_active[pos].ready = true;
+			else
+			{
+				ActiveSocket active;
+				active.fd = events[i].data.fd;
+				active.ready = true;
+				slct_active.insert(pos, active);
+			}
+		}
+
+		slct_count = n;
+	}
+
+private:
+	enum EpollState {EPOLL_UNKNOWN, EPOLL_USED, EPOLL_FAILED, EPOLL_NONE};
+
+	// Create epoll set on first use, assume slct_mutex is locked
+	bool init()
+	{
+		if (slct_state == EPOLL_UNKNOWN)
+		{
+			slct_epoll = epoll_create1(EPOLL_CLOEXEC);
+
+			if (slct_epoll >= 0)
+				slct_state = EPOLL_USED;
+			else
+			{
+				gds__log("INET/select: epoll_create1 failed, errno = %d, using poll()", errno);
+				slct_state = EPOLL_NONE;
+			}
+		}
+
+		return slct_state == EPOLL_USED;
+	}
+
+	// Wait for the ports using poll() from now on
+	void fallbackToPoll()
+	{
+		MutexLockGuard guard(slct_mutex, FB_FUNCTION);
+
+		close(slct_epoll);
+		slct_epoll = -1;
+		slct_state = EPOLL_NONE;
+		slct_watched.clear();
+		slct_active.clear();
+	}
+
+	Firebird::Mutex slct_mutex;	// protects the members below except slct_active and slct_next
+	int		slct_epoll;			// epoll descriptor, -1 if poll() is used
+	EpollState slct_state;
+	SortedArray<WatchedSocket, InlineStorage<WatchedSocket, 8>, SOCKET, WatchedToFD>  slct_watched;
+	SortedArray<ActiveSocket, InlineStorage<ActiveSocket, 8>, SOCKET, ActiveToFD>  slct_active;
+	FB_SIZE_T slct_next;		// next socket of slct_active to check
+#else
+public:
+	bool isEpoll()
+	{
+		return false;
+	}
+
+	void watch(rem_port*)
+	{ }
+
+	void forget(SOCKET)
+	{ }
+
+	bool hasWatched()
+	{
+		return false;
+	}
+
+	void setExpired(const rem_port*)
+	{ }
+#endif
+};
+
 static bool		accept_connection(rem_port*, const P_CNCT*);
 #ifdef HAVE_SETITIMER
 static void		alarm_handler(int);
@@ -565,9 +898,9 @@ static bool		packet_send(rem_port*, const SCHAR*, SSHORT);
 static rem_port*		receive(rem_port*, PACKET *);
 static rem_port*		select_accept(rem_port*);
 
-static void		select_port(rem_port*, Select*, RemPortPtr&);
+static void		select_port(rem_port*, DispatchSelect*, RemPortPtr&);
 static bool		select_multi(rem_port*, UCHAR* buffer, SSHORT bufsize, SSHORT* length, RemPortPtr&);
-static bool		select_wait(rem_port*, Select*);
+static bool		select_wait(rem_port*, DispatchSelect*);
 static int		send_full(rem_port*, PACKET *);
 static int		send_partial(rem_port*, PACKET *);
 
@@ -617,7 +950,7 @@ ULONG INET_remote_buffer;
 static GlobalPtr<Mutex> init_mutex;
 static volatile bool INET_initialized = false;
 static volatile bool INET_shutting_down = false;
-static Firebird::GlobalPtr<Select> INET_select;
+static Firebird::GlobalPtr<DispatchSelect> INET_select;
 static rem_port* inet_async_receive = NULL;
 
 
@@ -715,7 +1048,8 @@ rem_port* INET_analyze(ClntAuthBlock* cBlock,
 		REMOTE_PROTOCOL(PROTOCOL_VERSION13, ptype_lazy_send, 4),
 		REMOTE_PROTOCOL(PROTOCOL_VERSION14, ptype_lazy_send, 5),
 		REMOTE_PROTOCOL(PROTOCOL_VERSION15, ptype_lazy_send, 6),
-		REMOTE_PROTOCOL(PROTOCOL_VERSION16, ptype_lazy_send, 7)
+		REMOTE_PROTOCOL(PROTOCOL_VERSION16, ptype_lazy_send, 7),
+		REMOTE_PROTOCOL(PROTOCOL_VERSION17, ptype_lazy_send, 8)
 	};
 	fb_assert(FB_NELEM(protocols_to_try) <= FB_NELEM(cnct->p_cnct_versions));
 	cnct->p_cnct_count = FB_NELEM(protocols_to_try);
@@ -1538,6 +1872,8 @@ static rem_port* aux_connect(rem_port* port, PACKET* packet)
 		port->port_handle = n;
 		port->port_flags |= PORT_async;
 
+		INET_select->watch(port);
+
 		get_peer_info(port);
 
 		return port;
@@ -1796,6 +2132,9 @@ static void disconnect(rem_port* port)
 
 	inet_ports->unRegisterPort(port);
 
+	if (port->port_handle != INVALID_SOCKET)
+		INET_select->forget(port->port_handle);
+
 	if (delayClose)
 	{
 		if (port->port_handle != INVALID_SOCKET)
@@ -1853,6 +2192,7 @@ static void force_close(rem_port* port)
 
 	if (port->port_handle != INVALID_SOCKET)
 	{
+		INET_select->forget(port->port_handle);
 		shutdown(port->port_handle, 2);
 		SOCLOSE(port->port_handle);
 	}
@@ -2101,6 +2441,7 @@ static bool select_multi(rem_port* main_port, UCHAR* buffer, SSHORT bufsize, SSH
 				{
 					main_port->port_state = rem_port::BROKEN;
 
+					INET_select->forget(main_port->port_handle);
 					shutdown(main_port->port_handle, 2);
 					SOCLOSE(main_port->port_handle);
 				}
@@ -2179,6 +2520,8 @@ static rem_port* select_accept( rem_port* main_port)
 
 	port->port_flags |= PORT_server;
 
+	INET_select->watch(port);
+
 	if (main_port->port_server_flags & SRVR_thread_per_port)
 	{
 		port->port_server_flags = (SRVR_server | SRVR_inet | SRVR_thread_per_port);
@@ -2188,7 +2531,7 @@ static rem_port* select_accept( rem_port* main_port)
 	return 0;
 }
 
-static void select_port(rem_port* main_port, Select* selct, RemPortPtr& port)
+static void select_port(rem_port* main_port, DispatchSelect* selct, RemPortPtr& port)
 {
 /**************************************
  *
@@ -2238,7 +2581,7 @@ static void select_port(rem_port* main_port, Select* selct, RemPortPtr& port)
 	}
 }
 
-static bool select_wait( rem_port* main_port, Select* selct)
+static bool select_wait( rem_port* main_port, DispatchSelect* selct)
 {
 /**************************************
  *
@@ -2284,62 +2627,90 @@ static bool select_wait( rem_port* main_port, Select* selct)
 				SOCLOSE(s);
 			}
 
-			for (rem_port* port = main_port; port; port = port->port_next)
+			if (selct->isEpoll())
 			{
-				if (port->port_state == rem_port::PENDING &&
-					// don't wait on still listening (not connected) async port
-					!(port->port_handle == INVALID_SOCKET && (port->port_flags & PORT_async)))
- 				{
-					// Adjust down the port's keepalive timer.
+				// Sockets of other ports are registered when the ports get them,
+				// only expire the keepalive timers here
+
+				if (INET_shutting_down)
+					selct->forget(main_port->port_handle);
+				else if (main_port->port_state == rem_port::PENDING)
+					selct->watch(main_port);
 
-					if (port->port_dummy_packet_interval)
+				for (rem_port* port = main_port; delta_time && port; port = port->port_next)
+				{
+					if (port->port_state == rem_port::PENDING && port->port_dummy_packet_interval &&
+						port->port_handle != INVALID_SOCKET)
 					{
 						port->port_dummy_timeout -= delta_time;
+
+						if (port->port_dummy_timeout < 0)
+							selct->setExpired(port);
 					}
+				}
 
-					if (checkPorts)
+				found = selct->hasWatched();
+			}
+			else
+			{
+				for (rem_port* port = main_port; port; port = port->port_next)
+				{
+					if (port->port_state == rem_port::PENDING &&
+						// don't wait on still listening (not connected) async port
+						!(port->port_handle == INVALID_SOCKET && (port->port_flags & PORT_async)))
 					{
-						// select() returned EBADF\WSAENOTSOCK - we have a broken socket
-						// in current fdset. Search and return it to caller to close
-						// broken connection correctly
+						// Adjust down the port's keepalive timer.
+
+						if (port->port_dummy_packet_interval)
+						{
+							port->port_dummy_timeout -= delta_time;
+						}
 
-						struct linger lngr;
-						socklen_t optlen = sizeof(lngr);
-						const bool badSocket =
+						if (checkPorts)
+						{
+							// select() returned EBADF\WSAENOTSOCK - we have a broken socket
+							// in current fdset. Search and return it to caller to close
+							// broken connection correctly
+
+							struct linger lngr;
+							socklen_t optlen = sizeof(lngr);
+							const bool badSocket =
 #ifdef WIN_NT
-							false;
+								false;
 #else
-							(port->port_handle < 0 || port->port_handle >= FD_SETSIZE);
+								(port->port_handle < 0 || port->port_handle >= FD_SETSIZE);
 #endif
 
-						if (badSocket || getsockopt(port->port_handle,
-								SOL_SOCKET, SO_LINGER, (SCHAR*) &lngr, &optlen) != 0)
-						{
-							if (badSocket || INET_ERRNO == NOTASOCKET)
+							if (badSocket || getsockopt(port->port_handle,
+									SOL_SOCKET, SO_LINGER, (SCHAR*) &lngr, &optlen) != 0)
 							{
-								// not a socket, strange !
-								gds__log("INET/select_wait: found \"not a socket\" socket : %" HANDLEFORMAT,
-										 port->port_handle);
-
-								// this will lead to receive() which will break bad connection
-								selct->clear();
-								if (!badSocket)
+								if (badSocket || INET_ERRNO == NOTASOCKET)
 								{
-									selct->set(port->port_handle);
+									// not a socket, strange !
+									gds__log("INET/select_wait: found \"not a socket\" socket : %" HANDLEFORMAT,
+											 port->port_handle);
+
+									// this will lead to receive() which will break bad connection
+									selct->clear();
+									if (!badSocket)
+									{
+										selct->set(port->port_handle);
+									}
+									return true;
 								}
-								return true;
 							}
 						}
-					}
 
-					// if process is shuting down - don't listen on main port
-					if (!INET_shutting_down || port != main_port)
-					{
-						selct->set(port->port_handle);
-						found = true;
+						// if process is shuting down - don't listen on main port
+						if (!INET_shutting_down || port != main_port)
+						{
+							selct->set(port->port_handle);
+							found = true;
+						}
 					}
 				}
 			}
+
 			checkPorts = false;
 		} // port_mutex scope
 
@@ -2383,7 +2754,7 @@ static bool select_wait( rem_port* main_port, Select* selct)
 				// bit as this value is undefined on some platforms (eg. HP-UX),
 				// when the select call times out. Once these bits are cleared
 				// they can be used in select_port()
-				if (selct->getCount() == 0)
+				if (selct->getCount() == 0 && !selct->isEpoll())
 				{
 					MutexLockGuard guard(port_mutex, FB_FUNCTION);
 					for (rem_port* port = main_port; port; port = port->port_next)
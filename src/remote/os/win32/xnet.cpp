@@ -305,7 +305,8 @@ rem_port* XNET_analyze(ClntAuthBlock* cBlock,
 		REMOTE_PROTOCOL(PROTOCOL_VERSION13, ptype_batch_send, 4),
 		REMOTE_PROTOCOL(PROTOCOL_VERSION14, ptype_batch_send, 5),
 		REMOTE_PROTOCOL(PROTOCOL_VERSION15, ptype_batch_send, 6),
-		REMOTE_PROTOCOL(PROTOCOL_VERSION16, ptype_batch_send, 7)
+		REMOTE_PROTOCOL(PROTOCOL_VERSION16, ptype_batch_send, 7),
+		REMOTE_PROTOCOL(PROTOCOL_VERSION17, ptype_batch_send, 8)
 	};
 	fb_assert(FB_NELEM(protocols_to_try) <= FB_NELEM(cnct->p_cnct_versions));
 	cnct->p_cnct_count = FB_NELEM(protocols_to_try);
@@ -710,6 +710,15 @@ bool_t xdr_protocol(RemoteXdr* xdrs, PACKET* p)
 		}
 		MAP(xdr_short, reinterpret_cast<SSHORT&>(sqldata->p_sqldata_message_number));
 		MAP(xdr_short, reinterpret_cast<SSHORT&>(sqldata->p_sqldata_messages));
+		{ // scope
+			rem_port* port = xdrs->x_public;
+			if (port->port_protocol >= PROTOCOL_INLINE_BLOB)
+			{
+				MAP(xdr_u_long, sqldata->p_sqldata_inline_blob_size);
+			}
+			else if (xdrs->x_op == XDR_DECODE)
+				sqldata->p_sqldata_inline_blob_size = 0;
+		}
 		DEBUG_PRINTSIZE(xdrs, p->p_operation);
 		return P_TRUE(xdrs, p);
 
@@ -1115,6 +1124,18 @@ bool_t xdr_protocol(RemoteXdr* xdrs, PACKET* p)
 			return P_TRUE(xdrs, p);
 		}
 
+	case op_inline_blob:
+		{
+			P_INLINE_BLOB* b = &p->p_inline_blob;
+			MAP(xdr_short, reinterpret_cast<SSHORT&>(b->p_tran_id));
+			MAP(xdr_quad, b->p_blob_id);
+			MAP(xdr_cstring, b->p_blob_info);
+			MAP(xdr_cstring, b->p_blob_data);
+			DEBUG_PRINTSIZE(xdrs, p->p_operation);
+
+			return P_TRUE(xdrs, p);
+		}
+
 	///case op_insert:
 	default:
 #ifdef DEV_BUILD
@@ -93,6 +93,12 @@ const USHORT PROTOCOL_VERSION15 = (FB_PROTOCOL_FLAG | 15);
 const USHORT PROTOCOL_VERSION16 = (FB_PROTOCOL_FLAG | 16);
 const USHORT PROTOCOL_STMT_TOUT = PROTOCOL_VERSION16;
 
+// Protocol 17:
+//	- supports blobs sent inline with the fetched rows (op_inline_blob)
+
+const USHORT PROTOCOL_VERSION17 = (FB_PROTOCOL_FLAG | 17);
+const USHORT PROTOCOL_INLINE_BLOB = PROTOCOL_VERSION17;
+
 // Architecture types
 
 enum P_ARCH
@@ -290,6 +296,8 @@ enum P_OP
 
 	op_batch_cancel			= 109,
 
+	op_inline_blob			= 110,	// Blob of the fetched row sent before the row itself
+
 	op_max
 };
 
@@ -598,6 +606,7 @@ typedef struct p_sqldata
     USHORT	p_sqldata_out_message_number;
     ULONG	p_sqldata_status;			// final eof status
 	ULONG	p_sqldata_timeout;			// statement timeout
+	ULONG	p_sqldata_inline_blob_size;	// max size of blobs to be sent inline with fetched rows
 } P_SQLDATA;
 
 typedef struct p_sqlfree
@@ -716,6 +725,17 @@ typedef struct p_batch_setbpb
 } P_BATCH_SETBPB;
 
 
+// Inline blobs support
+
+typedef struct p_inline_blob
+{
+	OBJCT			p_tran_id;			// transaction object
+	SQUAD			p_blob_id;			// blob id
+	CSTRING			p_blob_info;		// blob info response
+	CSTRING			p_blob_data;		// segments, each prefixed with two bytes length
+} P_INLINE_BLOB;
+
+
 // Replication support
 
 typedef struct p_replicate
@@ -777,6 +797,7 @@ typedef struct packet
 	P_BATCH_REGBLOB p_batch_regblob;	// Register already existing BLOB in batch
 	P_BATCH_SETBPB p_batch_setbpb;		// Set default BPB for batch
 	P_REPLICATE p_replicate;	// replicate
+	P_INLINE_BLOB p_inline_blob;	// Blob sent inline with fetched rows
 
 public:
 	packet()
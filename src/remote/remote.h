@@ -169,6 +169,7 @@ struct Rdb : public Firebird::GlobalStorage, public TypedHandle<rem_type_rdb>
 	struct Rvnt*	rdb_events;				// known events
 	struct Rsr*		rdb_sql_requests;		// SQL requests
 	PACKET			rdb_packet;				// Communication structure
+	ULONG			rdb_blob_cache_size;	// Total size of cached inline blobs
 	USHORT			rdb_id;
 
 private:
@@ -181,7 +182,7 @@ public:
 	Rdb() :
 		rdb_iface(NULL), rdb_port(0),
 		rdb_transactions(0), rdb_requests(0), rdb_events(0), rdb_sql_requests(0),
-		rdb_id(0), rdb_async_thread_id(0)
+		rdb_blob_cache_size(0), rdb_id(0), rdb_async_thread_id(0)
 	{
 	}
 
@@ -189,6 +190,28 @@ public:
 };
 
 
+struct Rbl;
+
+// Blobs received inline with the fetched rows are ordered by blob id
+
+class InlineBlobId
+{
+public:
+	static const ISC_QUAD& generate(const Rbl* blob);
+
+	static bool greaterThan(const ISC_QUAD& i1, const ISC_QUAD& i2)
+	{
+		if (i1.gds_quad_high != i2.gds_quad_high)
+			return i1.gds_quad_high > i2.gds_quad_high;
+
+		return i1.gds_quad_low > i2.gds_quad_low;
+	}
+};
+
+typedef Firebird::SortedArray<Rbl*, Firebird::EmptyStorage<Rbl*>, ISC_QUAD,
+	InlineBlobId, InlineBlobId> InlineBlobs;
+
+
 struct Rtr : public Firebird::GlobalStorage, public TypedHandle<rem_type_rtr>
 {
 	Rdb*			rtr_rdb;
@@ -199,13 +222,14 @@ struct Rtr : public Firebird::GlobalStorage, public TypedHandle<rem_type_rtr>
 	bool			rtr_limbo;
 
 	Firebird::Array<Rsr*> rtr_cursors;
+	InlineBlobs		rtr_inline_blobs;	// Blobs received with fetched rows, not opened yet
 	Rtr**			rtr_self;
 
 public:
 	Rtr() :
 		rtr_rdb(0), rtr_next(0), rtr_blobs(0),
 		rtr_iface(NULL), rtr_id(0), rtr_limbo(0),
-		rtr_cursors(getPool()), rtr_self(NULL)
+		rtr_cursors(getPool()), rtr_inline_blobs(getPool()), rtr_self(NULL)
 	{ }
 
 	~Rtr()
@@ -221,6 +245,8 @@ public:
 struct Rbl : public Firebird::GlobalStorage, public TypedHandle<rem_type_rbl>
 {
 	Firebird::HalfStaticArray<UCHAR, BLOB_LENGTH> rbl_data;
+	Firebird::UCharBuffer rbl_info;	// Info response of the cached blob
+	ISC_QUAD	rbl_blob_id;		// Blob id of the cached blob
 	Rdb*		rbl_rdb;
 	Rtr*		rbl_rtr;
 	Rbl*		rbl_next;
@@ -243,12 +269,13 @@ public:
 		EOF_SET = 1,
 		SEGMENT = 2,
 		EOF_PENDING = 4,
-		CREATE = 8
+		CREATE = 8,
+		CACHED = 16		// Blob was sent inline, there is no server object
 	};
 
 public:
 	Rbl() :
-		rbl_data(getPool()), rbl_rdb(0), rbl_rtr(0), rbl_next(0),
+		rbl_data(getPool()), rbl_info(getPool()), rbl_blob_id(), rbl_rdb(0), rbl_rtr(0), rbl_next(0),
 		rbl_buffer(rbl_data.getBuffer(BLOB_LENGTH)), rbl_ptr(rbl_buffer), rbl_iface(NULL),
 		rbl_offset(0), rbl_id(0), rbl_flags(0),
 		rbl_buffer_length(BLOB_LENGTH), rbl_length(0), rbl_fragment_length(0),
@@ -267,6 +294,11 @@ public:
 	static ISC_STATUS badHandle() { return isc_bad_segstr_handle; }
 };
 
+inline const ISC_QUAD& InlineBlobId::generate(const Rbl* blob)
+{
+	return blob->rbl_blob_id;
+}
+
 
 struct Rvnt : public Firebird::GlobalStorage, public TypedHandle<rem_type_rev>
 {
@@ -1336,6 +1368,7 @@ public:
 	ISC_STATUS	execute_immediate(P_OP, P_SQLST*, PACKET*);
 	ISC_STATUS	execute_statement(P_OP, P_SQLDATA*, PACKET*);
 	ISC_STATUS	fetch(P_SQLDATA*, PACKET*);
+	bool		send_inline_blob(Rsr*, const ISC_QUAD&, ULONG);
 	ISC_STATUS	get_segment(P_SGMT*, PACKET*);
 	ISC_STATUS	get_slice(P_SLC*, PACKET*);
 	void		info(P_OP, P_INFO*, PACKET*);
@@ -34,6 +34,8 @@
 #include "../common/classes/ClumpletWriter.h"
 #include "../common/ThreadStart.h"
 #include "../common/utils_proto.h"
+#include "../common/classes/condition.h"
+#include "../common/classes/Hash.h"
 #include "../common/classes/ParsedList.h"
 
 #include "../jrd/replication/Applier.h"
@@ -73,7 +75,8 @@ namespace
 	const char CTL_SIGNATURE[] = "FBREPLCTL";
 
 	const USHORT CTL_VERSION1 = 1;
-	const USHORT CTL_CURRENT_VERSION = CTL_VERSION1;
+	const USHORT CTL_VERSION2 = 2;	// list of committed transactions is added
+	const USHORT CTL_CURRENT_VERSION = CTL_VERSION2;
 
 	volatile bool* shutdownPtr = NULL;
 	AtomicCounter activeThreads;
@@ -131,13 +134,21 @@ namespace
 			FB_UINT64 db_sequence;
 		};
 
-		typedef DataV1 Data;
+		struct DataV2 : public DataV1
+		{
+			ULONG com_count;	// transactions committed at or after the offset
+		};
+
+		typedef DataV2 Data;
 
 	public:
 		ControlFile(const PathName& directory,
 					const Guid& guid, FB_UINT64 sequence,
-					TransactionList& transactions)
-			: AutoFile(init(directory, guid))
+					TransactionList& transactions,
+					TransactionList& committed)
+			: AutoFile(init(directory, guid)),
+			  m_transactions(*getDefaultMemoryPool()),
+			  m_committed(*getDefaultMemoryPool())
 		{
 			char guidStr[GUID_BUFF_SIZE];
 			GuidToString(guidStr, &guid);
@@ -183,24 +194,29 @@ namespace
 					raiseError("Control file %s appears corrupted", filename.c_str());
 
 				if (strcmp(m_data.signature, CTL_SIGNATURE) ||
-					(m_data.version != CTL_VERSION1))
+					(m_data.version != CTL_VERSION1 && m_data.version != CTL_VERSION2))
 				{
 					raiseError("Control file %s appears corrupted", filename.c_str());
 				}
 
-				ActiveTransaction* const ptr =
-					m_data.txn_count ? transactions.getBuffer(m_data.txn_count) : NULL;
-				const ULONG txn_size = m_data.txn_count * sizeof(ActiveTransaction);
-
-				if (txn_size)
+				if (m_data.version == CTL_VERSION2)
 				{
-					if (read(m_handle, ptr, txn_size) != txn_size)
+					const ULONG extra_size = sizeof(DataV2) - sizeof(DataV1);
+					if (read(m_handle, (UCHAR*) &m_data + sizeof(DataV1), extra_size) != extra_size)
 						raiseError("Control file %s appears corrupted", filename.c_str());
 				}
+
+				readList(filename, m_data.txn_count, transactions);
+				readList(filename, m_data.version == CTL_VERSION2 ? m_data.com_count : 0, committed);
+
+				m_data.version = CTL_CURRENT_VERSION;
 			}
 			else
 				raiseError("Control file %s appears corrupted", filename.c_str());
 
+			m_transactions.assign(transactions);
+			m_committed.assign(committed);
+
 			flush();
 		}
 
@@ -237,56 +253,40 @@ namespace
 			flush();
 		}
 
-		void savePartial(FB_UINT64 sequence, ULONG offset, const TransactionList& transactions)
+		// The position never goes back, the blocks before it are re-applied after restart
+		// only for the listed active transactions. Committed transactions are skipped
+		// wherever their blocks are.
+		void savePartial(FB_UINT64 sequence, ULONG offset,
+						 const TransactionList& transactions, const TransactionList& committed)
 		{
 			bool update = false;
 
 			if (sequence > m_data.sequence)
 			{
 				m_data.sequence = sequence;
-				fb_assert(!m_data.offset);
 				m_data.offset = offset;
 				update = true;
 			}
-			else if (sequence == m_data.sequence && offset > m_data.offset)
+			else if (sequence == m_data.sequence && m_data.offset && offset > m_data.offset)
 			{
 				m_data.offset = offset;
 				update = true;
 			}
 
-			if (update)
-			{
-				m_data.txn_count = (ULONG) transactions.getCount();
-
-				const ULONG txn_size = m_data.txn_count * sizeof(ActiveTransaction);
-
-				lseek(m_handle, 0, SEEK_SET);
-				if (write(m_handle, &m_data, sizeof(Data)) != sizeof(Data))
-					raiseError("Control file write failed (error: %d)", ERRNO);
-				if (write(m_handle, transactions.begin(), txn_size) != txn_size)
-					raiseError("Control file write failed (error: %d)", ERRNO);
-				flush();
-			}
+			if (update || !isEqual(transactions, m_transactions) || !isEqual(committed, m_committed))
+				save(transactions, committed);
 		}
 
-		void saveComplete(FB_UINT64 sequence, const TransactionList& transactions)
+		void saveComplete(FB_UINT64 sequence,
+						  const TransactionList& transactions, const TransactionList& committed)
 		{
 			if (sequence >= m_data.sequence)
 			{
 				m_data.sequence = sequence;
 				m_data.offset = 0;
-
-				m_data.txn_count = (ULONG) transactions.getCount();
-
-				const ULONG txn_size = m_data.txn_count * sizeof(ActiveTransaction);
-
-				lseek(m_handle, 0, SEEK_SET);
-				if (write(m_handle, &m_data, sizeof(Data)) != sizeof(Data))
-					raiseError("Control file write failed (error: %d)", ERRNO);
-				if (write(m_handle, transactions.begin(), txn_size) != txn_size)
-					raiseError("Control file write failed (error: %d)", ERRNO);
-				flush();
 			}
+
+			save(transactions, committed);
 		}
 
 	private:
@@ -311,6 +311,45 @@ namespace
 			return fd;
 		}
 
+		static bool isEqual(const TransactionList& list1, const TransactionList& list2)
+		{
+			return list1.getCount() == list2.getCount() &&
+				!memcmp(list1.begin(), list2.begin(), list1.getCount() * sizeof(ActiveTransaction));
+		}
+
+		void readList(const PathName& filename, ULONG count, TransactionList& list)
+		{
+			ActiveTransaction* const ptr = list.getBuffer(count);
+			const ULONG size = count * sizeof(ActiveTransaction);
+
+			if (size && read(m_handle, ptr, size) != size)
+				raiseError("Control file %s appears corrupted", filename.c_str());
+		}
+
+		void writeList(const TransactionList& list)
+		{
+			const ULONG size = (ULONG) list.getCount() * sizeof(ActiveTransaction);
+
+			if (write(m_handle, list.begin(), size) != size)
+				raiseError("Control file write failed (error: %d)", ERRNO);
+		}
+
+		void save(const TransactionList& transactions, const TransactionList& committed)
+		{
+			m_data.txn_count = (ULONG) transactions.getCount();
+			m_data.com_count = (ULONG) committed.getCount();
+
+			lseek(m_handle, 0, SEEK_SET);
+			if (write(m_handle, &m_data, sizeof(Data)) != sizeof(Data))
+				raiseError("Control file write failed (error: %d)", ERRNO);
+			writeList(transactions);
+			writeList(committed);
+			flush();
+
+			m_transactions.assign(transactions);
+			m_committed.assign(committed);
+		}
+
 		void flush()
 		{
 #ifdef WIN_NT
@@ -321,12 +360,582 @@ namespace
 		}
 
 		Data m_data;
+		TransactionList m_transactions;		// as saved in the file
+		TransactionList m_committed;		// as saved in the file
 
 #ifdef WIN_NT
 		HANDLE m_mutex;
 #endif
 	};
 
+	// Tables changed by the journal block or transaction
+	class Footprint
+	{
+	public:
+		explicit Footprint(MemoryPool& pool)
+			: m_relations(pool), m_global(false)
+		{}
+
+		// Collect the tables changed by the block
+		void scan(ULONG length, const UCHAR* data)
+		{
+			const UCHAR* ptr = data + sizeof(Block);
+			const UCHAR* const end = data + length;
+
+			HalfStaticArray<ULONG, 16> atoms;
+
+			while (ptr < end)
+			{
+				switch (*ptr++)
+				{
+				case opStartTransaction:
+				case opPrepareTransaction:
+				case opCommitTransaction:
+				case opRollbackTransaction:
+				case opCleanupTransaction:
+				case opStartSavepoint:
+				case opReleaseSavepoint:
+				case opRollbackSavepoint:
+					break;
+
+				case opInsertRecord:
+				case opDeleteRecord:
+					addRelation(atoms, getInt32(ptr));
+					ptr += getInt32(ptr);
+					break;
+
+				case opUpdateRecord:
+					addRelation(atoms, getInt32(ptr));
+					ptr += getInt32(ptr);
+					ptr += getInt32(ptr);
+					break;
+
+				case opStoreBlob:
+					ptr += 2 * sizeof(SLONG);
+					while (ptr < end)
+					{
+						USHORT blobLength;
+						memcpy(&blobLength, ptr, sizeof(USHORT));
+						ptr += sizeof(USHORT);
+
+						if (!blobLength)
+							break;
+
+						ptr += blobLength;
+					}
+					break;
+
+				case opDefineAtom:
+					{
+						const UCHAR atomLength = *ptr++;
+						atoms.add(InternalHash::hash(atomLength, ptr));
+						ptr += atomLength;
+					}
+					break;
+
+				default:
+					// Metadata changes and sequences are ordered with everything else,
+					// so are the unknown operations
+					m_global = true;
+					return;
+				}
+			}
+		}
+
+		void merge(const Footprint& other)
+		{
+			m_global |= other.m_global;
+
+			for (const auto relation : other.m_relations)
+			{
+				FB_SIZE_T pos;
+				if (!m_relations.find(relation, pos))
+					m_relations.insert(pos, relation);
+			}
+		}
+
+		bool conflicts(const Footprint& other) const
+		{
+			if ((m_global && (other.m_global || other.m_relations.hasData())) ||
+				(other.m_global && m_relations.hasData()))
+			{
+				return true;
+			}
+
+			for (const auto relation : other.m_relations)
+			{
+				if (m_relations.exist(relation))
+					return true;
+			}
+
+			return false;
+		}
+
+		bool isEmpty() const
+		{
+			return !m_global && m_relations.isEmpty();
+		}
+
+	private:
+		static SLONG getInt32(const UCHAR*& ptr)
+		{
+			SLONG value;
+			memcpy(&value, ptr, sizeof(SLONG));
+			ptr += sizeof(SLONG);
+			return value;
+		}
+
+		void addRelation(const HalfStaticArray<ULONG, 16>& atoms, SLONG atom)
+		{
+			if (atom < 0 || (ULONG) atom >= atoms.getCount())
+			{
+				m_global = true;
+				return;
+			}
+
+			// Names are compared by hash, a collision just adds a wait
+			FB_SIZE_T pos;
+			if (!m_relations.find(atoms[atom], pos))
+				m_relations.insert(pos, atoms[atom]);
+		}
+
+		SortedArray<ULONG> m_relations;
+		bool m_global;		// metadata or sequence is changed
+	};
+
+	// Additional attachments to the replica database used to apply blocks of
+	// different transactions in parallel. Every transaction is bound to one of
+	// the workers, so its blocks are applied in the journal order.
+	//
+	// The primary flushes the transaction buffer at commit, thus changes which
+	// were made after some commit are always written to the journal after it.
+	// Blocks written before a commit belong to the transactions that were
+	// running concurrently with the committed one and could not touch its
+	// records. So the block waits only for the commits (or rollbacks) before
+	// it which are not applied yet and changed the same tables, all other
+	// blocks are applied in parallel. SQL statements and sequence changes are
+	// ordered with everything else.
+	//
+	// As the blocks are applied out of order, the workers track the oldest
+	// block not applied yet together with the transactions ended after it.
+	// The control file keeps those committed, so they are skipped after
+	// restart, and other ones are re-applied from their start.
+
+	class ApplyWorkers : public GlobalStorage
+	{
+		struct Item
+		{
+			Item(MemoryPool& pool, FB_UINT64 aTicket, ULONG length, const UCHAR* data)
+				: ticket(aTicket), block(pool)
+			{
+				block.add(data, length);
+			}
+
+			const FB_UINT64 ticket;
+			UCharBuffer block;
+		};
+
+		struct Worker
+		{
+			explicit Worker(MemoryPool& pool)
+				: owner(nullptr), attachment(nullptr), replicator(nullptr),
+				  queue(pool), handle(0)
+			{}
+
+			ApplyWorkers* owner;
+			IAttachment* attachment;
+			IReplicator* replicator;
+			Array<Item*> queue;		// the first item is being applied
+			Thread::Handle handle;
+		};
+
+		// Block passed to the workers or skipped, in the journal order
+		struct Checkpoint
+		{
+			FB_UINT64 ticket;
+			ULONG offset;			// of the block in the current segment
+			bool applied;
+		};
+
+		// Transaction that is not ended yet
+		struct Running
+		{
+			Running(MemoryPool& pool, TraNumber number)
+				: traNumber(number), footprint(pool)
+			{}
+
+			static const TraNumber& generate(const Running* item)
+			{
+				return item->traNumber;
+			}
+
+			const TraNumber traNumber;
+			Footprint footprint;	// of all its blocks passed so far
+		};
+
+		// Transaction ended by the block not older than the first checkpoint
+		struct Completion
+		{
+			Completion(MemoryPool& pool, FB_UINT64 aTicket, const ActiveTransaction& aTxn)
+				: ticket(aTicket), txn(aTxn), footprint(pool), applied(false)
+			{}
+
+			const FB_UINT64 ticket;
+			const ActiveTransaction txn;
+			Footprint footprint;
+			bool applied;
+		};
+
+		typedef SortedArray<Running*, EmptyStorage<Running*>, TraNumber, Running> RunningList;
+
+	public:
+		ApplyWorkers()
+			: m_workers(getPool()), m_ticket(0),
+			  m_checkpoints(getPool()), m_running(getPool()), m_completions(getPool()),
+			  m_failed(false), m_shutdown(false)
+		{}
+
+		~ApplyWorkers()
+		{
+			stop();
+		}
+
+		void add(IAttachment* attachment, IReplicator* replicator)
+		{
+			Worker* const worker = FB_NEW_POOL(getPool()) Worker(getPool());
+			worker->owner = this;
+			worker->attachment = attachment;
+			worker->replicator = replicator;
+			m_workers.add(worker);
+
+			Thread::start(workerThread, worker, THREAD_medium, &worker->handle);
+		}
+
+		unsigned getCount() const
+		{
+			return m_workers.getCount();
+		}
+
+		// Pass the block at the given offset of the current segment to the worker,
+		// the transaction it ends is remembered as started in the given segment
+		bool dispatch(FbLocalStatus& status, ULONG offset, ULONG length, const UCHAR* data,
+					  FB_UINT64 startSequence)
+		{
+			const Block* const header = (Block*) data;
+			const auto traNumber = header->traNumber;
+
+			Footprint footprint(getPool());
+			footprint.scan(length, data);
+
+			MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+			if (!traNumber)
+			{
+				// Not bound to a transaction (e.g. cleanup of all active ones),
+				// pass it to every worker when all the previous blocks are done
+
+				while (!m_failed && !isIdle())
+					m_condition.wait(m_mutex);
+
+				if (!m_failed)
+				{
+					for (auto worker : m_workers)
+						enqueue(worker, offset, length, data);
+
+					while (!m_failed && !isIdle())
+						m_condition.wait(m_mutex);
+				}
+
+				while (m_running.hasData())
+					delete m_running.pop();
+			}
+			else
+			{
+				while (!m_failed && hasConflict(footprint))
+					m_condition.wait(m_mutex);
+
+				if (!m_failed)
+				{
+					Worker* const worker = m_workers[traNumber % m_workers.getCount()];
+					const FB_UINT64 ticket = enqueue(worker, offset, length, data);
+
+					Running* const running = getRunning(traNumber);
+					running->footprint.merge(footprint);
+
+					if (header->flags & BLOCK_END_TRANS)
+						complete(running, ticket, startSequence, false);
+				}
+			}
+
+			return checkStatus(status);
+		}
+
+		// The block is not applied again, but it's tracked the same way
+		void skip(ULONG offset, const UCHAR* data, FB_UINT64 startSequence)
+		{
+			const Block* const header = (Block*) data;
+			const auto traNumber = header->traNumber;
+
+			MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+			Checkpoint checkpoint;
+			checkpoint.ticket = ++m_ticket;
+			checkpoint.offset = offset;
+			checkpoint.applied = true;
+			m_checkpoints.add(checkpoint);
+
+			if (traNumber && (header->flags & BLOCK_END_TRANS))
+				complete(getRunning(traNumber), checkpoint.ticket, startSequence, true);
+
+			advance();
+		}
+
+		// Wait for all the queued blocks to be applied
+		bool drain(FbLocalStatus& status)
+		{
+			MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+			while (!isIdle())
+				m_condition.wait(m_mutex);
+
+			return checkStatus(status);
+		}
+
+		// Return the offset of the oldest block which is not applied, or the given one
+		// if all of them are. Add transactions ended after it to the active ones if they
+		// are not applied, to the committed ones otherwise.
+		ULONG getState(ULONG offset, TransactionList& active, TransactionList& committed)
+		{
+			MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+			for (const auto completion : m_completions)
+			{
+				TransactionList& list = completion->applied ? committed : active;
+
+				if (!list.exist(completion->txn.tra_id))
+					list.add(completion->txn);
+			}
+
+			return m_checkpoints.hasData() ? m_checkpoints.front().offset : offset;
+		}
+
+		void stop()
+		{
+			{	// scope
+				MutexLockGuard guard(m_mutex, FB_FUNCTION);
+				m_shutdown = true;
+				m_condition.notifyAll();
+			}
+
+			for (auto worker : m_workers)
+			{
+				Thread::waitForCompletion(worker->handle);
+
+				while (worker->queue.hasData())
+					delete worker->queue.pop();
+
+#ifndef NO_DATABASE
+				FbLocalStatus localStatus;
+				worker->replicator->close(&localStatus);
+				worker->attachment->detach(&localStatus);
+#endif
+				delete worker;
+			}
+
+			m_workers.clear();
+
+			while (m_running.hasData())
+				delete m_running.pop();
+
+			while (m_completions.hasData())
+				delete m_completions.pop();
+		}
+
+	private:
+		bool isIdle() const
+		{
+			for (const auto worker : m_workers)
+			{
+				if (worker->queue.hasData())
+					return false;
+			}
+
+			return true;
+		}
+
+		bool hasConflict(const Footprint& footprint) const
+		{
+			if (footprint.isEmpty())
+				return false;
+
+			for (const auto completion : m_completions)
+			{
+				if (!completion->applied && completion->footprint.conflicts(footprint))
+					return true;
+			}
+
+			return false;
+		}
+
+		Running* getRunning(TraNumber traNumber)
+		{
+			FB_SIZE_T pos;
+			if (m_running.find(traNumber, pos))
+				return m_running[pos];
+
+			Running* const running = FB_NEW_POOL(getPool()) Running(getPool(), traNumber);
+			m_running.insert(pos, running);
+			return running;
+		}
+
+		void complete(Running* running, FB_UINT64 ticket, FB_UINT64 startSequence, bool applied)
+		{
+			Completion* const completion = FB_NEW_POOL(getPool())
+				Completion(getPool(), ticket, ActiveTransaction(running->traNumber, startSequence));
+			completion->footprint.merge(running->footprint);
+			completion->applied = applied;
+			m_completions.add(completion);
+
+			FB_SIZE_T pos;
+			if (m_running.find(running->traNumber, pos))
+				m_running.remove(pos);
+
+			delete running;
+		}
+
+		FB_UINT64 enqueue(Worker* worker, ULONG offset, ULONG length, const UCHAR* data)
+		{
+			const FB_UINT64 ticket = ++m_ticket;
+			worker->queue.add(FB_NEW_POOL(getPool()) Item(getPool(), ticket, length, data));
+
+			Checkpoint checkpoint;
+			checkpoint.ticket = ticket;
+			checkpoint.offset = offset;
+			checkpoint.applied = false;
+			m_checkpoints.add(checkpoint);
+
+			m_condition.notifyAll();
+			return ticket;
+		}
+
+		void markApplied(FB_UINT64 ticket)
+		{
+			// Tickets are assigned in order, so are checkpoints added
+			fb_assert(m_checkpoints.hasData() && ticket >= m_checkpoints.front().ticket);
+			m_checkpoints[ticket - m_checkpoints.front().ticket].applied = true;
+
+			for (auto completion : m_completions)
+			{
+				if (completion->ticket == ticket)
+				{
+					completion->applied = true;
+					break;
+				}
+			}
+
+			advance();
+		}
+
+		// Forget the applied blocks at the start and the transactions ended by them
+		void advance()
+		{
+			FB_SIZE_T count = 0;
+			while (count < m_checkpoints.getCount() && m_checkpoints[count].applied)
+				count++;
+
+			m_checkpoints.removeCount(0, count);
+
+			count = 0;
+			while (count < m_completions.getCount() &&
+				(m_checkpoints.isEmpty() || m_completions[count]->ticket < m_checkpoints.front().ticket))
+			{
+				delete m_completions[count++];
+			}
+
+			m_completions.removeCount(0, count);
+		}
+
+		bool checkStatus(FbLocalStatus& status)
+		{
+			if (!m_failed)
+				return true;
+
+			// Let the workers drop the remaining blocks, the state must not change anymore
+			while (!isIdle())
+				m_condition.wait(m_mutex);
+
+			m_status.copyTo(&status);
+			return false;
+		}
+
+		static THREAD_ENTRY_DECLARE workerThread(THREAD_ENTRY_PARAM arg)
+		{
+			Worker* const worker = static_cast<Worker*>(arg);
+			worker->owner->work(worker);
+			return 0;
+		}
+
+		void work(Worker* worker)
+		{
+			MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+			while (true)
+			{
+				while (!m_shutdown && worker->queue.isEmpty())
+					m_condition.wait(m_mutex);
+
+				if (m_shutdown)
+					break;
+
+				if (m_failed)
+				{
+					// Everything not applied yet is re-applied after restart
+					while (worker->queue.hasData())
+						delete worker->queue.pop();
+
+					m_condition.notifyAll();
+					continue;
+				}
+
+				Item* const item = worker->queue.front();
+				FbLocalStatus localStatus;
+
+				{	// scope
+					MutexUnlockGuard cout(m_mutex, FB_FUNCTION);
+#ifndef NO_DATABASE
+					worker->replicator->process(&localStatus,
+						item->block.getCount(), item->block.begin());
+#endif
+				}
+
+				worker->queue.remove((FB_SIZE_T) 0);
+
+				if (localStatus.isSuccess())
+					markApplied(item->ticket);
+				else if (!m_failed)
+				{
+					localStatus.copyTo(&m_status);
+					m_failed = true;
+				}
+
+				delete item;
+
+				m_condition.notifyAll();
+			}
+		}
+
+		Mutex m_mutex;
+		Condition m_condition;
+		Array<Worker*> m_workers;
+		FB_UINT64 m_ticket;
+		Array<Checkpoint> m_checkpoints;	// starting from the oldest block not applied
+		RunningList m_running;
+		Array<Completion*> m_completions;	// in the order of their tickets
+		FbLocalStatus m_status;
+		bool m_failed;
+		bool m_shutdown;
+	};
+
 	class Target : public GlobalStorage
 	{
 	public:
@@ -382,6 +991,32 @@ namespace
 			m_replicator = m_attachment->createReplicator(&localStatus);
 			localStatus.check();
 
+			if (m_config->applyWorkers > 1)
+			{
+				m_workers = FB_NEW ApplyWorkers;
+
+				while (m_workers->getCount() < m_config->applyWorkers)
+				{
+					const auto attachment =
+						provider->attachDatabase(&localStatus, m_config->dbName.c_str(),
+												 dpb.getBufferLength(), dpb.getBuffer());
+					localStatus.check();
+
+					const auto replicator = attachment->createReplicator(&localStatus);
+
+					if (!localStatus.isSuccess())
+					{
+						FbLocalStatus tempStatus;
+						attachment->detach(&tempStatus);
+						localStatus.raise();
+					}
+
+					m_workers->add(attachment, replicator);
+				}
+
+				verbose("Using %u attachments to apply changes in parallel", m_workers->getCount());
+			}
+
 			fb_assert(!m_sequence);
 
 			const auto transaction = m_attachment->startTransaction(&localStatus, 0, NULL);
@@ -410,6 +1045,8 @@ namespace
 
 		void shutdown()
 		{
+			m_workers.reset();
+
 			if (m_attachment)
 			{
 #ifndef NO_DATABASE
@@ -425,16 +1062,39 @@ namespace
 			m_connected = false;
 		}
 
-		bool replicate(FbLocalStatus& status, ULONG length, const UCHAR* data)
+		bool replicate(FbLocalStatus& status, ULONG offset, ULONG length, const UCHAR* data,
+					   FB_UINT64 startSequence)
 		{
 #ifdef NO_DATABASE
 			return true;
 #else
+			if (m_workers)
+				return m_workers->dispatch(status, offset, length, data, startSequence);
+
 			m_replicator->process(&status, length, data);
 			return status.isSuccess();
 #endif
 		}
 
+		// Wait for the blocks being applied in parallel
+		bool drain(FbLocalStatus& status)
+		{
+			return m_workers ? m_workers->drain(status) : true;
+		}
+
+		// The block is not applied as it was applied before restart
+		void skip(ULONG offset, const UCHAR* data, FB_UINT64 startSequence)
+		{
+			if (m_workers)
+				m_workers->skip(offset, data, startSequence);
+		}
+
+		// Return the offset to continue from after restart, see ApplyWorkers::getState()
+		ULONG getState(ULONG offset, TransactionList& active, TransactionList& committed)
+		{
+			return m_workers ? m_workers->getState(offset, active, committed) : offset;
+		}
+
 		bool isShutdown() const
 		{
 			return (m_attachment == NULL);
@@ -474,6 +1134,7 @@ namespace
 		string m_lastError;
 		IAttachment* m_attachment;
 		IReplicator* m_replicator;
+		AutoPtr<ApplyWorkers> m_workers;
 		FB_UINT64 m_sequence;
 		bool m_connected;
 	};
@@ -555,8 +1216,11 @@ namespace
 		if (strcmp(header->hdr_signature, CHANGELOG_SIGNATURE))
 			return false;
 
-		if (header->hdr_version != CHANGELOG_CURRENT_VERSION)
+		if (header->hdr_version < CHANGELOG_VERSION_1 ||
+			header->hdr_version > CHANGELOG_CURRENT_VERSION)
+		{
 			return false;
+		}
 
 		if (header->hdr_state != SEGMENT_STATE_FREE &&
 			header->hdr_state != SEGMENT_STATE_USED &&
@@ -570,7 +1234,7 @@ namespace
 	}
 
 	bool replicate(FbLocalStatus& status, FB_UINT64 sequence,
-				   Target* target, TransactionList& transactions,
+				   Target* target, TransactionList& transactions, TransactionList& committed,
 				   ULONG offset, ULONG length, const UCHAR* data,
 				   bool rewind)
 	{
@@ -578,19 +1242,26 @@ namespace
 
 		const auto traNumber = header->traNumber;
 
-		if (!rewind || !traNumber || transactions.exist(traNumber))
-		{
-			if (!target->replicate(status, length, data))
-				return false;
-		}
+		FB_SIZE_T pos;
+		const bool active = traNumber && transactions.find(traNumber, pos);
+		const FB_UINT64 startSequence = active ? transactions[pos].sequence : sequence;
+
+		// Transactions committed before restart are not applied again
+
+		if (traNumber && ((rewind && !active) || committed.exist(traNumber)))
+			target->skip(offset, data, startSequence);
+		else if (!target->replicate(status, offset, length, data, startSequence))
+			return false;
 
 		if (header->flags & BLOCK_END_TRANS)
 		{
 			if (traNumber)
 			{
-				FB_SIZE_T pos;
 				if (transactions.find(traNumber, pos))
 					transactions.remove(pos);
+
+				if (committed.find(traNumber, pos))
+					committed.remove(pos);
 			}
 			else if (!rewind)
 			{
@@ -731,7 +1402,9 @@ namespace
 			// Second pass: replicate the chain of contiguous segments
 
 			Array<UCHAR> buffer(pool);
+			UCharBuffer unpacked(pool);
 			TransactionList transactions(pool);
+			TransactionList committed(pool);
 
 			const FB_UINT64 max_sequence = queue.back()->header.hdr_sequence;
 			FB_UINT64 next_sequence = 0;
@@ -743,7 +1416,7 @@ namespace
 				const FB_UINT64 sequence = segment->header.hdr_sequence;
 				const Guid& guid = segment->header.hdr_guid;
 
-				ControlFile control(target->getDirectory(), guid, sequence, transactions);
+				ControlFile control(target->getDirectory(), guid, sequence, transactions, committed);
 
 				FB_UINT64 last_sequence = control.getSequence();
 				ULONG last_offset = control.getOffset();
@@ -763,7 +1436,8 @@ namespace
 					target->verbose("Resetting replication to continue from segment %" UQUADFORMAT, db_sequence + 1);
 					control.saveDbSequence(db_sequence);
 					transactions.clear();
-					control.saveComplete(db_sequence, transactions);
+					committed.clear();
+					control.saveComplete(db_sequence, transactions, committed);
 					last_sequence = db_sequence;
 					last_offset = 0;
 				}
@@ -818,6 +1492,21 @@ namespace
 
 				AutoFile file(fd);
 
+				// Remember the position to continue from after restart. Blocks being
+				// applied in parallel must not be skipped and those already committed
+				// must not be applied again.
+				const auto savePosition = [&](ULONG offset)
+				{
+					TransactionList active(pool);
+					active.assign(transactions);
+
+					TransactionList done(pool);
+					done.assign(committed);
+
+					offset = target->getState(offset, active, done);
+					control.savePartial(sequence, offset, active, done);
+				};
+
 				SegmentHeader header;
 
 				if (read(file, &header, sizeof(SegmentHeader)) != sizeof(SegmentHeader))
@@ -847,14 +1536,26 @@ namespace
 						if (read(file, data + sizeof(Block), blockLength) != blockLength)
 							raiseError("Journal file %s read failed (error %d)", segment->filename.c_str(), ERRNO);
 
+						ULONG blockSize = length;
+						const UCHAR* block = data;
+
+						if (header.flags & BLOCK_COMPRESSED)
+						{
+							decompressBlock(length, data, unpacked);
+							blockSize = unpacked.getCount();
+							block = unpacked.begin();
+						}
+
 						const bool success =
 							replicate(localStatus, sequence,
-									  target, transactions,
-									  totalLength, length, data,
+									  target, transactions, committed,
+									  totalLength, blockSize, block,
 									  rewind);
 
 						if (!success)
 						{
+							savePosition(totalLength);
+
 							oldest = findOldest(transactions);
 							oldest_sequence = oldest ? oldest->sequence : 0;
 
@@ -867,10 +1568,17 @@ namespace
 
 					totalLength += length;
 
-					control.savePartial(sequence, totalLength, transactions);
+					savePosition(totalLength);
+				}
+
+				if (!target->drain(localStatus))
+				{
+					savePosition(totalLength);
+					target->verbose("Segment %" UQUADFORMAT " replication failure", sequence);
+					localStatus.raise();
 				}
 
-				control.saveComplete(sequence, transactions);
+				control.saveComplete(sequence, transactions, committed);
 
 				file.release();
 
@@ -1176,6 +1176,7 @@ static void		cancel_operation(rem_port*, USHORT);
 
 static bool		check_request(Rrq*, USHORT, USHORT);
 static USHORT	check_statement_type(Rsr*);
+static void		get_blob_fields(Rsr*, Array<USHORT>&);
 
 static bool		get_next_msg_no(Rrq*, USHORT, USHORT*);
 static Rtr*		make_transaction(Rdb*, ITransaction*);
@@ -1918,7 +1919,7 @@ static bool accept_connection(rem_port* port, P_CNCT* connect, PACKET* send)
 	{
 		if ((protocol->p_cnct_version == PROTOCOL_VERSION10 ||
 			 (protocol->p_cnct_version >= PROTOCOL_VERSION11 &&
-			  protocol->p_cnct_version <= PROTOCOL_VERSION16)) &&
+			  protocol->p_cnct_version <= PROTOCOL_VERSION17)) &&
 			 (protocol->p_cnct_architecture == arch_generic ||
 			  protocol->p_cnct_architecture == ARCHITECTURE) &&
 			protocol->p_cnct_weight >= weight)
@@ -3960,6 +3961,18 @@ ISC_STATUS rem_port::fetch(P_SQLDATA * sqldata, PACKET* sendL)
 	const USHORT max_records = statement->rsr_flags.test(Rsr::NO_BATCH) ?
 		1 : sqldata->p_sqldata_messages;
 
+	// Find out the blob fields which values could be sent inline with the rows
+
+	// The client keeps the inline blob in the buffer of USHORT length
+
+	const ULONG inlineBlobSize = (this->port_protocol >= PROTOCOL_INLINE_BLOB && statement->rsr_rtr) ?
+		MIN(sqldata->p_sqldata_inline_blob_size, MAX_USHORT) : 0;
+
+	Array<USHORT> blobFields;
+
+	if (inlineBlobSize && statement->rsr_select_format)
+		get_blob_fields(statement, blobFields);
+
 	P_SQLDATA* response = &sendL->p_sqldata;
 	sendL->p_operation = op_fetch_response;
 	response->p_sqldata_statement = sqldata->p_sqldata_statement;
@@ -4024,6 +4037,27 @@ ISC_STATUS rem_port::fetch(P_SQLDATA * sqldata, PACKET* sendL)
 			statement->rsr_msgs_waiting--;
 		}
 
+		// Send the small blobs of the row before the row itself
+
+		for (const USHORT* field = blobFields.begin(); field != blobFields.end(); ++field)
+		{
+			const rem_fmt* const format = statement->rsr_select_format;
+			const dsc& desc = format->fmt_desc[*field];
+			const dsc& nullDesc = format->fmt_desc[*field + 1];
+
+			if (*reinterpret_cast<const SSHORT*>(message->msg_address + (IPTR) nullDesc.dsc_address))
+				continue;
+
+			const ISC_QUAD* const blobId =
+				reinterpret_cast<const ISC_QUAD*>(message->msg_address + (IPTR) desc.dsc_address);
+
+			if ((blobId->gds_quad_high || blobId->gds_quad_low) &&
+				!this->send_inline_blob(statement, *blobId, inlineBlobSize))
+			{
+				return FALSE;
+			}
+		}
+
 		// There's a buffer waiting -- send it
 
 		if (!this->send_partial(sendL))
@@ -4112,6 +4146,54 @@ ISC_STATUS rem_port::fetch(P_SQLDATA * sqldata, PACKET* sendL)
 }
 
 
+static void get_blob_fields(Rsr* statement, Array<USHORT>& fields)
+{
+/**************************************
+ *
+ *	g e t _ b l o b _ f i e l d s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Collect the numbers of descriptors of the select
+ *	message that contain blob ids. Blob ids are passed
+ *	as blr_quad, thus the cursor metadata is used to tell
+ *	them from array ids.
+ *
+ **************************************/
+	LocalStatus ls;
+	CheckStatusWrapper status_vector(&ls);
+
+	if (!statement->rsr_cursor)
+		return;
+
+	RefPtr<IMessageMetadata> metadata(REF_NO_INCR, statement->rsr_cursor->getMetadata(&status_vector));
+
+	if (status_vector.getState() & IStatus::STATE_ERRORS)
+		return;
+
+	const unsigned count = metadata->getCount(&status_vector);
+	const rem_fmt* const format = statement->rsr_select_format;
+
+	// Every field is followed by its null flag in the message
+
+	if ((status_vector.getState() & IStatus::STATE_ERRORS) || format->fmt_desc.getCount() != count * 2)
+		return;
+
+	for (unsigned i = 0; i < count; i++)
+	{
+		const dsc& desc = format->fmt_desc[i * 2];
+
+		if ((desc.dsc_dtype == dtype_quad || desc.dsc_dtype == dtype_blob) &&
+			desc.dsc_length == sizeof(ISC_QUAD) &&
+			metadata->getType(&status_vector, i) == SQL_BLOB)
+		{
+			fields.add(i * 2);
+		}
+	}
+}
+
+
 static bool get_next_msg_no(Rrq* request, USHORT incarnation, USHORT * msg_number)
 {
 /**************************************
@@ -4163,6 +4245,142 @@ static bool get_next_msg_no(Rrq* request, USHORT incarnation, USHORT * msg_numbe
 }
 
 
+bool rem_port::send_inline_blob(Rsr* statement, const ISC_QUAD& blobId, ULONG maxSize)
+{
+/**************************************
+ *
+ *	s e n d _ i n l i n e _ b l o b
+ *
+ **************************************
+ *
+ * Functional description
+ *	Send the whole blob to the client ahead of the fetched row
+ *	if it's small enough. Blobs that are not sent are opened by
+ *	the client as usual, thus errors are not reported here.
+ *	Return false if the packet could not be sent.
+ *
+ **************************************/
+	LocalStatus ls;
+	CheckStatusWrapper status_vector(&ls);
+
+	Rtr* const transaction = statement->rsr_rtr;
+	ISC_QUAD id = blobId;
+
+	IBlob* const blob = statement->rsr_rdb->rdb_iface->openBlob(&status_vector,
+		transaction->rtr_iface, &id, 0, NULL);
+
+	if (status_vector.getState() & IStatus::STATE_ERRORS)
+		return true;
+
+	static const UCHAR blob_items[] =
+	{
+		isc_info_blob_num_segments,
+		isc_info_blob_max_segment,
+		isc_info_blob_total_length,
+		isc_info_blob_type
+	};
+
+	UCHAR info[64];
+	ULONG infoLength = 0;
+	SLONG segments = -1, totalLength = -1, type = -1;
+
+	blob->getInfo(&status_vector, sizeof(blob_items), blob_items, sizeof(info), info);
+
+	if (!(status_vector.getState() & IStatus::STATE_ERRORS))
+	{
+		const UCHAR* p = info;
+		const UCHAR* const end = info + sizeof(info);
+
+		while (p < end && *p != isc_info_end)
+		{
+			const UCHAR item = *p++;
+			const USHORT l = gds__vax_integer(p, 2);
+			p += 2;
+			const SLONG n = gds__vax_integer(p, l);
+			p += l;
+
+			switch (item)
+			{
+			case isc_info_blob_num_segments:
+				segments = n;
+				break;
+
+			case isc_info_blob_total_length:
+				totalLength = n;
+				break;
+
+			case isc_info_blob_type:
+				type = n;
+				break;
+			}
+		}
+
+		if (p < end)
+			infoLength = p - info + 1;
+	}
+
+	// Stream blobs could be positioned by the client, don't send them
+
+	HalfStaticArray<UCHAR, BLOB_LENGTH> data;
+	ULONG length = 0;
+	bool inlined = false;
+
+	if (infoLength && type == isc_bpb_type_segmented && segments >= 0 && totalLength >= 0 &&
+		(FB_UINT64) totalLength + (FB_UINT64) segments * sizeof(USHORT) <= maxSize)
+	{
+		// Segments are put into the buffer in the same form as op_get_segment
+		// returns them: two bytes of length followed by the data
+
+		const ULONG size = totalLength + segments * sizeof(USHORT);
+		UCHAR* const buffer = data.getBuffer(size + sizeof(USHORT));
+		inlined = true;
+
+		while (true)
+		{
+			unsigned segmentLength = 0;
+			const int rc = blob->getSegment(&status_vector, size - MIN(size, length + sizeof(USHORT)),
+				buffer + length + sizeof(USHORT), &segmentLength);
+
+			if (rc == IStatus::RESULT_NO_DATA)
+				break;
+
+			if (rc != IStatus::RESULT_OK || length + sizeof(USHORT) > size)
+			{
+				inlined = false;
+				break;
+			}
+
+			buffer[length] = (UCHAR) segmentLength;
+			buffer[length + 1] = (UCHAR) (segmentLength >> 8);
+			length += sizeof(USHORT) + segmentLength;
+		}
+
+		inlined = inlined && (length == size);
+	}
+
+	status_vector.init();
+	blob->close(&status_vector);
+
+	if (status_vector.getState() & IStatus::STATE_ERRORS)
+		blob->release();
+
+	if (!inlined)
+		return true;
+
+	PACKET packet;
+	packet.p_operation = op_inline_blob;
+	P_INLINE_BLOB* const response = &packet.p_inline_blob;
+	response->p_tran_id = transaction->rtr_id;
+	response->p_blob_id = blobId;
+	response->p_blob_info.cstr_length = infoLength;
+	response->p_blob_info.cstr_address = info;
+	response->p_blob_data.cstr_length = length;
+	response->p_blob_data.cstr_address = data.begin();
+
+	return this->send_partial(&packet);
+}
+
+
 ISC_STATUS rem_port::get_segment(P_SGMT* segment, PACKET* sendL)
 {
 /**************************************
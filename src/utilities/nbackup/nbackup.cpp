@@ -54,6 +54,12 @@
 #include "../common/StatusArg.h"
 #include "../common/classes/objects_array.h"
 #include "../common/os/os_utils.h"
+#include "../common/ThreadStart.h"
+#include "../common/classes/auto.h"
+#include "../common/classes/condition.h"
+#include "../common/classes/init.h"
+#include "../common/classes/locks.h"
+#include "../common/classes/zip.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -75,10 +81,18 @@
 #include <sys/wait.h>
 #endif
 
+#ifdef WIN_NT
+#include <io.h>
+#endif
+
 #ifndef O_LARGEFILE
 #define O_LARGEFILE 0
 #endif
 
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
 // How much we align memory when reading database header.
 // Sector alignment of memory is necessary to use unbuffered IO on Windows.
 // Actually, sectors may be bigger than 1K, but let's be consistent with
@@ -270,17 +284,434 @@ struct inc_header
 	ULONG prev_scn;			// SCN of previous level backup
 };
 
+// Compressed backup consists of compressed_header followed by the blocks of
+// regular backup stream, each one is preceded by block_header. Blocks are
+// packed independently, thus a number of threads can pack and unpack them.
+
+const char compressed_signature[4] = {'N','B','K','Z'};
+const SSHORT COMPRESSED_VERSION = 1;
+const ULONG COMPRESSED_BLOCK_SIZE = 1024 * 1024;
+const ULONG MAX_COMPRESSED_BLOCK_SIZE = 64 * 1024 * 1024;
+
+struct compressed_header
+{
+	char signature[4];		// 'NBKZ'
+	SSHORT version;			// Compressed backup format version
+	SSHORT reserved;		// Not used
+	ULONG block_size;		// Maximum length of unpacked block
+};
+
+struct block_header
+{
+	ULONG length;			// Length of unpacked data
+	ULONG packed_length;	// Length of stored data, equal to length if not packed
+};
+
+// Number of pages read by single read-ahead job
+const ULONG READ_AHEAD_PAGES = 64;
+
+// Limit of -PARALLEL switch
+const unsigned MAX_PARALLEL = 64;
+
+#ifdef HAVE_ZLIB_H
+static InitInstance<ZLib> zlib;
+#endif
+
+
+// Work done by background threads. Jobs are started in the order they are
+// queued, the stream which queued them waits for them in the same order.
+
+class BackgroundJob
+{
+public:
+	BackgroundJob()
+		: done(true), error(0)		// not started job is not waited for
+	{}
+
+	virtual ~BackgroundJob()
+	{}
+
+	virtual void execute() = 0;
+
+	bool done;
+	int error;			// OS or zlib error code
+};
+
+class WorkerPool
+{
+public:
+	explicit WorkerPool(unsigned count);
+	~WorkerPool();
+
+	void start(BackgroundJob* job);
+	void wait(BackgroundJob* job);
+
+	unsigned getCount() const
+	{
+		return threads.getCount();
+	}
+
+private:
+	static THREAD_ENTRY_DECLARE workerThread(THREAD_ENTRY_PARAM arg);
+	void work();
+
+	Mutex mutex;
+	Condition jobQueued, jobDone;
+	Array<BackgroundJob*> queue;
+	HalfStaticArray<Thread::Handle, 16> threads;
+	bool shutdown;
+};
+
+WorkerPool::WorkerPool(unsigned count)
+	: shutdown(false)
+{
+	for (unsigned n = 0; n < count; n++)
+	{
+		Thread::Handle handle;
+
+		try
+		{
+			Thread::start(workerThread, this, THREAD_medium, &handle);
+		}
+		catch (const Exception&)
+		{
+			// Work with threads we already have
+			if (threads.isEmpty())
+				throw;
+			break;
+		}
+
+		threads.add(handle);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{	// scope
+		MutexLockGuard guard(mutex, FB_FUNCTION);
+		shutdown = true;
+		jobQueued.notifyAll();
+	}
+
+	for (FB_SIZE_T n = 0; n < threads.getCount(); n++)
+		Thread::waitForCompletion(threads[n]);
+}
+
+void WorkerPool::start(BackgroundJob* job)
+{
+	MutexLockGuard guard(mutex, FB_FUNCTION);
+
+	job->done = false;
+	job->error = 0;
+	queue.add(job);
+	jobQueued.notifyOne();
+}
+
+void WorkerPool::wait(BackgroundJob* job)
+{
+	MutexLockGuard guard(mutex, FB_FUNCTION);
+
+	while (!job->done)
+		jobDone.wait(mutex);
+}
+
+THREAD_ENTRY_DECLARE WorkerPool::workerThread(THREAD_ENTRY_PARAM arg)
+{
+	static_cast<WorkerPool*>(arg)->work();
+	return 0;
+}
+
+void WorkerPool::work()
+{
+	MutexLockGuard guard(mutex, FB_FUNCTION);
+
+	while (true)
+	{
+		if (queue.hasData())
+		{
+			BackgroundJob* const job = queue[0];
+			queue.remove((FB_SIZE_T) 0);
+
+			{	// scope
+				MutexUnlockGuard cout(mutex, FB_FUNCTION);
+				job->execute();
+			}
+
+			job->done = true;
+			jobDone.notifyAll();
+			continue;
+		}
+
+		if (shutdown)
+			break;
+
+		jobQueued.wait(mutex);
+	}
+}
+
+
+// Reads a range of database pages
+
+class ReadJob : public BackgroundJob
+{
+public:
+	ReadJob(FILE_HANDLE aFile, ULONG pageSize)
+		: file(aFile), chunk(0), length(READ_AHEAD_PAGES * pageSize), bytesRead(0)
+	{
+		UCHAR* const buf = unalignedBuffer.getBuffer(length + SECTOR_ALIGNMENT);
+		buffer = FB_ALIGN(buf, SECTOR_ALIGNMENT);
+	}
+
+	void execute();
+
+	FILE_HANDLE file;
+	ULONG chunk;			// number of range
+	FB_SIZE_T length;		// length of range
+	FB_SIZE_T bytesRead;	// less than length at the end of file
+	UCHAR* buffer;
+
+private:
+	Array<UCHAR> unalignedBuffer;
+};
+
+void ReadJob::execute()
+{
+	const SINT64 offset = (SINT64) chunk * length;
+	bytesRead = 0;
+
+	while (bytesRead < length)
+	{
+#ifdef WIN_NT
+		// Synchronous handle still accepts the position of read
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(overlapped));
+		overlapped.Offset = (DWORD) (offset + bytesRead);
+		overlapped.OffsetHigh = (DWORD) ((offset + bytesRead) >> 32);
+
+		DWORD res;
+		if (!ReadFile(file, buffer + bytesRead, length - bytesRead, &res, &overlapped))
+		{
+			const DWORD err = GetLastError();
+			if (err != ERROR_HANDLE_EOF)
+				error = err;
+			break;
+		}
+#else
+		const ssize_t res = os_utils::pread(file, buffer + bytesRead, length - bytesRead,
+			offset + bytesRead);
+		if (res < 0)
+		{
+			if (SYSCALL_INTERRUPTED(errno))
+				continue;
+
+			error = errno;
+			break;
+		}
+#endif
+
+		if (!res)
+			break;
+
+		bytesRead += res;
+	}
+}
+
+
+// Reads the database file ahead of the sequential scan. Every background
+// thread reads its own range of pages.
+
+class ReadAhead
+{
+public:
+	ReadAhead(WorkerPool& aWorkers, FILE_HANDLE aFile, ULONG aPageSize)
+		: workers(aWorkers), file(aFile), pageSize(aPageSize), current(NULL), nextChunk(0)
+	{}
+
+	~ReadAhead();
+
+	// Returns number of bytes read, zero at the end of file
+	FB_SIZE_T read(ULONG page, void* buffer, int& error);
+
+private:
+	void queueJobs();
+
+	WorkerPool& workers;
+	FILE_HANDLE file;
+	const ULONG pageSize;
+	Array<ReadJob*> queue;		// jobs started, in the file order
+	Array<ReadJob*> spare;
+	ReadJob* current;			// job with the current range of pages
+	ULONG nextChunk;
+};
+
+ReadAhead::~ReadAhead()
+{
+	// Buffers can't be released until the reads are done
+	for (FB_SIZE_T n = 0; n < queue.getCount(); n++)
+	{
+		workers.wait(queue[n]);
+		delete queue[n];
+	}
+
+	for (FB_SIZE_T n = 0; n < spare.getCount(); n++)
+		delete spare[n];
+
+	delete current;
+}
+
+void ReadAhead::queueJobs()
+{
+	while (queue.getCount() < 2 * workers.getCount())
+	{
+		ReadJob* const job = spare.hasData() ? spare.pop() : FB_NEW ReadJob(file, pageSize);
+		job->chunk = nextChunk++;
+		workers.start(job);
+		queue.add(job);
+	}
+}
+
+FB_SIZE_T ReadAhead::read(ULONG page, void* buffer, int& error)
+{
+	const ULONG chunk = page / READ_AHEAD_PAGES;
+
+	// Pages are read in ascending order
+	fb_assert(!current || current->chunk <= chunk);
+
+	while (!current || current->chunk != chunk)
+	{
+		if (current)
+		{
+			spare.add(current);
+			current = NULL;
+		}
+
+		queueJobs();
+
+		current = queue[0];
+		queue.remove((FB_SIZE_T) 0);
+		workers.wait(current);
+
+		if (current->error)
+		{
+			error = current->error;
+			return 0;
+		}
+	}
+
+	queueJobs();
+
+	const FB_SIZE_T offset = (page % READ_AHEAD_PAGES) * pageSize;
+
+	if (offset >= current->bytesRead)
+		return 0;
+
+	const FB_SIZE_T length = MIN(pageSize, current->bytesRead - offset);
+	memcpy(buffer, current->buffer + offset, length);
+
+	return length;
+}
+
+
+// Packs or unpacks single block of compressed backup
+
+class BlockJob : public BackgroundJob
+{
+public:
+	BlockJob(bool aPack, ULONG blockSize)
+		: pack(aPack), length(0), packedLength(0)
+	{
+		data.getBuffer(blockSize);
+		packed.getBuffer(blockSize);
+	}
+
+	void execute();
+
+	const bool pack;
+	Array<UCHAR> data;		// unpacked data
+	Array<UCHAR> packed;	// stored data
+	ULONG length;
+	ULONG packedLength;
+};
+
+void BlockJob::execute()
+{
+	if (pack)
+	{
+		// Block which does not become smaller is stored as is
+		packedLength = length;
+
+#ifdef HAVE_ZLIB_H
+		z_stream strm;
+		strm.zalloc = ZLib::allocFunc;
+		strm.zfree = ZLib::freeFunc;
+		strm.opaque = Z_NULL;
+
+		if (zlib().deflateInit(&strm, Z_DEFAULT_COMPRESSION) != Z_OK)
+			return;
+
+		strm.next_in = data.begin();
+		strm.avail_in = length;
+		strm.next_out = packed.begin();
+		strm.avail_out = length;
+
+		if (zlib().deflate(&strm, Z_FINISH) == Z_STREAM_END && strm.total_out < length)
+			packedLength = strm.total_out;
+
+		zlib().deflateEnd(&strm);
+#endif
+		return;
+	}
+
+	if (packedLength == length)
+	{
+		memcpy(data.begin(), packed.begin(), length);
+		return;
+	}
+
+#ifdef HAVE_ZLIB_H
+	z_stream strm;
+	strm.zalloc = ZLib::allocFunc;
+	strm.zfree = ZLib::freeFunc;
+	strm.opaque = Z_NULL;
+
+	if (zlib().inflateInit(&strm) != Z_OK)
+	{
+		error = Z_MEM_ERROR;
+		return;
+	}
+
+	strm.next_in = packed.begin();
+	strm.avail_in = packedLength;
+	strm.next_out = data.begin();
+	strm.avail_out = length;
+
+	const int ret = zlib().inflate(&strm, Z_FINISH);
+
+	if (ret != Z_STREAM_END || strm.total_out != length)
+		error = (ret < 0) ? ret : Z_DATA_ERROR;
+
+	zlib().inflateEnd(&strm);
+#else
+	error = -1;
+#endif
+}
+
+
 class NBackup
 {
 public:
 	NBackup(UtilSvc* _uSvc, const PathName& _database, const string& _username, const string& _role,
-			const string& _password, bool _run_db_triggers, bool _direct_io, const string& _deco)
+			const string& _password, bool _run_db_triggers, bool _direct_io, const string& _deco,
+			unsigned _parallel, bool _compress)
 	  : uSvc(_uSvc), newdb(0), trans(0), database(_database),
 		username(_username), role(_role), password(_password),
 		run_db_triggers(_run_db_triggers), direct_io(_direct_io),
 		dbase(INVALID_HANDLE_VALUE), backup(INVALID_HANDLE_VALUE),
 		decompress(_deco), childId(0), db_size_pages(0),
-		m_odsNumber(0), m_silent(false), m_printed(false)
+		m_odsNumber(0), m_silent(false), m_printed(false),
+		parallel(_parallel), compress(_compress),
+		bakStarted(false), bakCompressed(false), bakEof(false), bakBlockSize(0),
+		bakCurrent(NULL), bakPosition(0)
 	{
 		// Recognition of local prefix allows to work with
 		// database using TCP/IP loopback while reading file locally.
@@ -347,6 +778,21 @@ private:
 	bool m_silent;		// are we already handling an exception?
 	bool m_printed;		// pr_error() was called to print status vector
 
+	unsigned parallel;	// number of background threads
+	bool compress;		// write compressed backup
+	AutoPtr<WorkerPool> workers;
+
+	// State of the backup stream
+	bool bakStarted;			// header of compressed backup is written or checked
+	bool bakCompressed;			// backup is compressed
+	bool bakEof;				// all blocks of backup are read
+	ULONG bakBlockSize;
+	Array<BlockJob*> bakBlocks;	// blocks being packed or unpacked, in the file order
+	Array<BlockJob*> bakSpare;
+	BlockJob* bakCurrent;		// block being filled or read
+	FB_SIZE_T bakPosition;		// position in the current block
+	Array<UCHAR> bakPrefix;		// start of not compressed backup read while checking its header
+
 	// IO functions
 	FB_SIZE_T read_file(FILE_HANDLE &file, void *buffer, FB_SIZE_T bufsize);
 	void write_file(FILE_HANDLE &file, void *buffer, FB_SIZE_T bufsize);
@@ -373,6 +819,19 @@ private:
 	void open_backup_decompress();
 	void create_backup();
 	void close_backup();
+
+	// Backup stream, compressed or not
+	void write_backup(void* buffer, FB_SIZE_T bufsize);
+	void flush_backup();
+	FB_SIZE_T read_backup(void* buffer, FB_SIZE_T bufsize);
+	void start_workers();
+	BlockJob* get_block(bool pack);
+	void queue_block();
+	void write_block();
+	bool next_block();
+	void raise_corrupted();
+
+	bool read_page_map(ULONG page_size, ULONG prev_scn, Array<ULONG>& entries);
 };
 
 
@@ -792,6 +1251,25 @@ void NBackup::create_backup()
 
 void NBackup::close_backup()
 {
+	// Blocks could be still used by the workers after an error
+	for (FB_SIZE_T n = 0; n < bakBlocks.getCount(); n++)
+	{
+		workers->wait(bakBlocks[n]);
+		delete bakBlocks[n];
+	}
+
+	for (FB_SIZE_T n = 0; n < bakSpare.getCount(); n++)
+		delete bakSpare[n];
+
+	delete bakCurrent;
+
+	bakBlocks.clear();
+	bakSpare.clear();
+	bakPrefix.clear();
+	bakCurrent = NULL;
+	bakPosition = 0;
+	bakStarted = bakCompressed = bakEof = false;
+
 	if (bakname == "stdout")
 		return;
 #ifdef WIN_NT
@@ -820,6 +1298,245 @@ void NBackup::close_backup()
 #endif
 }
 
+void NBackup::start_workers()
+{
+	if (!workers)
+		workers = FB_NEW WorkerPool(parallel);
+}
+
+BlockJob* NBackup::get_block(bool pack)
+{
+	if (bakSpare.hasData())
+		return bakSpare.pop();
+
+	return FB_NEW BlockJob(pack, bakBlockSize);
+}
+
+void NBackup::raise_corrupted()
+{
+	(Arg::Gds(isc_nbackup_err_read) << bakname.c_str() <<
+	 Arg::Gds(isc_random) << "Compressed backup is corrupted").raise();
+}
+
+void NBackup::write_backup(void* buffer, FB_SIZE_T bufsize)
+{
+	if (!compress)
+	{
+		write_file(backup, buffer, bufsize);
+		return;
+	}
+
+	if (!bakStarted)
+	{
+#ifdef HAVE_ZLIB_H
+		if (!zlib())
+		{
+			(Arg::Gds(isc_random) << "Backup cannot be compressed" <<
+			 Arg::StatusVector(zlib().status)).raise();
+		}
+#else
+		(Arg::Gds(isc_random) << "Backup cannot be compressed, zlib is not supported").raise();
+#endif
+
+		start_workers();
+
+		compressed_header header;
+		memcpy(header.signature, compressed_signature, sizeof(compressed_signature));
+		header.version = COMPRESSED_VERSION;
+		header.reserved = 0;
+		header.block_size = bakBlockSize = COMPRESSED_BLOCK_SIZE;
+		write_file(backup, &header, sizeof(header));
+
+		bakStarted = bakCompressed = true;
+	}
+
+	const UCHAR* data = static_cast<const UCHAR*>(buffer);
+
+	while (bufsize)
+	{
+		if (!bakCurrent)
+		{
+			bakCurrent = get_block(true);
+			bakPosition = 0;
+		}
+
+		const FB_SIZE_T length = MIN(bufsize, bakBlockSize - bakPosition);
+		memcpy(bakCurrent->data.begin() + bakPosition, data, length);
+		bakPosition += length;
+		data += length;
+		bufsize -= length;
+
+		if (bakPosition == bakBlockSize)
+			queue_block();
+	}
+}
+
+void NBackup::queue_block()
+{
+	// Keep every thread busy and one more block ready for each of them
+	bakCurrent->length = bakPosition;
+	workers->start(bakCurrent);
+	bakBlocks.add(bakCurrent);
+	bakCurrent = NULL;
+
+	if (bakBlocks.getCount() >= 2 * workers->getCount())
+		write_block();
+}
+
+void NBackup::write_block()
+{
+	BlockJob* const block = bakBlocks[0];
+	bakBlocks.remove((FB_SIZE_T) 0);
+	workers->wait(block);
+	bakSpare.add(block);
+
+	block_header header;
+	header.length = block->length;
+	header.packed_length = block->packedLength;
+	write_file(backup, &header, sizeof(header));
+
+	if (block->packedLength == block->length)
+		write_file(backup, block->data.begin(), block->length);
+	else
+		write_file(backup, block->packed.begin(), block->packedLength);
+}
+
+void NBackup::flush_backup()
+{
+	if (!bakCompressed)
+		return;
+
+	if (bakCurrent && bakPosition)
+		queue_block();
+
+	while (bakBlocks.hasData())
+		write_block();
+}
+
+FB_SIZE_T NBackup::read_backup(void* buffer, FB_SIZE_T bufsize)
+{
+	if (!bakStarted)
+	{
+		bakStarted = true;
+
+		// Compressed backup is recognized by its header, otherwise
+		// the bytes read are the start of regular backup
+
+		compressed_header header;
+		const FB_SIZE_T length = read_file(backup, &header, sizeof(header));
+
+		if (length == sizeof(header) &&
+			!memcmp(header.signature, compressed_signature, sizeof(compressed_signature)))
+		{
+			if (header.version != COMPRESSED_VERSION)
+			{
+				status_exception::raise(Arg::Gds(isc_nbackup_unsupvers_incbk) <<
+										Arg::Num(header.version) << bakname.c_str());
+			}
+
+			if (!header.block_size || header.block_size > MAX_COMPRESSED_BLOCK_SIZE)
+				raise_corrupted();
+
+			bakCompressed = true;
+			bakBlockSize = header.block_size;
+			start_workers();
+		}
+		else
+			bakPrefix.assign(reinterpret_cast<const UCHAR*>(&header), length);
+	}
+
+	UCHAR* data = static_cast<UCHAR*>(buffer);
+	FB_SIZE_T rc = 0;
+
+	if (!bakCompressed)
+	{
+		if (bakPosition < bakPrefix.getCount())
+		{
+			const FB_SIZE_T length = MIN(bufsize, bakPrefix.getCount() - bakPosition);
+			memcpy(data, bakPrefix.begin() + bakPosition, length);
+			bakPosition += length;
+			data += length;
+			bufsize -= length;
+			rc = length;
+		}
+
+		return bufsize ? rc + read_file(backup, data, bufsize) : rc;
+	}
+
+	while (bufsize)
+	{
+		if (!bakCurrent || bakPosition == bakCurrent->length)
+		{
+			if (!next_block())
+				break;
+
+			continue;
+		}
+
+		const FB_SIZE_T length = MIN(bufsize, bakCurrent->length - bakPosition);
+		memcpy(data, bakCurrent->data.begin() + bakPosition, length);
+		bakPosition += length;
+		data += length;
+		bufsize -= length;
+		rc += length;
+	}
+
+	return rc;
+}
+
+bool NBackup::next_block()
+{
+	if (bakCurrent)
+	{
+		bakSpare.add(bakCurrent);
+		bakCurrent = NULL;
+	}
+
+	// Read blocks ahead to keep every thread busy unpacking them
+
+	while (!bakEof && bakBlocks.getCount() <= 2 * workers->getCount())
+	{
+		block_header header;
+		const FB_SIZE_T length = read_file(backup, &header, sizeof(header));
+
+		if (!length)
+		{
+			bakEof = true;
+			break;
+		}
+
+		if (length != sizeof(header))
+			status_exception::raise(Arg::Gds(isc_nbackup_err_eofbk) << bakname.c_str());
+
+		if (header.length > bakBlockSize || header.packed_length > header.length)
+			raise_corrupted();
+
+		BlockJob* const block = get_block(false);
+		bakBlocks.add(block);
+
+		block->length = header.length;
+		block->packedLength = header.packed_length;
+
+		if (read_file(backup, block->packed.begin(), block->packedLength) != block->packedLength)
+			status_exception::raise(Arg::Gds(isc_nbackup_err_eofbk) << bakname.c_str());
+
+		workers->start(block);
+	}
+
+	if (bakBlocks.isEmpty())
+		return false;
+
+	bakCurrent = bakBlocks[0];
+	bakBlocks.remove((FB_SIZE_T) 0);
+	bakPosition = 0;
+	workers->wait(bakCurrent);
+
+	if (bakCurrent->error)
+		raise_corrupted();
+
+	return true;
+}
+
 void NBackup::fixup_database(bool repl_seq, bool set_readonly)
 {
 	open_database_write();
@@ -1147,6 +1864,43 @@ void NBackup::unlock_database()
 	detach_database();
 }
 
+bool NBackup::read_page_map(ULONG page_size, ULONG prev_scn, Array<ULONG>& entries)
+{
+	// Load the map of changed pages maintained by the engine (TrackChangedPages).
+	// It's usable only if it contains all changes made since the previous level.
+
+	const PathName mapName = dbname + ".pagemap";
+
+	const int fd = os_utils::open(mapName.c_str(), O_RDONLY | O_BINARY);
+	if (fd < 0)
+		return false;
+
+	Ods::page_map_header header;
+
+	bool valid = ::read(fd, &header, sizeof(header)) == sizeof(header) &&
+		!memcmp(header.pmh_signature, Ods::PAGE_MAP_SIGNATURE, sizeof(header.pmh_signature)) &&
+		header.pmh_version == Ods::PAGE_MAP_VERSION1 &&
+		header.pmh_page_size == page_size / 1024 &&
+		header.pmh_pages_per_scn == Ods::pagesPerSCN(page_size) &&
+		header.pmh_scn <= prev_scn + 1;
+
+	if (valid)
+	{
+		const SINT64 fileSize = os_utils::lseek(fd, 0, SEEK_END);
+		const FB_SIZE_T count = fileSize > (SINT64) sizeof(header) ?
+			(fileSize - sizeof(header)) / sizeof(ULONG) : 0;
+		const int length = count * sizeof(ULONG);
+
+		ULONG* const buffer = entries.getBuffer(count);
+
+		valid = os_utils::lseek(fd, sizeof(header), SEEK_SET) == sizeof(header) &&
+			(!length || ::read(fd, buffer, length) == length);
+	}
+
+	::close(fd);
+	return valid;
+}
+
 void NBackup::backup_database(int level, Guid& guid, const PathName& fname)
 {
 	bool database_locked = false;
@@ -1368,7 +2122,7 @@ void NBackup::backup_database(int level, Guid& guid, const PathName& fname)
 
 			memset(page_buff, 0, header->hdr_page_size);
 			memcpy(page_buff, &bh, sizeof(bh));
-			write_file(backup, page_buff, header->hdr_page_size);
+			write_backup(page_buff, header->hdr_page_size);
 			page_writes++;
 
 			seek_file(dbase, 0);
@@ -1390,6 +2144,21 @@ void NBackup::backup_database(int level, Guid& guid, const PathName& fname)
 			scns_buf = reinterpret_cast<Ods::scns_page*>(FB_ALIGN(buf, SECTOR_ALIGNMENT));
 		}
 
+		// Map of changed pages allows to skip whole ranges of pages described
+		// by SCN pages without reading them and their SCN pages
+		Array<ULONG> pageMap;
+		const bool usePageMap = level && read_page_map(header->hdr_page_size, prev_scn, pageMap);
+		bool skipRange = false;
+
+		// Level 0 backup reads the whole database sequentially, let the
+		// background threads read it ahead in parallel
+		AutoPtr<ReadAhead> readAhead;
+		if (!level && parallel > 1)
+		{
+			start_workers();
+			readAhead = FB_NEW ReadAhead(*workers, dbase, header->hdr_page_size);
+		}
+
 		while (true)
 		{
 			if (curPage && page_buff->pag_scn > backup_scn)
@@ -1400,7 +2169,7 @@ void NBackup::backup_database(int level, Guid& guid, const PathName& fname)
 
 			if (!level || page_buff->pag_scn > prev_scn)
 			{
-				write_file(backup, page_buff, header->hdr_page_size);
+				write_backup(page_buff, header->hdr_page_size);
 				page_writes++;
 			}
 
@@ -1421,6 +2190,29 @@ void NBackup::backup_database(int level, Guid& guid, const PathName& fname)
 				{
 					curPage++;
 					scnsSlot++;
+
+					if (usePageMap && scnsSlot == pagesPerSCN)
+					{
+						// Next range of pages is started, missing entry means no changes
+						const ULONG sequence = curPage / pagesPerSCN;
+
+						scnsSlot = 0;
+						scns = NULL;
+						skipRange = (sequence >= pageMap.getCount() || pageMap[sequence] <= prev_scn);
+					}
+
+					if (skipRange)
+					{
+						// Pointer pages still should be read to know the number of used pages
+						if (curPage == lastPage)
+						{
+							seek_file(dbase, (SINT64) curPage * header->hdr_page_size);
+							break;
+						}
+
+						continue;
+					}
+
 					if (!scns || scns->scn_pages[scnsSlot] > prev_scn ||
 						scnsSlot == pagesPerSCN ||
 						curPage == nextSCN ||
@@ -1445,7 +2237,20 @@ void NBackup::backup_database(int level, Guid& guid, const PathName& fname)
 				curPage++;
 
 
-			const FB_SIZE_T bytesDone = read_file(dbase, page_buff, header->hdr_page_size);
+			FB_SIZE_T bytesDone;
+			if (readAhead)
+			{
+				int error = 0;
+				bytesDone = readAhead->read(curPage, page_buff, error);
+				if (error)
+				{
+					status_exception::raise(Arg::Gds(isc_nbackup_err_read) << dbname.c_str() <<
+											Arg::OsError(error));
+				}
+			}
+			else
+				bytesDone = read_file(dbase, page_buff, header->hdr_page_size);
+
 			--db_size;
 			page_reads++;
 			if (bytesDone == 0)
@@ -1488,6 +2293,8 @@ void NBackup::backup_database(int level, Guid& guid, const PathName& fname)
 				}
 			}
 		}
+		readAhead.reset();
+		flush_backup();
 		close_database();
 		close_backup();
 
@@ -1683,7 +2490,7 @@ void NBackup::restore_database(const BackupFiles& files, bool repl_seq, bool inc
 			if (curLevel)
 			{
 				inc_header bakheader;
-				if (read_file(backup, &bakheader, sizeof(bakheader)) != sizeof(bakheader))
+				if (read_backup(&bakheader, sizeof(bakheader)) != sizeof(bakheader))
 					status_exception::raise(Arg::Gds(isc_nbackup_err_eofhdrbk) << bakname.c_str());
 				if (memcmp(bakheader.signature, backup_signature, sizeof(backup_signature)) != 0)
 					status_exception::raise(Arg::Gds(isc_nbackup_invalid_incbk) << bakname.c_str());
@@ -1708,7 +2515,7 @@ void NBackup::restore_database(const BackupFiles& files, bool repl_seq, bool inc
 				{
 					char char_buf[1024];
 					FB_SIZE_T step = left > sizeof(char_buf) ? sizeof(char_buf) : left;
-					if (read_file(backup, &char_buf, step) != step)
+					if (read_backup(&char_buf, step) != step)
 						status_exception::raise(Arg::Gds(isc_nbackup_err_eofhdrbk) << bakname.c_str());
 					left -= step;
 				}
@@ -1719,7 +2526,7 @@ void NBackup::restore_database(const BackupFiles& files, bool repl_seq, bool inc
 				const auto page_ptr = page_buffer.begin();
 				while (true)
 				{
-					const FB_SIZE_T bytesDone = read_file(backup, page_ptr, bakheader.page_size);
+					const FB_SIZE_T bytesDone = read_backup(page_ptr, bakheader.page_size);
 					if (bytesDone == 0)
 						break;
 					if (bytesDone != bakheader.page_size) {
@@ -1740,7 +2547,7 @@ void NBackup::restore_database(const BackupFiles& files, bool repl_seq, bool inc
 					char buffer[65536];
 					while (true)
 					{
-						const FB_SIZE_T bytesRead = read_file(backup, buffer, sizeof(buffer));
+						const FB_SIZE_T bytesRead = read_backup(buffer, sizeof(buffer));
 						if (bytesRead == 0)
 							break;
 						write_file(dbase, buffer, bytesRead);
@@ -1860,6 +2667,8 @@ void nbackup(UtilSvc* uSvc)
 	int level = -1;
 	Guid guid;
 	bool print_size = false, version = false, inc_rest = false, repl_seq = false;
+	bool compress = false;
+	unsigned parallel = 1;
 	string onOff;
 
 	const Switches switches(nbackup_action_in_sw_table, FB_NELEM(nbackup_action_in_sw_table),
@@ -2044,6 +2853,19 @@ void nbackup(UtilSvc* uSvc)
 			repl_seq = true;
 			break;
 
+		case IN_SW_NBK_PARALLEL:
+			if (++itr >= argc)
+				missingParameterForSwitch(uSvc, argv[itr - 1]);
+
+			parallel = atoi(argv[itr]);
+			if (parallel < 1 || parallel > MAX_PARALLEL)
+				usage(uSvc, isc_nbackup_unknown_param, argv[itr]);
+			break;
+
+		case IN_SW_NBK_COMPRESS:
+			compress = true;
+			break;
+
 		default:
 			usage(uSvc, isc_nbackup_unknown_switch, argv[itr]);
 			break;
@@ -2074,7 +2896,8 @@ void nbackup(UtilSvc* uSvc)
 		usage(uSvc, isc_nbackup_seq_misuse);
 	}
 
-	NBackup nbk(uSvc, database, username, role, password, run_db_triggers, direct_io, decompress);
+	NBackup nbk(uSvc, database, username, role, password, run_db_triggers, direct_io, decompress,
+		parallel, compress);
 	try
 	{
 		switch (op)
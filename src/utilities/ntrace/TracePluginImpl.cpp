@@ -508,6 +508,29 @@ void TracePluginImpl::appendGlobalCounts(const PerformanceInfo* info)
 		record.append(temp);
 	}
 
+	static const struct
+	{
+		int counter;
+		const char* name;
+	} waits[] =
+	{
+		{PerformanceInfo::LATCH_WAITS, "latch"},
+		{PerformanceInfo::LOCK_WAITS, "lock"},
+		{PerformanceInfo::READ_WAITS, "read"},
+		{PerformanceInfo::WRITE_WAITS, "write"}
+	};
+
+	for (unsigned i = 0; i < FB_NELEM(waits); i++)
+	{
+		// Wait time follows the number of waits, it's in microseconds
+		if ((cnt = info->pin_counters[waits[i].counter]) != 0)
+		{
+			temp.printf(", %" QUADFORMAT"d %s wait(s) %" QUADFORMAT"d us",
+				cnt, waits[i].name, info->pin_counters[waits[i].counter + 1]);
+			record.append(temp);
+		}
+	}
+
 	record.append(NEWLINE);
 }
 